@@ -0,0 +1,341 @@
+#include "ssvl.h"
+#include "bench_scenes.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// Offline benchmark: synthetic stereo pairs with known disparities, every combination of
+// the sizes, window dimensions and disparity ranges below, processed `iterations` times
+// each with the same settings. Stage times come from the callbacks `ssvl_process` makes
+// between stages:
+//  * gray: grayscale conversion (and pyramid levels), until `on_grayscale_cb`
+//  * search: census descriptors, disparity search and aggregation, until `on_disparity_cb`
+//  * depth: disparities to depths (and points with `-p`), until `on_depth_cb`
+//
+// Usage: bench [-i iterations] [-t threads] [-s output stride] [-g] [-r] [-p dense|compact|voxel] [-m sad|census|cost_volume|sgm|pyramid|temporal]
+//
+// `-s` sets `output_stride` (0, the default, is one cell per window), windows smaller than it are skipped.
+// `-g` searches with the generic batched comparers instead of the ones specialized for the window
+// dimensions (see `SSVL_SPECIALIZE_WINDOW`), to compare against. `-r` rectifies the frames while
+// converting them (see `ssvl_config_t.rectify`) with the calibration of the ideal cameras the scenes
+// are made for, so the disparities don't change and gray shows what the remap costs. `-p` also
+// reprojects the depths to points (see `ssvl_config_t.point_cloud`, voxels of `BENCH_VOXEL_SIZE_MM`)
+
+static const uint16_t bench_sizes[][2] = {{320, 240}, {640, 480}, {1280, 720}};
+static const uint8_t bench_windows[] = {4, 5, 8, 16};
+static const uint16_t bench_max_disparities[] = {32, 64, 128};
+
+#define BENCH_SIZE_COUNT (sizeof(bench_sizes) / sizeof(bench_sizes[0]))
+
+#define BENCH_VOXEL_SIZE_MM 50.0f
+#define BENCH_WINDOW_COUNT (sizeof(bench_windows) / sizeof(bench_windows[0]))
+#define BENCH_RANGE_COUNT (sizeof(bench_max_disparities) / sizeof(bench_max_disparities[0]))
+
+// Cells further off than this from the ground truth count as bad
+#define BENCH_BAD_THRESHOLD 1.0f
+
+
+// Timestamps taken by the callbacks during one `ssvl_process`
+typedef struct bench_frame_t{
+    double gray_end;
+    double search_end;
+    double depth_start;
+    double depth_end;
+    float *disparities;                         // Copy of the disparity buffer from `on_disparity_cb`
+}bench_frame_t;
+
+
+static void on_grayscale_cb(void *grayscale_opaque_ptr, ssvl_camera_side side, ssvl_gray_t *grayscale_frame_buffer, uint16_t pixel_width, uint16_t pixel_height){
+    bench_frame_t *frame = (bench_frame_t*)grayscale_opaque_ptr;
+    (void)grayscale_frame_buffer;
+    (void)pixel_width;
+    (void)pixel_height;
+
+    if(side == SSVL_RIGHT_CAMERA){
+        frame->gray_end = bench_now_ms();
+    }
+}
+
+
+static void on_disparity_cb(void *disparity_opaque_ptr, float *disparity_buffer, uint16_t disparity_width, uint16_t disparity_height){
+    bench_frame_t *frame = (bench_frame_t*)disparity_opaque_ptr;
+
+    frame->search_end = bench_now_ms();
+    memcpy(frame->disparities, disparity_buffer, disparity_width * disparity_height * sizeof(float));
+    frame->depth_start = bench_now_ms();
+}
+
+
+static void on_depth_cb(void *depth_opaque_ptr, float *disparity_depth_buffer, uint16_t depth_width, uint16_t depth_height, float max_depth_mm){
+    bench_frame_t *frame = (bench_frame_t*)depth_opaque_ptr;
+    (void)disparity_depth_buffer;
+    (void)depth_width;
+    (void)depth_height;
+    (void)max_depth_mm;
+
+    frame->depth_end = bench_now_ms();
+}
+
+
+// Percentage of cells off by more than `BENCH_BAD_THRESHOLD` from the disparity at their centre. Only cells
+// whose window has a match in the right image and doesn't straddle a depth edge are counted (`counted_cells`)
+static float bench_bad_percent(const bench_pair_t *pair, const float *disparities, uint8_t window, uint8_t stride, uint32_t *counted_cells){
+    const uint16_t depth_width = (pair->width - window) / stride + 1;
+    const uint16_t depth_height = (pair->height - window) / stride + 1;
+    uint32_t bad_cells = 0;
+
+    *counted_cells = 0;
+
+    for(uint16_t cell_y=0; cell_y<depth_height; cell_y++){
+        for(uint16_t cell_x=0; cell_x<depth_width; cell_x++){
+            const uint16_t x = cell_x * stride;
+            const uint16_t y = cell_y * stride;
+            const uint16_t truth = pair->disparities[(y + window/2)*pair->width + x + window/2];
+            bool counted = true;
+
+            for(uint16_t wy=0; wy<window && counted; wy++){
+                for(uint16_t wx=0; wx<window && counted; wx++){
+                    const uint16_t disparity = pair->disparities[(y + wy)*pair->width + x + wx];
+                    counted = disparity <= x && abs((int32_t)disparity - (int32_t)truth) <= 1;
+                }
+            }
+
+            if(counted == false){
+                continue;
+            }
+
+            const float found = disparities[cell_y*depth_width + cell_x];
+
+            (*counted_cells)++;
+
+            if(found < 0.0f || found > truth + BENCH_BAD_THRESHOLD || found < truth - BENCH_BAD_THRESHOLD){
+                bad_cells++;
+            }
+        }
+    }
+
+    return (*counted_cells > 0) ? 100.0f * bad_cells / *counted_cells : 0.0f;
+}
+
+
+// Window costs a full search scores for a frame: every cell tries each disparity of the active
+// range that keeps its window inside the right image. Searches that score fewer (pyramid,
+// temporal) are reported against this same count
+static double bench_disparity_evaluations(ssvl_t *ssvl){
+    double evaluations = 0.0;
+
+    for(uint16_t cell_x=0; cell_x<ssvl->depth_width; cell_x++){
+        const uint32_t x = cell_x * ssvl->cell_stride;
+        const uint32_t highest = (ssvl->active_max_disparity < x) ? ssvl->active_max_disparity : x;
+
+        if(highest >= ssvl->active_min_disparity){
+            evaluations += highest - ssvl->active_min_disparity + 1;
+        }
+    }
+
+    return evaluations * ssvl->depth_height;
+}
+
+
+static void bench_print_usage(void){
+    printf("Usage: bench [-i iterations] [-t threads] [-s output stride] [-g] [-r] [-p dense|compact|voxel] [-m sad|census|cost_volume|sgm|pyramid|temporal]\n");
+}
+
+
+// Distortion-free cameras `fov_degrees` wide, side by side `baseline_mm` apart: the pair `bench_generate_*` makes
+static void bench_ideal_calibration(ssvl_stereo_calibration_t *calibration, uint16_t width, uint16_t height, float baseline_mm, float fov_degrees){
+    memset(calibration, 0, sizeof(ssvl_stereo_calibration_t));
+
+    for(uint8_t side=0; side<2; side++){
+        ssvl_camera_intrinsics_t *camera = &calibration->cameras[side];
+        camera->fx = ((float)width*0.5f) / tanf(fov_degrees * 0.5f * 3.141593f/180.0f);
+        camera->fy = camera->fx;
+        camera->cx = (width - 1) * 0.5f;
+        camera->cy = (height - 1) * 0.5f;
+    }
+
+    calibration->rotation[0] = 1.0f;
+    calibration->rotation[4] = 1.0f;
+    calibration->rotation[8] = 1.0f;
+    calibration->translation[0] = -baseline_mm;
+}
+
+
+int main(int argc, char* argv[]){
+    uint32_t iterations = 5;
+    uint8_t thread_count = 1;
+    uint8_t output_stride = 0;
+    bool generic_comparers = false;
+    bool rectify = false;
+    const char *points = NULL;
+    const char *mode = "sad";
+
+    for(int i=1; i<argc; i++){
+        if(strcmp(argv[i], "-i") == 0 && i+1 < argc){
+            iterations = (uint32_t)atoi(argv[++i]);
+        }else if(strcmp(argv[i], "-t") == 0 && i+1 < argc){
+            thread_count = (uint8_t)atoi(argv[++i]);
+        }else if(strcmp(argv[i], "-s") == 0 && i+1 < argc){
+            output_stride = (uint8_t)atoi(argv[++i]);
+        }else if(strcmp(argv[i], "-g") == 0){
+            generic_comparers = true;
+        }else if(strcmp(argv[i], "-r") == 0){
+            rectify = true;
+        }else if(strcmp(argv[i], "-p") == 0 && i+1 < argc){
+            points = argv[++i];
+        }else if(strcmp(argv[i], "-m") == 0 && i+1 < argc){
+            mode = argv[++i];
+        }else{
+            bench_print_usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if(iterations == 0) iterations = 1;
+
+    const bool census = strcmp(mode, "census") == 0;
+    const bool cost_volume = strcmp(mode, "cost_volume") == 0;
+    const bool sgm = strcmp(mode, "sgm") == 0;
+    const bool pyramid = strcmp(mode, "pyramid") == 0;
+    const bool temporal = strcmp(mode, "temporal") == 0;
+
+    if(strcmp(mode, "sad") != 0 && !census && !cost_volume && !sgm && !pyramid && !temporal){
+        bench_print_usage();
+        return EXIT_FAILURE;
+    }
+
+    ssvl_point_cloud_mode point_cloud = SSVL_POINT_CLOUD_OFF;
+
+    if(points != NULL){
+        if(strcmp(points, "dense") == 0) point_cloud = SSVL_POINT_CLOUD_DENSE;
+        else if(strcmp(points, "compact") == 0) point_cloud = SSVL_POINT_CLOUD_COMPACT;
+        else if(strcmp(points, "voxel") == 0) point_cloud = SSVL_POINT_CLOUD_VOXEL;
+        else{
+            bench_print_usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("mode %s, %u iterations, %u threads, %s grayscale, output stride %u, %s comparers%s%s%s\n", mode, iterations, thread_count,
+           (sizeof(ssvl_gray_t) == 1) ? "8-bit" : "16-bit", output_stride, generic_comparers ? "generic" : "specialized", rectify ? ", rectified" : "",
+           (points != NULL) ? ", points " : "", (points != NULL) ? points : "");
+    printf("%-12s %9s %3s %5s | %8s %7s | %7s %7s | %9s %7s %9s | %8s %7s | %6s\n",
+           "scene", "size", "win", "range", "frame ms", "MP/s", "gray ms", "MP/s", "search ms", "MP/s", "Mevals/s", "depth ms", "MP/s", "bad %");
+
+    for(uint32_t size_index=0; size_index<BENCH_SIZE_COUNT; size_index++){
+        bench_pair_t pair;
+        pair.width = bench_sizes[size_index][0];
+        pair.height = bench_sizes[size_index][1];
+        pair.left = (uint8_t*)malloc(pair.width * pair.height);
+        pair.right = (uint8_t*)malloc(pair.width * pair.height);
+        pair.disparities = (uint16_t*)malloc(pair.width * pair.height * sizeof(uint16_t));
+
+        const double megapixels = pair.width * pair.height / 1000000.0;
+
+        for(uint32_t scene=0; scene<BENCH_SCENE_COUNT; scene++){
+            for(uint32_t range_index=0; range_index<BENCH_RANGE_COUNT; range_index++){
+                const uint16_t max_disparity = bench_max_disparities[range_index];
+
+                bench_generate_left(&pair, (bench_scene)scene, max_disparity);
+                bench_generate_right(&pair);
+
+                for(uint32_t window_index=0; window_index<BENCH_WINDOW_COUNT; window_index++){
+                    const uint8_t window = bench_windows[window_index];
+                    const uint8_t stride = (output_stride == 0) ? window : output_stride;
+
+                    if(stride > window){
+                        continue;
+                    }
+
+                    ssvl_config_t config;
+                    ssvl_config_init(&config, pair.width, pair.height, window, 60.0f, 70.0f);
+                    config.input_format = SSVL_FORMAT_GRAY8;
+                    config.max_disparity = max_disparity;
+                    config.thread_count = thread_count;
+                    config.census = census;
+                    config.sgm = sgm ? SSVL_SGM_8_PATHS : SSVL_SGM_OFF;
+                    config.pyramid_levels = pyramid ? 3 : 1;
+                    config.temporal = temporal;
+                    config.output_stride = output_stride;
+                    config.rectify = rectify;
+                    config.point_cloud = point_cloud;
+                    config.voxel_size_mm = BENCH_VOXEL_SIZE_MM;
+                    bench_ideal_calibration(&config.calibration, pair.width, pair.height, config.baseline_mm, config.fov_degrees);
+
+                    ssvl_t ssvl;
+                    if(!ssvl_init_with_config(&ssvl, &config)){
+                        printf("ERROR: %d\n", ssvl_get_status_code(&ssvl));
+                        continue;
+                    }
+
+                    if(cost_volume){
+                        ssvl_set_search_engine(&ssvl, SSVL_ENGINE_COST_VOLUME);
+                    }
+
+                    if(generic_comparers){
+                        ssvl_set_multi_comparers(&ssvl, ssvl_sad_multi_comparer, ssvl_census_multi_comparer);
+                    }
+
+                    bench_frame_t frame;
+                    frame.disparities = (float*)malloc(ssvl.depth_cell_count * sizeof(float));
+
+                    ssvl_set_on_grayscale_cb(&ssvl, on_grayscale_cb, &frame);
+                    ssvl_set_on_disparity_cb(&ssvl, on_disparity_cb, &frame);
+                    ssvl_set_on_depth_cb(&ssvl, on_depth_cb, &frame);
+
+                    const double evaluations = bench_disparity_evaluations(&ssvl);
+                    double frame_ms = 0.0;
+                    double gray_ms = 0.0;
+                    double search_ms = 0.0;
+                    double depth_ms = 0.0;
+
+                    // The first frame warms up caches and the thread pool (and gives temporal a previous frame)
+                    for(uint32_t iteration=0; iteration<=iterations; iteration++){
+                        const double start = bench_now_ms();
+
+                        ssvl_process_frames(&ssvl, pair.left, pair.right, 0, NULL);
+
+                        // Leaving out the time `on_disparity_cb` spends copying the disparities
+                        if(iteration > 0){
+                            frame_ms += (frame.depth_end - start) - (frame.depth_start - frame.search_end);
+                            gray_ms += frame.gray_end - start;
+                            search_ms += frame.search_end - frame.gray_end;
+                            depth_ms += frame.depth_end - frame.depth_start;
+                        }
+                    }
+
+                    frame_ms /= iterations;
+                    gray_ms /= iterations;
+                    search_ms /= iterations;
+                    depth_ms /= iterations;
+
+                    uint32_t counted_cells;
+                    const float bad_percent = bench_bad_percent(&pair, frame.disparities, window, stride, &counted_cells);
+
+                    char size[16];
+                    snprintf(size, sizeof(size), "%ux%u", pair.width, pair.height);
+
+                    printf("%-12s %9s %3u %5u | %8.2f %7.1f | %7.2f %7.1f | %9.2f %7.1f %9.0f | %8.3f %7.0f | %6.2f\n",
+                           bench_scene_names[scene], size, window, max_disparity,
+                           frame_ms, megapixels / (frame_ms / 1000.0),
+                           gray_ms, megapixels / (gray_ms / 1000.0),
+                           search_ms, megapixels / (search_ms / 1000.0), evaluations / 1000000.0 / (search_ms / 1000.0),
+                           depth_ms, megapixels / (depth_ms / 1000.0),
+                           bad_percent);
+
+                    free(frame.disparities);
+                    ssvl_destroy(&ssvl);
+                }
+            }
+        }
+
+        free(pair.left);
+        free(pair.right);
+        free(pair.disparities);
+    }
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include "ssvl.hpp"
+#include "bench_scenes.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+
+// Overhead of `ssvl::StereoMatcher` over the C API: the same frames processed through an `ssvl_t`
+// with a C callback and through a matcher with a lambda, turn about, `iterations` times each.
+// Reports the fastest frame of each (the least disturbed by everything else running) and checks
+// both give the same depths.
+//
+// Usage: bench_cpp [-i iterations] [-t threads]
+
+static const uint16_t bench_sizes[][2] = {{320, 240}, {640, 480}, {1280, 720}};
+static const uint8_t bench_windows[] = {4, 8, 16};
+
+#define BENCH_SIZE_COUNT (sizeof(bench_sizes) / sizeof(bench_sizes[0]))
+#define BENCH_WINDOW_COUNT (sizeof(bench_windows) / sizeof(bench_windows[0]))
+
+#define BENCH_MAX_DISPARITY 64
+
+
+// The work both callbacks do: sum the depths so they're read
+static void on_depth_cb(void *depth_opaque_ptr, float *disparity_depth_buffer, uint16_t depth_width, uint16_t depth_height, float max_depth_mm){
+    double *sum = (double*)depth_opaque_ptr;
+    (void)max_depth_mm;
+
+    for(uint32_t i=0; i<(uint32_t)depth_width*depth_height; i++){
+        *sum += disparity_depth_buffer[i];
+    }
+}
+
+
+static void bench_print_usage(void){
+    printf("Usage: bench_cpp [-i iterations] [-t threads]\n");
+}
+
+
+int main(int argc, char* argv[]){
+    uint32_t iterations = 20;
+    uint8_t thread_count = 1;
+
+    for(int i=1; i<argc; i++){
+        if(strcmp(argv[i], "-i") == 0 && i+1 < argc){
+            iterations = (uint32_t)atoi(argv[++i]);
+        }else if(strcmp(argv[i], "-t") == 0 && i+1 < argc){
+            thread_count = (uint8_t)atoi(argv[++i]);
+        }else{
+            bench_print_usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if(iterations == 0) iterations = 1;
+
+    printf("%u iterations, %u threads, %s grayscale, range %u\n", iterations, thread_count,
+           (sizeof(ssvl_gray_t) == 1) ? "8-bit" : "16-bit", BENCH_MAX_DISPARITY);
+    printf("%-12s %9s %3s | %8s %8s | %7s | %s\n", "scene", "size", "win", "C ms", "C++ ms", "C++/C", "depths");
+
+    for(uint32_t size_index=0; size_index<BENCH_SIZE_COUNT; size_index++){
+        bench_pair_t pair;
+        pair.width = bench_sizes[size_index][0];
+        pair.height = bench_sizes[size_index][1];
+
+        std::vector<uint8_t> left(pair.width * pair.height);
+        std::vector<uint8_t> right(pair.width * pair.height);
+        std::vector<uint16_t> disparities(pair.width * pair.height);
+        pair.left = left.data();
+        pair.right = right.data();
+        pair.disparities = disparities.data();
+
+        for(uint32_t scene=0; scene<BENCH_SCENE_COUNT; scene++){
+            bench_generate_left(&pair, (bench_scene)scene, BENCH_MAX_DISPARITY);
+            bench_generate_right(&pair);
+
+            for(uint32_t window_index=0; window_index<BENCH_WINDOW_COUNT; window_index++){
+                const uint8_t window = bench_windows[window_index];
+
+                ssvl_config_t config;
+                ssvl_config_init(&config, pair.width, pair.height, window, 60.0f, 70.0f);
+                config.input_format = SSVL_FORMAT_GRAY8;
+                config.max_disparity = BENCH_MAX_DISPARITY;
+                config.thread_count = thread_count;
+
+                ssvl_t ssvl;
+                if(!ssvl_init_with_config(&ssvl, &config)){
+                    printf("ERROR: %d\n", ssvl_get_status_code(&ssvl));
+                    continue;
+                }
+
+                double c_sum = 0.0;
+                ssvl_set_on_depth_cb(&ssvl, on_depth_cb, &c_sum);
+
+                ssvl::StereoMatcher matcher(config);
+                double cpp_sum = 0.0;
+                matcher.on_depth([&cpp_sum](ssvl::span<const float> depths, uint16_t depth_width, uint16_t depth_height, float max_depth_mm){
+                    (void)depth_width;
+                    (void)depth_height;
+                    (void)max_depth_mm;
+
+                    for(float depth : depths){
+                        cpp_sum += depth;
+                    }
+                });
+
+                double c_ms = 0.0;
+                double cpp_ms = 0.0;
+
+                // The first frame of each warms up caches and the thread pool
+                for(uint32_t iteration=0; iteration<=iterations; iteration++){
+                    const double c_start = bench_now_ms();
+                    ssvl_process_frames(&ssvl, pair.left, pair.right, 0, NULL);
+                    const double c_end = bench_now_ms();
+
+                    matcher.process_frames(left, right);
+                    const double cpp_end = bench_now_ms();
+
+                    if(iteration == 1 || (iteration > 1 && c_end - c_start < c_ms)) c_ms = c_end - c_start;
+                    if(iteration == 1 || (iteration > 1 && cpp_end - c_end < cpp_ms)) cpp_ms = cpp_end - c_end;
+                }
+
+                const bool same = c_sum == cpp_sum && memcmp(ssvl.disparity_depth_buffer, matcher.depths().data(), ssvl.disparity_depth_buffer_size) == 0;
+
+                char size[16];
+                snprintf(size, sizeof(size), "%ux%u", pair.width, pair.height);
+
+                printf("%-12s %9s %3u | %8.3f %8.3f | %7.3f | %s\n", bench_scene_names[scene], size, window,
+                       c_ms, cpp_ms, cpp_ms / c_ms, same ? "same" : "DIFFERENT");
+
+                ssvl_destroy(&ssvl);
+            }
+        }
+    }
+
+    return 0;
+}
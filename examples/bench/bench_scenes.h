@@ -0,0 +1,108 @@
+#ifndef BENCH_SCENES_H
+#define BENCH_SCENES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+
+// Synthetic stereo pairs with known disparities, shared by the benchmarks
+
+typedef enum bench_scene_enum {BENCH_SCENE_RANDOM_DOTS=0, BENCH_SCENE_SLANTED_PLANE=1, BENCH_SCENE_COUNT=2} bench_scene;
+static const char *bench_scene_names[] = {"random-dots", "slanted"};
+
+typedef struct bench_pair_t{
+    uint16_t width;
+    uint16_t height;
+    uint8_t *left;
+    uint8_t *right;
+    uint16_t *disparities;                      // Ground truth disparity of every left pixel
+}bench_pair_t;
+
+
+static uint32_t bench_random_state = 1;
+
+static uint32_t bench_random(void){
+    bench_random_state = bench_random_state * 1664525u + 1013904223u;
+    return bench_random_state >> 8;
+}
+
+
+static double bench_now_ms(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+
+// Left image textures and ground truth disparities:
+//  * random dots: independent random pixels, a background plane and two fronto-parallel boxes in front of it
+//  * slanted plane: smoothed random texture on a plane whose disparity grows across the image
+static void bench_generate_left(bench_pair_t *pair, bench_scene scene, uint16_t max_disparity){
+    const uint16_t width = pair->width;
+    const uint16_t height = pair->height;
+
+    for(uint32_t i=0; i<(uint32_t)width*height; i++){
+        pair->left[i] = bench_random() & 255;
+    }
+
+    if(scene == BENCH_SCENE_SLANTED_PLANE){
+        for(uint8_t pass=0; pass<2; pass++){
+            for(uint16_t y=0; y<height; y++){
+                for(uint16_t x=0; x+1<width; x++){
+                    uint8_t *pixel = &pair->left[y*width + x];
+                    pixel[0] = (pixel[0] + pixel[1] + 1) / 2;
+                }
+            }
+        }
+    }
+
+    for(uint16_t y=0; y<height; y++){
+        for(uint16_t x=0; x<width; x++){
+            float disparity;
+
+            if(scene == BENCH_SCENE_RANDOM_DOTS){
+                const bool near_box = x >= width/2 && x < width/2 + width/5 && y >= height/4 && y < height/2;
+                const bool far_box = x >= width/5 && x < width/5 + width/4 && y >= height/2 && y < height/2 + height/3;
+                disparity = near_box ? 0.9f*max_disparity : (far_box ? 0.55f*max_disparity : 0.25f*max_disparity);
+            }else{
+                disparity = max_disparity * (0.1f + 0.8f * (x + y/2.0f) / (width + height/2.0f));
+            }
+
+            pair->disparities[y*width + x] = (uint16_t)(disparity + 0.5f);
+        }
+    }
+}
+
+
+// Right image: every left pixel lands `disparity` pixels to the left, nearer surfaces (larger
+// disparities) hiding further ones, and pixels nothing lands on (occluded) get random values
+static void bench_generate_right(bench_pair_t *pair){
+    const uint16_t width = pair->width;
+    int32_t *nearest = (int32_t*)malloc(width * sizeof(int32_t));
+
+    for(uint16_t y=0; y<pair->height; y++){
+        uint8_t *right_row = pair->right + y*width;
+
+        for(uint16_t x=0; x<width; x++){
+            right_row[x] = bench_random() & 255;
+            nearest[x] = -1;
+        }
+
+        for(uint16_t x=0; x<width; x++){
+            const int32_t disparity = pair->disparities[y*width + x];
+            const int32_t right_x = x - disparity;
+
+            if(right_x >= 0 && disparity >= nearest[right_x]){
+                right_row[right_x] = pair->left[y*width + x];
+                nearest[right_x] = disparity;
+            }
+        }
+    }
+
+    free(nearest);
+}
+
+
+#endif  // BENCH_SCENES_H
@@ -77,7 +77,7 @@ int write_pgm(float *image_gray, uint16_t width, uint16_t height){
     }
 }
 
-void on_grayscale_cb(void *grayscale_opaque_ptr, ssvl_camera_side side, uint16_t *grayscale_frame_buffer, uint16_t pixel_width, uint16_t pixel_height){
+void on_grayscale_cb(void *grayscale_opaque_ptr, ssvl_camera_side side, ssvl_gray_t *grayscale_frame_buffer, uint16_t pixel_width, uint16_t pixel_height){
     printf("TEST0\n");
 }
 
@@ -14,20 +14,18 @@ using namespace godot;
 // Debug function that can be invoked by `ssvl` just
 // after the input feed frames are converted to grayscale.
 // This is just for debugging.
-void on_grayscale(void *grayscale_opaque_ptr, ssvl_camera_side side, uint16_t *grayscale_frame_buffer, uint16_t pixel_width, uint16_t pixel_height){
-	// Get the class instance back and make reference variables for
-	// texture and image for this side
-	CamNavDemoNode *instance = (CamNavDemoNode*)grayscale_opaque_ptr;
+void CamNavDemoNode::on_grayscale(ssvl_camera_side side, ssvl::span<const ssvl_gray_t> grayscale_frame_buffer, uint16_t pixel_width, uint16_t pixel_height){
+	// Make reference variables for texture and image for this side
 	godot::Ref<ImageTexture>    grayscale_texture;
     godot::Ref<Image>           grayscale_image;
 	
 	// Determine the side
 	if(side == SSVL_LEFT_CAMERA){
-		grayscale_texture = instance->left_grayscale_texture;
-		grayscale_image = instance->left_grayscale_image;
+		grayscale_texture = left_grayscale_texture;
+		grayscale_image = left_grayscale_image;
 	}else{
-		grayscale_texture = instance->right_grayscale_texture;
-		grayscale_image = instance->right_grayscale_image;
+		grayscale_texture = right_grayscale_texture;
+		grayscale_image = right_grayscale_image;
 	}
 
 	// For each incoming grayscale single component value
@@ -36,7 +34,7 @@ void on_grayscale(void *grayscale_opaque_ptr, ssvl_camera_side side, uint16_t *g
 	// pixel using that since output texture is 8-bit
 	for(uint16_t y=0; y<pixel_height; y++){
 		for(uint16_t x=0; x<pixel_width; x++){
-			float magnitude = (float)grayscale_frame_buffer[y*pixel_width + x] / (float)UINT16_MAX;
+			float magnitude = (float)grayscale_frame_buffer[y*pixel_width + x] / (float)SSVL_GRAY_MAX;
 			grayscale_image.ptr()->set_pixel(x, y, Color(magnitude, magnitude, magnitude));
 		}
 	}
@@ -46,13 +44,7 @@ void on_grayscale(void *grayscale_opaque_ptr, ssvl_camera_side side, uint16_t *g
 }
 
 
-void on_disparity(void *disparity_opaque_ptr, float *disparity_buffer, uint16_t disparity_width, uint16_t disparity_height){
-	// Get the class instance back and make reference variables for
-	// texture and image for this side
-	CamNavDemoNode *instance = (CamNavDemoNode*)disparity_opaque_ptr;
-	godot::Ref<ImageTexture>    disparity_texture = instance->disparity_texture;
-    godot::Ref<Image>           disparity_image = instance->disparity_image;
-
+void CamNavDemoNode::on_disparity(ssvl::span<const float> disparity_buffer, uint16_t disparity_width, uint16_t disparity_height){
 	// For each incoming grayscale single component value
 	// from `ssvl`, get it and convert it from 16-bit
 	// int luminance to 0.0 ~ 1.0 luminance and then set
@@ -69,20 +61,13 @@ void on_disparity(void *disparity_opaque_ptr, float *disparity_buffer, uint16_t
 }
 
 
-void on_depth(void *depth_opaque_ptr, float *depth_buffer, uint16_t depth_width, uint16_t depth_height, float max_depth_mm){
-	// Get the class instance back and make reference variables for
-	// texture and image for this side
-	CamNavDemoNode *instance = (CamNavDemoNode*)depth_opaque_ptr;
-	godot::Ref<ImageTexture>    depth_texture = instance->depth_texture;
-    godot::Ref<Image>           depth_image = instance->depth_image;
-
+void CamNavDemoNode::on_depth(ssvl::span<const float> depth_buffer, uint16_t depth_width, uint16_t depth_height, float max_depth_mm){
 	// For each incoming grayscale single component value
 	// from `ssvl`, get it and convert it from 16-bit
 	// int luminance to 0.0 ~ 1.0 luminance and then set
 	// pixel using that since output texture is 8-bit
 	for(uint16_t y=0; y<depth_width; y++){
 		for(uint16_t x=0; x<depth_height; x++){
-			float max_depth_mm = ssvl_get_max_depth_mm(instance->ssvl);
 			float depth_mm = (float)depth_buffer[y*depth_width + x];
 
 			if(depth_mm >= max_depth_mm){
@@ -272,16 +257,25 @@ void CamNavDemoNode::_ready(){
 	disparity_texture_rect->set_texture(disparity_texture);
 	depth_texture_rect->set_texture(depth_texture);
 
-	// Create the ssvl library instance
-	ssvl = ssvl_create(CAMERA_RESOLUTION, CAMERA_RESOLUTION, SEARCH_WINDOW_DIMENSIONS, baseline*1000.0f, left_camera->get_fov(), true);
+	// Create the ssvl library instance (freed with this node)
+	stereo_matcher = ssvl::StereoMatcher(CAMERA_RESOLUTION, CAMERA_RESOLUTION, SEARCH_WINDOW_DIMENSIONS, baseline*1000.0f, left_camera->get_fov());
 
-	if(ssvl == NULL){
+	if(!stereo_matcher){
 		UtilityFunctions::print("ERROR: Could not create ssvl library! Likely an issue with search window not being a multiple of the width or height of the camera!");
+		return;
 	}
 
-	ssvl_set_on_grayscale_cb(ssvl, on_grayscale, this);
-	ssvl_set_on_disparity_cb(ssvl, on_disparity, this);
-	ssvl_set_on_depth_cb(ssvl, on_depth, this);
+	stereo_matcher.on_grayscale([this](ssvl_camera_side side, ssvl::span<const ssvl_gray_t> grayscale_frame_buffer, uint16_t pixel_width, uint16_t pixel_height){
+		on_grayscale(side, grayscale_frame_buffer, pixel_width, pixel_height);
+	});
+
+	stereo_matcher.on_disparity([this](ssvl::span<const float> disparity_buffer, uint16_t disparity_width, uint16_t disparity_height){
+		on_disparity(disparity_buffer, disparity_width, disparity_height);
+	});
+
+	stereo_matcher.on_depth([this](ssvl::span<const float> depth_buffer, uint16_t depth_width, uint16_t depth_height, float max_depth_mm){
+		on_depth(depth_buffer, depth_width, depth_height, max_depth_mm);
+	});
 }
 
 
@@ -291,7 +285,7 @@ CamNavDemoNode::~CamNavDemoNode(){
 
 
 void CamNavDemoNode::_process(float delta){
-	if(Engine::get_singleton()->is_editor_hint()){
+	if(Engine::get_singleton()->is_editor_hint() || !stereo_matcher){
 		return;
 	}
 
@@ -306,11 +300,11 @@ void CamNavDemoNode::_process(float delta){
 	PackedByteArray right_byte_array = right_image.ptr()->get_data();
 
 	// Feed and process frames in `ssvl`
-	if(ssvl_feed(ssvl, SSVL_LEFT_CAMERA, left_byte_array.ptr(), left_byte_array.size()) == false){
+	if(stereo_matcher.feed(SSVL_LEFT_CAMERA, {left_byte_array.ptr(), (size_t)left_byte_array.size()}) == false){
 		UtilityFunctions::print("ERROR: Too much data for left ssvl eye!");
 	}
 
-	if(ssvl_feed(ssvl, SSVL_RIGHT_CAMERA, right_byte_array.ptr(), right_byte_array.size()) == false){
+	if(stereo_matcher.feed(SSVL_RIGHT_CAMERA, {right_byte_array.ptr(), (size_t)right_byte_array.size()}) == false){
 		UtilityFunctions::print("ERROR: Too much data for right ssvl eye!");
 	}
 }
@@ -34,7 +34,7 @@ inline void osprintf(const char *fmt, ...){
 
 #define SSVL_PRINTF osprintf
 
-#include "../../../simple_stereo_vision_lib.h"
+#include "../../../ssvl.hpp"
 
 
 
@@ -93,7 +93,12 @@ public:
     godot::Ref<ImageTexture>    depth_texture;
     godot::Ref<Image>           depth_image;
 
-    ssvl_t *ssvl = nullptr;
+    // Owns the `ssvl` instance, its buffers and the callbacks below
+    ssvl::StereoMatcher stereo_matcher;
+
+    void on_grayscale(ssvl_camera_side side, ssvl::span<const ssvl_gray_t> grayscale_frame_buffer, uint16_t pixel_width, uint16_t pixel_height);
+    void on_disparity(ssvl::span<const float> disparity_buffer, uint16_t disparity_width, uint16_t disparity_height);
+    void on_depth(ssvl::span<const float> depth_buffer, uint16_t depth_width, uint16_t depth_height, float max_depth_mm);
 
     // How many units apart are the stereo eye origins
     float baseline = 0.1f;
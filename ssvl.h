@@ -31,18 +31,519 @@
 #define SSVL_FUNC extern inline
 #endif
 
+// Same for the comparers, also inlined wherever they're called so that calls with a constant
+// `window_dimensions` get their loops unrolled (see `SSVL_SPECIALIZE_WINDOW`)
+#ifndef SSVL_KERNEL_FUNC
+    #if defined(__GNUC__) || defined(__clang__)
+        #define SSVL_KERNEL_FUNC SSVL_FUNC __attribute__((always_inline))
+    #else
+        #define SSVL_KERNEL_FUNC SSVL_FUNC
+    #endif
+#endif
+
 // NOTE: Use `#define SSVL_DEBUG` to enable printing, disabled by not being defined by default
 
+// SIMD kernels are picked at compile time from the instruction sets the
+// compiler is targeting (e.g. `-mavx2`, `-msse2`, or NEON on ARM). Use
+// `#define SSVL_NO_SIMD` to force the scalar reference paths everywhere
+#if !defined(SSVL_NO_SIMD)
+    #if defined(__AVX2__)
+        #define SSVL_AVX2
+        #define SSVL_SSE2
+        #include <immintrin.h>
+    #elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define SSVL_SSE2
+        #include <emmintrin.h>
+    #elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+        #define SSVL_NEON
+        #include <arm_neon.h>
+    #endif
+#endif
+
+// A pthreads worker pool is used by default for `ssvl_config_t.thread_count` > 1 on Linux.
+// Use `#define SSVL_NO_PTHREADS` to leave it out (e.g. when providing your own pool with
+// `ssvl_set_parallel_for`) or `#define SSVL_PTHREADS` to include it on other POSIX systems
+#if !defined(SSVL_NO_PTHREADS) && !defined(SSVL_PTHREADS) && defined(__linux__)
+    #define SSVL_PTHREADS
+#endif
+
+#if defined(SSVL_PTHREADS)
+    #include <pthread.h>
+#endif
+
+// Use `#define SSVL_STATS` to time every stage of a frame and count the work done (see
+// `ssvl_get_stats` and `ssvl_set_on_trace_cb`), left out by default. Stages are timed with
+// `SSVL_STATS_CLOCK_NS()`, a monotonic clock in nanoseconds: `clock_gettime(CLOCK_MONOTONIC)`
+// on POSIX systems, `clock()` (processor time) elsewhere unless defined to your own timer
+#if defined(SSVL_STATS)
+    #include <time.h>
+
+    #ifndef SSVL_STATS_CLOCK_NS
+        #if defined(CLOCK_MONOTONIC)
+            #define SSVL_STATS_CLOCK_NS() ssvl_stats_clock_ns()
+        #else
+            #define SSVL_STATS_CLOCK_NS() ((uint64_t)clock() * (1000000000ull / CLOCKS_PER_SEC))
+        #endif
+    #endif
+#endif
+
+// Every buffer the library uses is carved from one block of memory (see `ssvl_required_memory`),
+// each starting on a `SSVL_MEMORY_ALIGNMENT` byte boundary (a power of 2) for aligned SIMD loads
+// and so different workers' buffers never share a cache line
+#ifndef SSVL_MEMORY_ALIGNMENT
+    #define SSVL_MEMORY_ALIGNMENT 64
+#endif
+
+// Adaptive disparity range (see `ssvl_config_t.adaptive_disparity_range`) tuning:
+//  * SSVL_ADAPTIVE_RANGE_OUTLIER_PERCENT: percent of cells ignored at each end of the previous frame's disparity histogram
+//  * SSVL_ADAPTIVE_RANGE_MARGIN: disparities (pixels) added on both sides of what remains
+//  * SSVL_ADAPTIVE_RANGE_EDGE_PERCENT: if more than this percent of cells land on a bound of a narrowed
+//                                      range, something may be outside of it so the full range is searched
+#ifndef SSVL_ADAPTIVE_RANGE_OUTLIER_PERCENT
+#define SSVL_ADAPTIVE_RANGE_OUTLIER_PERCENT 1
+#endif
+
+#ifndef SSVL_ADAPTIVE_RANGE_MARGIN
+#define SSVL_ADAPTIVE_RANGE_MARGIN 4
+#endif
+
+#ifndef SSVL_ADAPTIVE_RANGE_EDGE_PERCENT
+#define SSVL_ADAPTIVE_RANGE_EDGE_PERCENT 5
+#endif
+
+// Fractional bits of the fixed-point grayscale weights, weighted sums stay below 2^31
+// with 15 and the result is within one LSB of `ssvl_convert_rgb565_to_grayscale`
+#define SSVL_GRAYSCALE_FRACTION_BITS 15
+
+// Grayscale frames are 16-bit (0 ~ 65535) by default. Use `#define SSVL_GRAY8` for 8-bit
+// grayscale (0 ~ 255): half the frame buffer memory and traffic, and SAD works on bytes
+// (16 or 32 candidates a SIMD instruction with 16-bit sums). Matching rarely needs more than
+// 8 bits of luminance. Changes `ssvl_gray_t`, the type of `frame_buffers` and of the buffers
+// given to comparers and `on_grayscale_cb`. Filling `frame_buffers` directly before
+// `ssvl_process` then only works for 1 byte `input_format`s
+#if defined(SSVL_GRAY8)
+    typedef uint8_t ssvl_gray_t;
+    #define SSVL_GRAY_MAX UINT8_MAX
+#else
+    typedef uint16_t ssvl_gray_t;
+    #define SSVL_GRAY_MAX UINT16_MAX
+#endif
+
+// Fractional bits of the fixed-point Bayer luma weights, small enough for the weights to
+// fit 16-bit multiplies (the output is still within a few LSBs of the exact weights)
+#if defined(SSVL_GRAY8)
+    #define SSVL_BAYER_FRACTION_BITS 15
+#else
+    #define SSVL_BAYER_FRACTION_BITS 8
+#endif
+
+// Fractional bits of the bilinear weights in the rectification maps (see `ssvl_remap_t`), 16-bit
+// grayscale times both weights still sums in 32 bits
+#define SSVL_REMAP_FRACTION_BITS 7
+
+// Source format of `ssvl_rectify_row` for frames `ssvl_feed` already converted to grayscale,
+// after the `ssvl_input_format`s
+#define SSVL_RECTIFY_GRAY_SOURCE 8
+
+// Census descriptors (see `ssvl_config_t.census`) compare a pixel with the rest of the
+// square this many pixels around it: 5x5, 24 bits of a `uint32_t`
+#define SSVL_CENSUS_RADIUS 2
+#define SSVL_CENSUS_DIMENSIONS (2*SSVL_CENSUS_RADIUS + 1)
+
+// Semi-global matching (see `ssvl_sgm_mode`) scales window costs down (by a power of two, saturating)
+// to at most `SSVL_SGM_COST_MAX` so 8 paths of costs plus penalties sum in `uint16_t`. Path buffers are
+// padded with `SSVL_SGM_PATH_SENTINEL`, larger than any path cost
+#define SSVL_SGM_COST_MAX 4095
+#define SSVL_SGM_PATH_SENTINEL 0x3FFF
+
+// Most levels `ssvl_config_t.pyramid_levels` can ask for
+#define SSVL_PYRAMID_MAX_LEVELS 8
+
+// Default `ssvl_config_t.temporal_max_cost` per window pixel: a mean |L-R| of a 16th of full
+// scale with SAD, 4 of the 24 descriptor bits differing with census
+#ifndef SSVL_TEMPORAL_SAD_PIXEL_COST
+#define SSVL_TEMPORAL_SAD_PIXEL_COST (SSVL_GRAY_MAX/16)
+#endif
+
+#ifndef SSVL_TEMPORAL_CENSUS_PIXEL_COST
+#define SSVL_TEMPORAL_CENSUS_PIXEL_COST 4
+#endif
+
+// Fewest candidates `ssvl_sad_multi_comparer` scores in a SIMD loop, the rest are scored one at a time
+#if defined(SSVL_SSE2) || defined(SSVL_NEON)
+    #define SSVL_SAD_SIMD_CANDIDATES 16
+#else
+    #define SSVL_SAD_SIMD_CANDIDATES 1
+#endif
+
+// Same for `ssvl_census_multi_comparer`
+#if defined(SSVL_AVX2)
+    #define SSVL_CENSUS_SIMD_CANDIDATES 8
+#elif defined(SSVL_NEON)
+    #define SSVL_CENSUS_SIMD_CANDIDATES 4
+#else
+    #define SSVL_CENSUS_SIMD_CANDIDATES 1
+#endif
+
+// Builds whose SAD gains from `SSVL_SPECIALIZE_WINDOW`: 8-bit sums are widened once per window
+// (and AVX2 uses `mpsadbw`), scalar loops unroll. 16-bit SIMD does the same work either way
+#if defined(SSVL_GRAY8) || SSVL_SAD_SIMD_CANDIDATES == 1
+    #define SSVL_SPECIALIZE_SAD
+#endif
+
+// Number of candidate windows scored per call to `ssvl_sad_multi_comparer`
+// from `ssvl_disparity_search` (costs live on the stack, 4 bytes each)
+#ifndef SSVL_SAD_BATCH
+#define SSVL_SAD_BATCH 256
+#endif
+
 
 // Used throughout library to refer to which camera to interact with
 typedef enum ssvl_camera_side_enum {SSVL_LEFT_CAMERA=0, SSVL_RIGHT_CAMERA=1} ssvl_camera_side;
 
 // Various types of errors set in library instance `.error`
-typedef enum ssvl_status_codes_enum {SSVL_STATUS_OK=0, SSVL_STATUS_FEED_OVERFLOW=1} ssvl_return_codes;
+typedef enum ssvl_status_codes_enum {SSVL_STATUS_OK=0, SSVL_STATUS_FEED_OVERFLOW=1, SSVL_STATUS_INVALID_CONFIG=2, SSVL_STATUS_STREAM_OVERRUN=3, SSVL_STATUS_INVALID_ARGUMENT=4, SSVL_STATUS_OUT_OF_MEMORY=5} ssvl_return_codes;
 
 // Just name `uint8_t` to status for tracking library errors in instance
 typedef uint8_t ssvl_status_t;
 
+// How `ssvl_process` searches for disparities:
+//  * SSVL_ENGINE_WINDOW_SEARCH: every depth cell scores each of its candidate windows with
+//                              `aggregate_pixel_comparer` (batched SIMD for `ssvl_sad_comparer`)
+//  * SSVL_ENGINE_COST_VOLUME: one disparity at a time for a whole row of depth cells, |L-R| is
+//                            summed down each column of the row's band once and window costs
+//                            are built from those column sums. Only used with `ssvl_sad_comparer`
+//                            and `ssvl_census_comparer`, otherwise falls back to SSVL_ENGINE_WINDOW_SEARCH
+//
+// Both produce identical disparities. With one depth cell per `search_window_dimensions` block
+// no two windows share a |L-R| term so both do the same amount of arithmetic; the window search
+// keeps fewer values live and is the default. With a smaller `output_stride` neighbouring windows
+// overlap and the cost volume shares their column sums, so it's used whatever the engine is (except
+// where each cell searches its own range: temporal and pyramid)
+typedef enum ssvl_search_engine_enum {SSVL_ENGINE_WINDOW_SEARCH=0, SSVL_ENGINE_COST_VOLUME=1} ssvl_search_engine;
+
+// Semi-global matching (`ssvl_config_t.sgm`): instead of every depth cell taking its cheapest
+// disparity on its own, cell costs for the searched disparities (a `uint16_t` cost volume with an
+// entry per cell per disparity in the configured range) are aggregated along straight paths of
+// cells, penalizing neighbours whose disparities differ by one (`sgm_p1`) or more (`sgm_p2`), and
+// each cell takes the disparity with the smallest sum over all paths. Cleans up noisy cells on
+// surfaces with little texture. Costs come from column sums like `SSVL_ENGINE_COST_VOLUME`
+// (`search_engine` is ignored):
+//  * SSVL_SGM_OFF: winner-take-all per cell (default)
+//  * SSVL_SGM_4_PATHS: left, right, up and down, keeps the costs and sums of the whole volume
+//  * SSVL_SGM_8_PATHS: plus the 4 diagonals
+//  * SSVL_SGM_SINGLE_PASS: left, right and the 3 paths coming from the row above. Each row of
+//                          cells is finished as soon as it's searched so only a row of costs
+//                          and sums is kept, the only mode that works with `streaming`
+typedef enum ssvl_sgm_mode_enum {SSVL_SGM_OFF=0, SSVL_SGM_4_PATHS=1, SSVL_SGM_8_PATHS=2, SSVL_SGM_SINGLE_PASS=3} ssvl_sgm_mode;
+
+// With a cell mask (see `ssvl_set_cell_mask`), how far along the rows of a grayscale task or the
+// descriptors of a census band are in the current frame
+typedef enum ssvl_rows_state_enum {SSVL_ROWS_SKIPPED=0, SSVL_ROWS_WANTED=1, SSVL_ROWS_READY=2} ssvl_rows_state;
+
+// What an asynchronous pipeline (`ssvl_config_t.async_slots`) does when a new frame starts being
+// fed but every slot is holding a frame waiting to be processed or being processed:
+//  * SSVL_ASYNC_DROP_OLDEST: the oldest waiting frame is dropped and its slot is filled instead,
+//                            so the newest frames are always the ones processed (default)
+//  * SSVL_ASYNC_BLOCK: `ssvl_feed` waits until the processing thread frees a slot
+typedef enum ssvl_async_policy_enum {SSVL_ASYNC_DROP_OLDEST=0, SSVL_ASYNC_BLOCK=1} ssvl_async_policy;
+
+// Stages of a frame, timed with `SSVL_STATS` (see `ssvl_stats_t`) and reported to `on_trace_cb`:
+//  * SSVL_STAGE_GRAYSCALE: converting frames to grayscale, when `ssvl_feed` didn't while copying them
+//  * SSVL_STAGE_PYRAMID: building the pyramid levels of fed frames (otherwise part of the conversion)
+//  * SSVL_STAGE_CENSUS: census descriptors
+//  * SSVL_STAGE_SEARCH: disparity search, SGM aggregation and the left-right check
+//  * SSVL_STAGE_ADAPTIVE_RANGE: narrowing the disparity range for the next frame
+//  * SSVL_STAGE_DEPTH: disparities to depths, and to points with `ssvl_config_t.point_cloud`
+typedef enum ssvl_stage_enum {SSVL_STAGE_GRAYSCALE=0, SSVL_STAGE_PYRAMID=1, SSVL_STAGE_CENSUS=2, SSVL_STAGE_SEARCH=3,
+                              SSVL_STAGE_ADAPTIVE_RANGE=4, SSVL_STAGE_DEPTH=5, SSVL_STAGE_COUNT=6} ssvl_stage;
+
+// Pixel format of the frames given to `ssvl_feed`/`ssvl_process_frames`, only their luminance
+// is used so each is converted straight to grayscale (`ssvl_gray_t`):
+//  * SSVL_FORMAT_RGB565: 2 bytes per pixel, native-endian (default)
+//  * SSVL_FORMAT_YUYV: YUV 4:2:2 as Y0 U Y1 V, 2 bytes per pixel, only the Y bytes are read
+//  * SSVL_FORMAT_GRAY8: 1 byte per pixel
+//  * SSVL_FORMAT_GRAY16: 2 bytes per pixel, native-endian, used as is
+//  * SSVL_FORMAT_BAYER_*8: raw 8-bit sensor data, named after the top-left 2x2 color pattern.
+//                         Luma comes from 2x2 blocks within pairs of rows (see
+//                         `ssvl_convert_bayer_to_grayscale`) so camera height must be even
+typedef enum ssvl_input_format_enum {SSVL_FORMAT_RGB565=0, SSVL_FORMAT_YUYV=1, SSVL_FORMAT_GRAY8=2, SSVL_FORMAT_GRAY16=3,
+                                     SSVL_FORMAT_BAYER_RGGB8=4, SSVL_FORMAT_BAYER_BGGR8=5, SSVL_FORMAT_BAYER_GRBG8=6, SSVL_FORMAT_BAYER_GBRG8=7} ssvl_input_format;
+
+// Returned by the disparity searches for cells that have no candidate in the searched range
+#define SSVL_DISPARITY_INVALID UINT16_MAX
+
+// Value of cells in `disparity_depth_buffer` rejected by the left-right check (see `ssvl_config_t.lr_check`),
+// both as disparities (`on_disparity_cb`) and as depths
+#define SSVL_CELL_REJECTED -1.0f
+
+// Value of cells in `disparity_depth_buffer` left out by the cell mask (see `ssvl_set_cell_mask`),
+// also returned by `ssvl_query_depth` for cells it can't compute
+#define SSVL_CELL_SKIPPED -2.0f
+
+// `SSVL_OUTPUT_UINT16` values of rejected and skipped cells in both `disparity_u16_buffer` and
+// `depth_mm_buffer`. Cells without a candidate have `SSVL_DISPARITY_INVALID` disparities (and
+// the max depth like floats), depths are clamped to `SSVL_DEPTH_MM_MAX`
+#define SSVL_CELL_U16_REJECTED 0xFFFE
+#define SSVL_CELL_U16_SKIPPED 0xFFFD
+#define SSVL_DEPTH_MM_MAX 0xFFFC
+
+// What `ssvl_process` writes for every depth cell:
+//  * SSVL_OUTPUT_FLOAT: disparities and then depths (mm) as floats in `disparity_depth_buffer` (default)
+//  * SSVL_OUTPUT_UINT16: fixed point disparities (`disparity_fraction_bits` of fraction) into
+//                        `disparity_u16_buffer` and whole mm depths into `depth_mm_buffer`, both
+//                        stored by the searches as they pick each disparity. Depths come from
+//                        `depth_mm_lut` (no division and no depth pass). The callbacks' float
+//                        buffers are NULL, read these instead
+typedef enum ssvl_output_format_enum {SSVL_OUTPUT_FLOAT=0, SSVL_OUTPUT_UINT16=1} ssvl_output_format;
+
+// Which 3D points `ssvl_process` reprojects depth cells to (see `ssvl_config_t.point_cloud`):
+//  * SSVL_POINT_CLOUD_OFF: none (default)
+//  * SSVL_POINT_CLOUD_DENSE: a point for every depth cell at the cell's index, NaN for cells
+//                            without a depth (rejected, skipped or no disparity found)
+//  * SSVL_POINT_CLOUD_COMPACT: only the cells with a depth, in cell order
+//  * SSVL_POINT_CLOUD_VOXEL: compacted, then the points in each cube of `voxel_size_mm` merged into
+//                            their mean, in the order the cubes were first hit
+typedef enum ssvl_point_cloud_mode_enum {SSVL_POINT_CLOUD_OFF=0, SSVL_POINT_CLOUD_DENSE=1, SSVL_POINT_CLOUD_COMPACT=2, SSVL_POINT_CLOUD_VOXEL=3} ssvl_point_cloud_mode;
+
+
+// Rectangle of pixels, used to crop camera frames (see `ssvl_process_frames`)
+typedef struct ssvl_rect_t{
+    uint16_t x;
+    uint16_t y;
+    uint16_t width;
+    uint16_t height;
+}ssvl_rect_t;
+
+
+// Pinhole camera with Brown-Conrady lens distortion, as calibrated by OpenCV (`calibrateCamera`):
+// focal lengths and principal point in pixels, radial `k1`, `k2`, `k3` and tangential `p1`, `p2`
+typedef struct ssvl_camera_intrinsics_t{
+    float fx;
+    float fy;
+    float cx;
+    float cy;
+    float k1;
+    float k2;
+    float p1;
+    float p2;
+    float k3;
+}ssvl_camera_intrinsics_t;
+
+
+// Calibration of a stereo pair (see `ssvl_config_t.rectify`), as OpenCV's `stereoCalibrate` gives it:
+// `rotation` (row-major 3x3) and `translation` take points from the left camera's coordinates
+// to the right camera's
+typedef struct ssvl_stereo_calibration_t{
+    ssvl_camera_intrinsics_t cameras[2];        // Indexed by `ssvl_camera_side`
+    float rotation[9];
+    float translation[3];
+}ssvl_stereo_calibration_t;
+
+
+// Where a rectified pixel comes from: the top-left of the 2x2 source pixels it's interpolated from
+// and the weights of the right column and the bottom row (0 ~ 2^`SSVL_REMAP_FRACTION_BITS`)
+typedef struct ssvl_remap_t{
+    uint16_t x;
+    uint16_t y;
+    uint8_t weight_x;
+    uint8_t weight_y;
+}ssvl_remap_t;
+
+
+// Entry of the voxel table `SSVL_POINT_CLOUD_VOXEL` merges points with: the cube at `key` (coordinates
+// in `voxel_size_mm` units) holds point `point_index`. Entries from earlier frames have an older `stamp`
+typedef struct ssvl_voxel_t{
+    uint32_t stamp;
+    uint32_t point_index;
+    int32_t key[3];
+}ssvl_voxel_t;
+
+
+// Instrumentation of the frame being or last processed (so far, while streaming one), see `ssvl_get_stats`
+typedef struct ssvl_stats_t{
+    uint32_t frame_sequence;                    // Frame these are for, see `ssvl_get_frame_sequence`
+    uint64_t frame_ns;                          // Whole frame from the start of its conversion to the end of `ssvl_process`, callbacks included (0 until then and when streaming)
+    uint64_t stage_ns[SSVL_STAGE_COUNT];        // Time spent in each `ssvl_stage` (summed over bands when streaming), 0 for stages that didn't run
+    uint64_t comparer_calls;                    // Calls to `aggregate_pixel_comparer` and the batched SAD/census comparers
+    uint64_t candidates;                        // Window costs computed: candidate disparities scored by the searches (SIMD padding included) and cost volumes
+    uint64_t fed_bytes;                         // Bytes of the frame given to `ssvl_feed`, both eyes (0 for `ssvl_process_frames`)
+}ssvl_stats_t;
+
+
+// Everything needed to set up a library instance with `ssvl_init_with_config`.
+// Fill with defaults using `ssvl_config_init` and then change what you need
+typedef struct ssvl_config_t{
+    uint16_t cameras_width;                     // Width resolution of camera
+    uint16_t cameras_height;                    // Height resolution of camera
+    uint8_t search_window_dimensions;           // Size of the square pixel blocks compared, must divide width and height
+    float baseline_mm;                          // Distance between cameras on same plane in mm
+
+    // Pixels between neighbouring depth cells, 1 ~ `search_window_dimensions` (0, the default, is
+    // `search_window_dimensions`). Each cell is still the window of `search_window_dimensions` pixels
+    // starting at its `output_stride` multiple, so smaller strides give overlapping windows and
+    // denser depths (1 is a depth per pixel, less the last `search_window_dimensions-1` columns and
+    // rows): `depth_width` = (width - `search_window_dimensions`)/`output_stride` + 1 and the same for
+    // `depth_height`. Can't be used with `streaming` unless it's `search_window_dimensions`
+    uint8_t output_stride;
+    float fov_degrees;                          // Horizontal field of view of the cameras
+    bool allocate;                              // `true` if the library should allocate frame and depth buffers (see `ssvl_set_buffers`)
+    ssvl_input_format input_format;             // Pixel format frames are fed in, `SSVL_FORMAT_RGB565` by default
+
+    uint16_t min_disparity;                     // Smallest disparity (pixels) searched, 0 by default
+    uint16_t max_disparity;                     // Largest disparity (pixels) searched, 0 (default) searches all the way to the left edge
+
+    // Alternative to `min_disparity`/`max_disparity` in distances, converted using `focal_length_pixels * baseline_mm`.
+    // Ignored when 0 (default), otherwise take precedence. `max_depth_mm` is also reported for cells beyond it
+    float min_depth_mm;                         // Closest distance searched, sets `max_disparity`
+    float max_depth_mm;                         // Furthest distance searched, sets `min_disparity`
+
+    bool adaptive_disparity_range;              // Narrow the searched range every frame to what the previous frame found (see `SSVL_ADAPTIVE_RANGE_*`)
+
+    // Match windows by the Hamming distance between census descriptors (`ssvl_census_comparer`)
+    // instead of SAD. A pixel's descriptor has a bit per neighbour in the `SSVL_CENSUS_DIMENSIONS`
+    // square around it, set if the neighbour is darker. Descriptors are computed once per frame
+    // so matching is XOR + popcount, and only the order of intensities matters so exposure and
+    // gain differences between the cameras don't. Allocates 2 `uint32_t` descriptor buffers with
+    // as many pixels as the frame buffers
+    bool census;
+
+    // Aggregate costs with semi-global matching, see `ssvl_sgm_mode`. `sgm_p1` and `sgm_p2` are in
+    // units of scaled window costs (`SSVL_SGM_COST_MAX` at most), `sgm_p1` <= `sgm_p2` <= `SSVL_SGM_COST_MAX`+1.
+    // 4 and 8 paths allocate 2 `uint16_t` entries per depth cell per disparity in the configured range
+    ssvl_sgm_mode sgm;
+    uint16_t sgm_p1;                            // Penalty for a disparity change of 1 between neighbouring cells, 32 by default
+    uint16_t sgm_p2;                            // Penalty for larger changes, 256 by default
+
+    // Left-right consistency check: every searched cell's match in the right eye must also find
+    // that cell as its best match among all the left cells' candidates landing on it (the
+    // minima along the cost volume's diagonals, taken from the same costs as the left to right
+    // search), otherwise the cell is set to `SSVL_CELL_REJECTED`. Drops occluded and ambiguous
+    // cells. Uses the cost volume search (identical disparities) whatever `search_engine` is, and
+    // SGM path cost sums when `sgm` is on. Only with `ssvl_sad_comparer` and `ssvl_census_comparer`
+    bool lr_check;
+
+    // Coarse-to-fine search: grayscale frames are halved `pyramid_levels-1` times (2x2 averages,
+    // built while converting to grayscale), each cell searches the whole range at the coarsest
+    // level and then only `pyramid_radius` disparities either side of the doubled estimate at
+    // every finer level, the full resolution one with `aggregate_pixel_comparer`. Coarse levels
+    // compare windows of `search_window_dimensions` of their own pixels with SAD. Candidates
+    // scored per cell go from the whole range to about range/2^(levels-1) + (levels-1)*(2*radius+1).
+    // 0 or 1 (default) searches full resolution only, at most `SSVL_PYRAMID_MAX_LEVELS` and fewer
+    // if the coarsest level would be smaller than a window. Uses the window search whatever
+    // `search_engine` is, can't be used with `sgm`, `lr_check` or `streaming`. Allocates the
+    // levels (less than another frame buffer per eye), even if `allocate` is false
+    uint8_t pyramid_levels;
+    uint8_t pyramid_radius;                     // Disparities searched either side of the estimate from the coarser level, 2 by default
+
+    // Temporal warm start for video: every cell first searches only `temporal_radius` disparities
+    // either side of its disparity in the previous frame, and falls back to the whole range (the
+    // pyramid search with `pyramid_levels`) if it had none, the best candidate is on an edge of
+    // the band (the minimum is likely further out) or its window cost is above `temporal_max_cost`.
+    // Consecutive frames rarely move a cell more than a disparity or two so most cells score a
+    // handful of candidates. `ssvl_get_temporal_fallbacks` counts the cells that fell back,
+    // `ssvl_reset_temporal` forgets the previous frame (scene cuts, big camera moves). Uses the
+    // window search whatever `search_engine` is, can't be used with `sgm` or `lr_check`.
+    // Allocates 2 bytes per depth cell, even if `allocate` is false
+    bool temporal;
+    uint8_t temporal_radius;                    // Disparities searched either side of the previous frame's, 2 by default
+    uint32_t temporal_max_cost;                 // Largest band search cost kept, in `aggregate_pixel_comparer` units. 0 (default) is `SSVL_TEMPORAL_*_PIXEL_COST` per window pixel
+
+    // Number of threads `ssvl_process` splits work across, 1 (default) runs everything on the calling
+    // thread. Scratch memory is allocated per thread. With `SSVL_PTHREADS` a pool of `thread_count-1`
+    // threads is started (the calling thread is the last worker), otherwise or to use your own pool,
+    // see `ssvl_set_parallel_for`
+    uint8_t thread_count;
+
+    // Process each band of `search_window_dimensions` rows as soon as `ssvl_feed` has it for both eyes
+    // instead of waiting for whole frames. Frame buffers only hold a ring of `stream_ring_rows` rows
+    // (rounded up to a multiple of `search_window_dimensions`, at least 2 bands which is also the
+    // default when 0, `census` adds bands for the rows read above and below a band) and depth rows
+    // are handed to `on_depth_row_cb` as they are calculated. One eye may be fed at most
+    // `stream_ring_rows` minus a band of rows ahead of the other (minus another `SSVL_CENSUS_RADIUS`
+    // with `census`), feeding further fails with `SSVL_STATUS_STREAM_OVERRUN`. Whole frames never exist so `on_grayscale_cb` and
+    // `on_disparity_cb` aren't called (`on_depth_cb` still gets the whole depth buffer at the end)
+    bool streaming;
+    uint16_t stream_ring_rows;
+
+    // Process frames on a library thread instead of inside `ssvl_feed`: frames are fed into a ring
+    // of `async_slots` pairs of frame buffers and `ssvl_feed` returns as soon as a frame is complete,
+    // while the thread processes complete frames in the order they were fed (all callbacks run on
+    // that thread). Every fed frame gets a sequence number (see `ssvl_get_frame_sequence`), depths
+    // also come from `ssvl_poll_depth`/`ssvl_wait_depth`. See `ssvl_async_policy` for when the
+    // processing falls behind. 0 or 1 (default) processes frames on the feeding thread. Needs
+    // `SSVL_PTHREADS`, can't be used with `streaming`, and frames can only be fed (`ssvl_process` and
+    // `ssvl_process_frames` fail). Other functions of the instance must only be used from the callbacks
+    // or after `ssvl_flush`. Allocates the slots and a depth buffer, even if `allocate` is false
+    uint8_t async_slots;
+    ssvl_async_policy async_policy;             // What a new frame does when every slot is taken, `SSVL_ASYNC_DROP_OLDEST` by default
+
+    // Disparities and depths as `uint16_t` (see `ssvl_output_format`), both kept in the memory the
+    // float depths took and no division per cell on cores without an FPU. Their buffers are
+    // always allocated by the library (`allocate` only covers the frame buffers then). Disparities
+    // are whole pixels shifted up by `disparity_fraction_bits` (so `max_disparity` must still fit
+    // below `SSVL_CELL_U16_SKIPPED`), the searches don't refine them further yet. Can't be async
+    // (`ssvl_poll_depth`/`ssvl_wait_depth` hand out floats)
+    ssvl_output_format output_format;           // `SSVL_OUTPUT_FLOAT` by default
+    uint8_t disparity_fraction_bits;            // `SSVL_OUTPUT_UINT16`: fraction bits of the fixed point disparities, 0 by default
+
+    // Rectify frames from `calibration` so rows line up between the eyes, as the searches expect.
+    // Both cameras are turned to face the same way (OpenCV's `stereoRectify`, both views keep half
+    // the rotation between them) and given the smaller of the two `fy` as focal length, which replaces
+    // the one from `fov_degrees` (`baseline_mm` is still used as is), with the principal point in the
+    // middle of the frame. At init, every rectified pixel gets its source position through the lens
+    // distortion as a `ssvl_remap_t` (6 bytes per pixel per eye), positions outside the frame repeat
+    // its edge. Each rectified pixel is then interpolated from the 4 source pixels around it while
+    // converting to grayscale, in the same row tasks. `ssvl_process_frames` reads the source pixels
+    // straight from your frames; fed frames are converted to grayscale first (into another pair of
+    // frames, or a ring of rows when streaming, or the slots when async) and rectified once they're
+    // complete, or when streaming as soon as each rectified row's source rows are. Frames filled
+    // directly before `ssvl_process` can't be rectified (`SSVL_STATUS_INVALID_CONFIG`)
+    bool rectify;
+    ssvl_stereo_calibration_t calibration;
+
+    // Reproject depth cells to 3D points (mm) in the left camera's coordinates (x right, y down,
+    // z forward) while calculating their depths, see `ssvl_point_cloud_mode`. Each cell's point is
+    // on the ray through the middle of its window, from `focal_length_pixels` and the principal
+    // point in the middle of the frame (the same cameras `rectify` makes). Points are
+    // structure-of-arrays, an x, a y and a z buffer of `depth_cell_count` floats (library owned,
+    // even if `allocate` is false), handed to `on_points_cb` after `on_depth_cb`. `ssvl_query_depth`
+    // doesn't add points. `SSVL_POINT_CLOUD_VOXEL` also allocates a `uint32_t` count per depth cell
+    // and a table of 20-byte `ssvl_voxel_t`, 2 ~ 4 per depth cell
+    ssvl_point_cloud_mode point_cloud;
+    float voxel_size_mm;                        // `SSVL_POINT_CLOUD_VOXEL`: edge of the cubes points are merged in, must be > 0
+}ssvl_config_t;
+
+
+// Work function handed to `parallel_for`: `task_index` is 0 ~ task_count-1 and `worker_index` is
+// 0 ~ thread_count-1, unique among workers running at the same time (selects scratch memory)
+typedef void (*ssvl_task_t)(void *task_ctx, uint32_t task_index, uint32_t worker_index);
+
+
+// Scores `candidate_count` neighbouring candidate windows at once, see `ssvl_sad_multi_comparer`
+struct ssvl_t;
+typedef void (*ssvl_multi_comparer_t)(struct ssvl_t *ssvl, ssvl_gray_t *original_cam_buffer, ssvl_gray_t *compare_cam_buffer,
+                                      uint16_t original_window_x, uint16_t original_window_y,
+                                      uint16_t compare_window_x, uint16_t compare_window_y,
+                                      uint8_t window_dimensions, uint16_t candidate_count, uint32_t *costs);
+
+
+// Per-worker scratch, one per `thread_count`
+typedef struct ssvl_worker_scratch_t{
+    uint32_t *column_sums;                      // Cost volume: `width` column sums of |L-R| for the disparity being evaluated
+    uint32_t *cell_best_costs;                  // Cost volume: `depth_width` smallest window costs seen so far for the row of cells
+    uint32_t *cell_window_costs;                // Cost volume: `depth_width` window costs of the disparity being evaluated
+    uint16_t *cell_disparities;                 // Cost volume: `depth_width` disparities of those smallest costs
+    uint32_t *right_best_costs;                 // LR check: `width` smallest costs of each right eye window position over the row's cells
+    uint16_t *right_disparities;                // LR check: `width` disparities of those smallest costs
+    uint16_t *sgm_paths;                        // SGM: two path buffers for the horizontal paths (`sgm_disparity_stride+3` each)
+    uint32_t *row_column_sums;                  // `share_rows`: `width` column sums of every disparity `min_disparity` ~ `max_disparity` for row `shared_row`
+    int32_t shared_row;                         // `share_rows`: row of cells `row_column_sums` holds, -1 if none
+    uint32_t temporal_fallbacks;                // Temporal: cells this worker searched over the whole range this frame
+    uint64_t comparer_calls;                    // `SSVL_STATS`: this worker's share of `ssvl_stats_t.comparer_calls`
+    uint64_t candidates;                        // and `candidates` this frame
+}ssvl_worker_scratch_t;
+
 
 // Stateful library, library creates an instance of this
 // for the user to store in a void* pointer (user should
@@ -53,8 +554,12 @@ typedef struct ssvl_t{
     uint16_t width;                             // Width resolution of camera
     uint16_t height;                            // height resolution of camera
 
-    uint16_t depth_width;                       // Width of depth buffer is width/`search_window_dimensions` cells wide
+    uint16_t depth_width;                       // Width of depth buffer is width/`search_window_dimensions` cells wide (see `ssvl_config_t.output_stride`)
     uint16_t depth_height;                      // height of depth buffer is height/`search_window_dimensions` cells high
+    uint8_t cell_stride;                        // Pixels between neighbouring depth cells' windows, `search_window_dimensions` unless set by `output_stride`
+    bool share_rows;                            // Cost volume column sums are carried from a row of cells to the next, see `ssvl_cost_volume_columns`
+    uint16_t search_task_rows;                  // Rows of cells per search task, consecutive rows go to the same worker when `share_rows`
+    uint16_t census_band_count;                 // Bands of `search_window_dimensions` pixel rows census descriptors are made in (height/`search_window_dimensions`)
 
     float baseline_mm;                          // Distance between cameras on same plane in mm
     float field_of_view_degrees;
@@ -72,31 +577,143 @@ typedef struct ssvl_t{
     // dimensions in the original and compare
     // buffers
     uint32_t (*aggregate_pixel_comparer)(struct ssvl_t *ssvl,
-                                      uint16_t *original_cam_buffer,
-                                      uint16_t *compare_cam_buffer,
+                                      ssvl_gray_t *original_cam_buffer,
+                                      ssvl_gray_t *compare_cam_buffer,
                                       uint16_t original_window_x,
                                       uint16_t original_window_y,
                                       uint16_t compare_window_x,
                                       uint16_t compare_window_y,
                                       uint8_t window_dimensions);
 
+    // Batched versions of the built-in comparers the searches use, specialized for
+    // `search_window_dimensions` when it's one of the sizes built in (see `SSVL_SPECIALIZE_WINDOW`)
+    ssvl_multi_comparer_t sad_multi_comparer;
+    ssvl_multi_comparer_t census_multi_comparer;
+
     uint32_t pixel_count;                       // Number of pixels in an individual camera
     uint32_t depth_cell_count;                  // Number of depth cells total after search window subdivision
-    uint32_t frame_buffer_size;                 // Size, in bytes, of individual frame buffers
+    uint32_t frame_buffer_size;                 // Size, in bytes, of an individual camera frame in `input_format` (fed through `ssvl_feed`)
     uint32_t disparity_depth_buffer_size;       // Size, in bytes, of the depth buffer
 
-    uint16_t *frame_buffers[2];                 // Frame buffers where raw 16-bit RGB565 frames are stored
-    float *disparity_depth_buffer;              // Depth buffer where calculated depths from disparity map are stored
+    ssvl_gray_t *frame_buffers[2];              // Frame buffers, `ssvl_feed` stores frames converted to grayscale (`input_format` rows `width*sizeof(ssvl_gray_t)` bytes apart if filled directly before `ssvl_process`)
+    float *disparity_depth_buffer;              // Depth buffer where calculated depths from disparity map are stored (NULL with `SSVL_OUTPUT_UINT16`)
+
+    ssvl_output_format output_format;           // See `ssvl_config_t.output_format`
+    uint8_t disparity_fraction_bits;
+    uint16_t *disparity_u16_buffer;             // `SSVL_OUTPUT_UINT16`: fixed point disparity of every depth cell (library owned)
+    uint16_t *depth_mm_buffer;                  // `SSVL_OUTPUT_UINT16`: depth (mm) of every depth cell (library owned)
+    uint16_t *depth_mm_lut;                     // `SSVL_OUTPUT_UINT16`: depth (mm) of every whole disparity 0 ~ `max_disparity` (library owned)
 
     uint32_t frame_buffers_amounts[2];          // When using `ssvl_feed(...)`, tracks how much information is stored in corresponding `frame_buffers[...]`
 
+    uint16_t frame_buffer_rows;                 // Rows of pixels `frame_buffers` hold, `height` unless streaming (see `ssvl_frame_buffer_row`)
+    bool streaming;                             // Bands are processed as `ssvl_feed` completes them, see `ssvl_config_t.streaming`
+    uint16_t stream_next_band;                  // Streaming: next band (row of depth cells) waiting for both eyes
+
     uint8_t search_window_dimensions;           // When looking for similar pixel blocks, this is the size of the blocks used for comparing. Must be a multiple of
 
+    uint16_t min_disparity;                     // Smallest disparity searched, from config
+    uint16_t max_disparity;                     // Largest disparity searched, from config (clamped to the largest possible)
+    uint16_t active_min_disparity;              // Range actually searched this frame, same as above
+    uint16_t active_max_disparity;              // unless `adaptive_disparity_range` narrows it
+    bool adaptive_disparity_range;              // Narrow the searched range each frame from the previous frame's disparities
+    uint32_t *disparity_histogram;              // `max_disparity+1` counts used by the adaptive range
+
+    ssvl_search_engine search_engine;           // Which search `ssvl_process` uses, defaults to `SSVL_ENGINE_WINDOW_SEARCH`
+
+    bool census;                                // Windows are matched with `ssvl_census_comparer`, see `ssvl_config_t.census`
+    uint32_t *census_buffers[2];                // Census descriptors of `frame_buffers`, same rows (library owned)
+
+    bool lr_check;                              // Reject cells failing the left-right check, see `ssvl_config_t.lr_check`
+
+    uint8_t pyramid_levels;                     // Coarse-to-fine search, see `ssvl_config_t.pyramid_levels` (1 is off)
+    uint8_t pyramid_radius;
+    ssvl_gray_t *pyramid_buffers[2];            // Levels 1 and up of each eye one after the other, `width` apart like `frame_buffers` (library owned)
+
+    bool temporal;                              // Warm start from the previous frame, see `ssvl_config_t.temporal`
+    uint8_t temporal_radius;
+    uint32_t temporal_max_cost;
+    uint16_t *temporal_disparities;             // Previous frame's disparity of every depth cell, `SSVL_DISPARITY_INVALID` if none (library owned)
+
+    bool masked;                                // Frames only compute the cells in `cell_mask`, see `ssvl_set_cell_mask`
+    bool frame_masked;                          // The current frame was searched with `cell_mask`, `cell_computed` is valid
+    bool rows_masked;                           // The current frame's grayscale and census tasks only run on `SSVL_ROWS_WANTED` rows (never when streaming)
+    bool frame_queryable;                       // `ssvl_process` finished a frame and its buffers haven't been fed since, see `ssvl_query_depth`
+    bool frame_fed;                             // The current frame was converted to grayscale by `ssvl_feed`, its rows only lack pyramid levels
+    uint16_t frame_min_disparity;               // Range the current frame was searched with (`active_min_disparity`
+    uint16_t frame_max_disparity;               // and `active_max_disparity` may already be narrowed for the next one)
+    uint8_t *cell_mask;                         // A byte per depth cell, non-zero cells are computed (library owned, like the next 3)
+    uint8_t *cell_computed;                     // A byte per depth cell, non-zero if the current frame has its disparity/depth
+    uint8_t *grayscale_task_states;             // `ssvl_rows_state` of each grayscale task (left eye's and then right eye's)
+    uint8_t *census_band_states;                // `ssvl_rows_state` of each band's census descriptors (left eye's and then right eye's)
+
+    ssvl_sgm_mode sgm;                          // Semi-global matching, see `ssvl_sgm_mode`
+    uint16_t sgm_p1;
+    uint16_t sgm_p2;
+    uint8_t sgm_cost_shift;                     // Window costs are shifted right this much to fit `SSVL_SGM_COST_MAX`
+    uint16_t sgm_disparity_stride;              // Cost volume entries per cell, disparities in `min_disparity` ~ `max_disparity`
+    uint16_t *sgm_costs;                        // Scaled window costs of every cell (one row of cells for a single pass), library owned
+    uint16_t *sgm_sums;                         // Path cost sums, same layout as `sgm_costs` (library owned)
+    uint16_t *sgm_path_rows;                    // Paths arriving from the previous row of cells, two rows of up to 3 paths (library owned)
+
+    uint8_t worker_count;                       // `thread_count` from config, number of `worker_scratch` entries
+    ssvl_worker_scratch_t *worker_scratch;      // Scratch for each worker (library owned, each worker's memory on its own cache lines)
+
+    // Splits `ssvl_process` stages into tasks (rows of depth cells, bands of
+    // pixel rows) and runs `task` for every index in any order on up to
+    // `worker_count` threads, returning once all are done. Tasks are small and
+    // not equally expensive so pools should hand them out dynamically. NULL
+    // runs tasks in order on the calling thread
+    void *parallel_opaque_ptr;
+    void (*parallel_for)(void *parallel_opaque_ptr, uint32_t task_count, ssvl_task_t task, void *task_ctx);
+    void *thread_pool;                          // Default pthreads pool when `SSVL_PTHREADS` and `thread_count` > 1 (library owned)
+
+    // Fixed-point RGB565 to grayscale: each table entry is the channel value times its weight, gray is
+    // (r_lut[r] + g_lut[g] + b_lut[b]) >> SSVL_GRAYSCALE_FRACTION_BITS (see `ssvl_convert_rgb565_to_grayscale_lut`)
+    uint32_t grayscale_r_lut[32];
+    uint32_t grayscale_g_lut[64];
+    uint32_t grayscale_b_lut[32];
+    bool frames_grayscale;                      // Set by `ssvl_feed` after converting both frames while copying them, `ssvl_process` skips its conversion
+    bool frames_pyramid;                        // Set by `ssvl_process_frames` when its grayscale conversion also built the pyramid levels
+    const uint8_t *source_frames[2];            // `input_format` frames the grayscale stage reads, `frame_buffers` themselves unless `ssvl_process_frames` (fed grayscale frames waiting to be rectified)
+    uint32_t source_stride;                     // Bytes from one row of `source_frames` to the next
+
+    ssvl_input_format input_format;             // Pixel format of fed frames, see `ssvl_input_format`
+    uint8_t input_bytes_per_pixel;              // Bytes a pixel of `input_format` takes
+    uint16_t grayscale_task_rows;               // Rows converted per grayscale task: a band, a pair of Bayer rows or a multiple of both with every pyramid level's rows in it
+    uint32_t bayer_weights[2][4];               // Bayer: fixed-point weights of a 2x2 block (top-left, top-right, bottom-left, bottom-right) starting on an even/odd column
+    uint8_t *feed_staging;                      // Bayer: raw row pair per side waiting to be converted by `ssvl_feed` (library owned)
+    uint8_t feed_split_bytes[2];                // First byte of an RGB565 pixel split between two `ssvl_feed` calls, per side
+
+    bool rectify;                               // Frames are rectified while converting them to grayscale, see `ssvl_config_t.rectify`
+    float rectify_rotations[2][9];              // Rotation of each eye's camera into the rectified one (row-major)
+    ssvl_remap_t *rectify_maps[2];              // Source position of every rectified pixel of each eye, rows of `width` (library owned)
+    const uint8_t **rectify_rows[2];            // Start of each of the `height` source rows the maps point into (library owned)
+    bool rectify_rows_gray;                     // `rectify_rows` point at grayscale rows fed into `rectify_sources`/the async slots, `input_format` otherwise
+    ssvl_gray_t *rectify_sources[2];            // Fed frames in grayscale before rectifying, `rectify_source_rows` rows each (library owned, NULL when async)
+    uint16_t rectify_source_rows;               // `height`, or when streaming a ring of rows big enough for the rows a band is rectified from
+    uint16_t *rectify_source_starts;            // Streaming: first source row any of the rectified rows y ~ height-1 reads (library owned)
+    uint16_t *rectify_source_ends;              // Streaming: source rows that have to be fed to rectify rows 0 ~ y (library owned)
+    uint16_t rectify_rows_done;                 // Streaming: rectified rows of the frame so far
+
+    ssvl_point_cloud_mode point_cloud;          // Depth cells are reprojected to points, see `ssvl_config_t.point_cloud`
+    float voxel_size_mm;
+    float *point_rays_x;                        // x/z of the ray through the middle of each column of depth cells (library owned, like the rest)
+    float *point_rays_y;                        // y/z of the ray through the middle of each row of depth cells
+    float *point_buffers[3];                    // x, y and z of every point, `depth_cell_count` each
+    uint32_t *point_row_counts;                 // Compact and voxel: points each row of depth cells packed at its start
+    uint32_t point_count;                       // Points of the last frame, see `ssvl_get_point_count`
+    ssvl_voxel_t *voxel_table;                  // Voxel: open addressing hash table of the cubes hit this frame
+    uint32_t voxel_table_mask;                  // Voxel: entries in `voxel_table` minus 1 (a power of 2)
+    uint32_t voxel_stamp;                       // Voxel: `ssvl_voxel_t.stamp` of this frame's entries
+    uint32_t *voxel_counts;                     // Voxel: points merged into each point so far
+
+    void *memory;                               // Block every library buffer is carved from when the library allocated it, NULL for an arena (see `ssvl_init_with_arena`)
     bool buffers_set;                           // Flag indicating if frame and depth buffers are allocated/set
     bool custom_buffers_set;                    // Flag indicating if frame and depth buffers are memory from outside the library (do not deallocate custom buffers, user's problem)
 
     void *grayscale_opaque_ptr;
-    void (*on_grayscale_cb)(void *grayscale_opaque_ptr, ssvl_camera_side side, uint16_t *grayscale_frame_buffer, uint16_t pixel_width, uint16_t pixel_height);
+    void (*on_grayscale_cb)(void *grayscale_opaque_ptr, ssvl_camera_side side, ssvl_gray_t *grayscale_frame_buffer, uint16_t pixel_width, uint16_t pixel_height);
 
     void *disparity_opaque_ptr;
     void (*on_disparity_cb)(void *disparity_opaque_ptr, float *disparity_buffer, uint16_t disparity_width, uint16_t disparity_height);
@@ -104,6 +721,25 @@ typedef struct ssvl_t{
     void *depth_opaque_ptr;
     void (*on_depth_cb)(void *depth_opaque_ptr, float *disparity_depth_buffer, uint16_t depth_width, uint16_t depth_height, float max_depth_mm);
 
+    void *depth_row_opaque_ptr;
+    void (*on_depth_row_cb)(void *depth_row_opaque_ptr, float *depth_row, uint16_t depth_row_index, uint16_t depth_width, float max_depth_mm);
+
+    void *points_opaque_ptr;
+    void (*on_points_cb)(void *points_opaque_ptr, float *points_x, float *points_y, float *points_z, uint32_t point_count);
+
+    void *trace_opaque_ptr;
+    void (*on_trace_cb)(void *trace_opaque_ptr, ssvl_stage stage, bool begin, uint64_t timestamp_ns);
+
+    ssvl_stats_t stats;                         // `SSVL_STATS`: current frame's stats, worker counters are summed by `ssvl_get_stats`
+    uint64_t stats_frame_start_ns;              // `SSVL_STATS`: when the current frame started
+    uint64_t stats_stage_start_ns;              // `SSVL_STATS`: when the running stage started
+    uint64_t stats_fed_bytes;                   // `SSVL_STATS`: bytes fed so far for the frame `ssvl_feed` is filling
+    uint64_t stats_queued_fed_bytes;            // `SSVL_STATS`: bytes fed for the next frame to be processed, moved to `stats` when it starts
+
+    void *async;                                // Asynchronous pipeline when `async_slots` > 1, NULL otherwise (library owned, see `ssvl_config_t.async_slots`)
+    ssvl_gray_t *async_feed_buffers[2];         // Async: frame buffers of the slot `ssvl_feed` is filling, NULL between frames
+    uint32_t frame_sequence;                    // Sequence number of the frame being/last processed, see `ssvl_get_frame_sequence`
+
     ssvl_status_t status_code;               // OK by default since 0 by default but gets set to any error code throughout the library
 }ssvl_t;
 
@@ -123,12 +759,91 @@ SSVL_FUNC ssvl_status_t ssvl_get_status_code(ssvl_t *ssvl){
 }
 
 
+// ///////////////////////////////////////////
+//              INSTRUMENTATION
+// vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
+
+// Stage timing and the trace callback are calls that do nothing without `SSVL_STATS`,
+// the counters in the search loops are a macro that disappears
+#if defined(SSVL_STATS)
+    #define SSVL_STATS_COUNT(scratch, calls, candidate_count) do{ (scratch)->comparer_calls += (calls); (scratch)->candidates += (candidate_count); }while(0)
+#else
+    #define SSVL_STATS_COUNT(scratch, calls, candidate_count) do{ (void)(scratch); }while(0)
+#endif
+
+
+#if defined(SSVL_STATS) && defined(CLOCK_MONOTONIC)
+SSVL_FUNC uint64_t ssvl_stats_clock_ns(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+#endif
+
+
+// Clears the stats for a new frame (fed bytes are the ones queued for it) and starts its clock
+SSVL_FUNC void ssvl_stats_start_frame(ssvl_t *ssvl){
+    #if defined(SSVL_STATS)
+        memset(&ssvl->stats, 0, sizeof(ssvl_stats_t));
+        ssvl->stats.frame_sequence = ssvl->frame_sequence;
+        ssvl->stats.fed_bytes = ssvl->stats_queued_fed_bytes;
+        ssvl->stats_queued_fed_bytes = 0;
+
+        for(uint8_t worker_index=0; worker_index<ssvl->worker_count; worker_index++){
+            ssvl->worker_scratch[worker_index].comparer_calls = 0;
+            ssvl->worker_scratch[worker_index].candidates = 0;
+        }
+
+        ssvl->stats_frame_start_ns = SSVL_STATS_CLOCK_NS();
+    #else
+        (void)ssvl;
+    #endif
+}
+
+
+SSVL_FUNC void ssvl_stats_end_frame(ssvl_t *ssvl){
+    #if defined(SSVL_STATS)
+        ssvl->stats.frame_ns = SSVL_STATS_CLOCK_NS() - ssvl->stats_frame_start_ns;
+    #else
+        (void)ssvl;
+    #endif
+}
+
+
+// Starts timing `stage` of the current frame, telling `on_trace_cb`
+SSVL_FUNC void ssvl_stats_stage_begin(ssvl_t *ssvl, ssvl_stage stage){
+    #if defined(SSVL_STATS)
+        ssvl->stats_stage_start_ns = SSVL_STATS_CLOCK_NS();
+
+        if(ssvl->on_trace_cb != NULL) ssvl->on_trace_cb(ssvl->trace_opaque_ptr, stage, true, ssvl->stats_stage_start_ns);
+    #else
+        (void)ssvl;
+        (void)stage;
+    #endif
+}
+
+
+// Adds the time since `ssvl_stats_stage_begin` to `stage`, telling `on_trace_cb`
+SSVL_FUNC void ssvl_stats_stage_end(ssvl_t *ssvl, ssvl_stage stage){
+    #if defined(SSVL_STATS)
+        const uint64_t now = SSVL_STATS_CLOCK_NS();
+        ssvl->stats.stage_ns[stage] += now - ssvl->stats_stage_start_ns;
+
+        if(ssvl->on_trace_cb != NULL) ssvl->on_trace_cb(ssvl->trace_opaque_ptr, stage, false, now);
+    #else
+        (void)ssvl;
+        (void)stage;
+    #endif
+}
+
+
 // ///////////////////////////////////////////
 //   AGGREGATE PIXEL BLOCK COMPARE FUNCTIONS
 // vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
 
 // https://johnwlambert.github.io/stereo/
-SSVL_FUNC uint32_t ssvl_sad_comparer(ssvl_t *ssvl, uint16_t *original_cam_buffer, uint16_t *compare_cam_buffer,
+SSVL_KERNEL_FUNC uint32_t ssvl_sad_comparer(ssvl_t *ssvl, ssvl_gray_t *original_cam_buffer, ssvl_gray_t *compare_cam_buffer,
                                                uint16_t original_window_x, uint16_t original_window_y,
                                                uint16_t compare_window_x, uint16_t compare_window_y,
                                                uint8_t window_dimensions){
@@ -149,316 +864,5080 @@ SSVL_FUNC uint32_t ssvl_sad_comparer(ssvl_t *ssvl, uint16_t *original_cam_buffer
 }
 
 
-// ///////////////////////////////////////////
-//         LIBRARY SETUP AND STOPPING
-// vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
+// Same as `ssvl_sad_comparer` but scores `candidate_count` windows at once. Candidate `i`
+// is the window at `compare_window_x + i` in `compare_cam_buffer` and its SAD is written
+// to `sads[i]`. Neighbouring candidates share almost all of their pixels so each window
+// pixel of the original is broadcast and compared against many candidates per SIMD
+// instruction (AVX2: 32 and then 16 for the rest, SSE2/NEON: 16). With 8-bit grayscale the
+// differences are taken on bytes and summed in 16-bit lanes, only widened to 32-bit every
+// few rows. Results are bit-identical to `ssvl_sad_comparer`. Every candidate window must
+// fit inside the compare buffer
+SSVL_KERNEL_FUNC void ssvl_sad_multi_comparer(ssvl_t *ssvl, ssvl_gray_t *original_cam_buffer, ssvl_gray_t *compare_cam_buffer,
+                                       uint16_t original_window_x, uint16_t original_window_y,
+                                       uint16_t compare_window_x, uint16_t compare_window_y,
+                                       uint8_t window_dimensions, uint16_t candidate_count, uint32_t *sads){
+    uint16_t candidate = 0;
 
-// Initialize the `ssvl` library - store the returned pointer in your program. Allocates:
-//  * 2 16-bit cameras_width*cameras_height frame buffers = 2*2*cameras_width*cameras_height bytes
-//  * 1 32-bit/float calculated depth buffer = 4*cameras_width*cameras_height bytes bytes
-//
-// Set `allocate` to `true` if the library should allocate frame and depth buffers, otherwise, set
-// false if you're going to call `ssvl_set_buffers` to reuse memory you may already have allocated
-SSVL_FUNC void ssvl_init(ssvl_t *ssvl, uint16_t cameras_width, uint16_t cameras_height, uint8_t search_window_dimensions, float baseline_mm, float fov_degrees, bool allocate){
-    // if search window square dimensions are not a multiple of the
-    // width or height, return NULL and do not create library instance
-    if(cameras_width & search_window_dimensions != 0 || cameras_height % search_window_dimensions != 0){
-        return;
-    }
+    #if defined(SSVL_GRAY8) && (defined(SSVL_SSE2) || defined(SSVL_NEON))
+        // Rows of the window summed in 16-bit lanes before they could overflow
+        const uint16_t flush_rows = (uint16_t)(UINT16_MAX / (UINT8_MAX*window_dimensions));
+    #endif
 
-    // Track these for later usage
-    ssvl->width = cameras_width;
-    ssvl->height = cameras_height;
-    ssvl->search_window_dimensions = search_window_dimensions;
-    ssvl->baseline_mm = baseline_mm;
-    ssvl->field_of_view_degrees = fov_degrees;
+    #if defined(SSVL_AVX2) && defined(SSVL_GRAY8)
+        const __m256i zero = _mm256_setzero_si256();
 
-    // https://answers.opencv.org/question/17076/conversion-focal-distance-from-mm-to-pixels/
-    // https://gamedev.stackexchange.com/questions/166993/interpreting-focal-length-in-units-of-pixels
-    // https://computergraphics.stackexchange.com/questions/10593/is-focal-length-equal-to-the-distance-from-the-optical-center-to-the-near-clippi
-    ssvl->focal_length_pixels = ((float)ssvl->width*0.5f) / tanf(fov_degrees * 0.5f * 3.141593f/180.0f);
+        for(; candidate+32 <= candidate_count; candidate+=32){
+            __m256i acc0 = zero, acc1 = zero, acc2 = zero, acc3 = zero;
 
-    // https://stackoverflow.com/a/19423059
-    // https://stackoverflow.com/a/75745742
-    ssvl->max_depth_mm = ssvl->focal_length_pixels * ssvl->baseline_mm;
+            for(uint16_t first_y=0; first_y<window_dimensions; first_y+=flush_rows){
+                const uint16_t end_y = (window_dimensions - first_y > flush_rows) ? (uint16_t)(first_y + flush_rows) : window_dimensions;
 
-    ssvl->grayscale_opaque_ptr = NULL;
-    ssvl->on_grayscale_cb = NULL;
+                // Candidates 0-7 and 16-23 in `sum_lo`, 8-15 and 24-31 in `sum_hi` (per 128-bit lane unpacking)
+                __m256i sum_lo = zero, sum_hi = zero;
 
-    ssvl->disparity_opaque_ptr = NULL;
-    ssvl->on_disparity_cb = NULL;
+                for(uint16_t y=first_y; y<end_y; y++){
+                    const uint8_t *original_row = original_cam_buffer + (original_window_y+y)*ssvl->width + original_window_x;
+                    const uint8_t *compare_row = compare_cam_buffer + (compare_window_y+y)*ssvl->width + compare_window_x + candidate;
 
-    ssvl->depth_opaque_ptr = NULL;
-    ssvl->on_depth_cb = NULL;
+                    for(uint16_t x=0; x<window_dimensions; x++){
+                        const __m256i original_sample = _mm256_set1_epi8((char)original_row[x]);
+                        const __m256i compare = _mm256_loadu_si256((const __m256i*)(compare_row + x));
 
-    // Depth resolution is only as good as the search window
-    ssvl->depth_width = ssvl->width / ssvl->search_window_dimensions;
-    ssvl->depth_height = ssvl->height / ssvl->search_window_dimensions;
-    ssvl->depth_cell_count = ssvl->depth_width * ssvl->depth_height;
+                        // |a-b| on unsigned 8-bit lanes is the OR of both saturating subtractions
+                        const __m256i diff = _mm256_or_si256(_mm256_subs_epu8(original_sample, compare), _mm256_subs_epu8(compare, original_sample));
 
-    // Set the default algorithm that compares pixel
-    // blocks on 1D search line between left and right
-    // camera eyes
-    ssvl->aggregate_pixel_comparer = ssvl_sad_comparer;
+                        sum_lo = _mm256_add_epi16(sum_lo, _mm256_unpacklo_epi8(diff, zero));
+                        sum_hi = _mm256_add_epi16(sum_hi, _mm256_unpackhi_epi8(diff, zero));
+                    }
+                }
 
-    // Calculate number of pixels and elements in frame and depth buffers
-    ssvl->pixel_count = cameras_width*cameras_height;
-    ssvl->frame_buffer_size = ssvl->pixel_count * sizeof(uint16_t);
-    ssvl->disparity_depth_buffer_size = ssvl->depth_cell_count * sizeof(float);
+                acc0 = _mm256_add_epi32(acc0, _mm256_cvtepu16_epi32(_mm256_castsi256_si128(sum_lo)));
+                acc1 = _mm256_add_epi32(acc1, _mm256_cvtepu16_epi32(_mm256_castsi256_si128(sum_hi)));
+                acc2 = _mm256_add_epi32(acc2, _mm256_cvtepu16_epi32(_mm256_extracti128_si256(sum_lo, 1)));
+                acc3 = _mm256_add_epi32(acc3, _mm256_cvtepu16_epi32(_mm256_extracti128_si256(sum_hi, 1)));
+            }
 
-    // Stop here if user does not want ssvl to make buffers
-    if(allocate == false){
-        return;
-    }
+            _mm256_storeu_si256((__m256i*)(sads + candidate), acc0);
+            _mm256_storeu_si256((__m256i*)(sads + candidate + 8), acc1);
+            _mm256_storeu_si256((__m256i*)(sads + candidate + 16), acc2);
+            _mm256_storeu_si256((__m256i*)(sads + candidate + 24), acc3);
+        }
+    #elif defined(SSVL_AVX2)
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i low_words = _mm256_set1_epi32(UINT16_MAX);
 
-    // Allocate space for the individual camera frame buffers
-    ssvl->frame_buffers[SSVL_LEFT_CAMERA] = (uint16_t*)SSVL_MALLOC(ssvl->frame_buffer_size);
-    ssvl->frame_buffers[SSVL_RIGHT_CAMERA] = (uint16_t*)SSVL_MALLOC(ssvl->frame_buffer_size);
-    ssvl->frame_buffers_amounts[SSVL_LEFT_CAMERA] = 0;
-    ssvl->frame_buffers_amounts[SSVL_RIGHT_CAMERA] = 0;
+        for(; candidate+32 <= candidate_count; candidate+=32){
+            // Differences are widened by masking and shifting 32-bit lanes (no shuffles in the
+            // loop): even candidates 0, 2 ~ 14 in `even_lo`, odd ones in `odd_lo`, 16 ~ 31 in `*_hi`
+            __m256i even_lo = zero, odd_lo = zero, even_hi = zero, odd_hi = zero;
 
-    // Allocate space for the depth buffer
-    ssvl->disparity_depth_buffer = (float*)SSVL_MALLOC(ssvl->disparity_depth_buffer_size);
-    
-    // Indicate that the buffers are ready
-    // and that these are *not* custom buffers
-    // (they should be deallocated by the library then)
-    ssvl->buffers_set = true;
-    ssvl->custom_buffers_set = false;
+            for(uint16_t y=0; y<window_dimensions; y++){
+                const uint16_t *original_row = original_cam_buffer + (original_window_y+y)*ssvl->width + original_window_x;
+                const uint16_t *compare_row = compare_cam_buffer + (compare_window_y+y)*ssvl->width + compare_window_x + candidate;
 
-    #if defined(SSVL_DEBUG)
-        SSVL_PRINTF("SSVL:");
-        SSVL_PRINTF("\t width (pixels): \t\t\t\t\t\t%d\n", ssvl->width);
-        SSVL_PRINTF("\t height (pixels): \t\t\t\t\t\t%d\n", ssvl->height);
-        SSVL_PRINTF("\t search_window_dimensions (pixels): \t\t\t\t%d\n", ssvl->search_window_dimensions);
-        SSVL_PRINTF("\t baseline (mm): \t\t\t\t\t\t%0.3f\n", ssvl->baseline_mm);
-        SSVL_PRINTF("\t FOV (degrees): \t\t\t\t\t\t%0.3f\n", ssvl->field_of_view_degrees);
-        SSVL_PRINTF("\t focal length (pixels): \t\t\t\t\t%0.3f\n", ssvl->focal_length_pixels);
-        SSVL_PRINTF("\t max depth (mm): \t\t\t\t\t\t%0.3f\n", ssvl->max_depth_mm);
-        SSVL_PRINTF("\t max depth (m): \t\t\t\t\t\t%0.3f\n", ssvl->max_depth_mm/1000.0f);
-        SSVL_PRINTF("\t frame buffer size (bytes): \t\t\t\t\t%d\n", ssvl->frame_buffer_size);
-    #endif
-}
+                for(uint16_t x=0; x<window_dimensions; x++){
+                    const __m256i original_sample = _mm256_set1_epi16((short)original_row[x]);
+                    const __m256i compare_lo = _mm256_loadu_si256((const __m256i*)(compare_row + x));
+                    const __m256i compare_hi = _mm256_loadu_si256((const __m256i*)(compare_row + x + 16));
 
+                    // |a-b| on unsigned 16-bit lanes is the OR of both saturating subtractions
+                    const __m256i diff_lo = _mm256_or_si256(_mm256_subs_epu16(original_sample, compare_lo), _mm256_subs_epu16(compare_lo, original_sample));
+                    const __m256i diff_hi = _mm256_or_si256(_mm256_subs_epu16(original_sample, compare_hi), _mm256_subs_epu16(compare_hi, original_sample));
 
-// If `allocate` was set to `false` in call to `ssvl_init`, use this function
-// to set the 2 frame buffers and 1 depth buffer to custom locations. Returns true
-// if set locations successfully, false if not because element count < pixel_count
-SSVL_FUNC bool ssvl_set_buffers(ssvl_t *ssvl, uint16_t *frame_buffers[], uint32_t frame_buffers_lengths, float *disparity_depth_buffer, uint32_t disparity_depth_buffer_length){
-    // Check that the buffers are long enough to store information for every camera pixel
-    if(frame_buffers_lengths < ssvl->pixel_count || disparity_depth_buffer_length < ssvl->pixel_count){
-        return false;
-    }
+                    even_lo = _mm256_add_epi32(even_lo, _mm256_and_si256(diff_lo, low_words));
+                    odd_lo = _mm256_add_epi32(odd_lo, _mm256_srli_epi32(diff_lo, 16));
+                    even_hi = _mm256_add_epi32(even_hi, _mm256_and_si256(diff_hi, low_words));
+                    odd_hi = _mm256_add_epi32(odd_hi, _mm256_srli_epi32(diff_hi, 16));
+                }
+            }
 
-    // Set the buffers to the user's custom locations
-    ssvl->frame_buffers[0] = frame_buffers[0];
-    ssvl->frame_buffers[1] = frame_buffers[1];
-    ssvl->disparity_depth_buffer = disparity_depth_buffer;
+            // Back in candidate order, interleaving gives 0-3 and 8-11 (`lo_first`) and 4-7 and 12-15
+            const __m256i lo_first = _mm256_unpacklo_epi32(even_lo, odd_lo);
+            const __m256i lo_second = _mm256_unpackhi_epi32(even_lo, odd_lo);
+            const __m256i hi_first = _mm256_unpacklo_epi32(even_hi, odd_hi);
+            const __m256i hi_second = _mm256_unpackhi_epi32(even_hi, odd_hi);
 
-    // Buffers are ready and are custom (not do deallocate on deinit of library)
-    ssvl->buffers_set = true;
-    ssvl->custom_buffers_set = true;
-}
+            _mm256_storeu_si256((__m256i*)(sads + candidate), _mm256_permute2x128_si256(lo_first, lo_second, 0x20));
+            _mm256_storeu_si256((__m256i*)(sads + candidate + 8), _mm256_permute2x128_si256(lo_first, lo_second, 0x31));
+            _mm256_storeu_si256((__m256i*)(sads + candidate + 16), _mm256_permute2x128_si256(hi_first, hi_second, 0x20));
+            _mm256_storeu_si256((__m256i*)(sads + candidate + 24), _mm256_permute2x128_si256(hi_first, hi_second, 0x31));
+        }
+    #endif
 
+    // AVX2 builds also run 16 candidates at a time on what the 32 wide loops leave
+    #if defined(SSVL_SSE2) && defined(SSVL_GRAY8)
+        const __m128i zero_128 = _mm_setzero_si128();
 
-SSVL_FUNC void ssvl_set_on_grayscale_cb(ssvl_t *ssvl,
-                                        void (*on_grayscale_cb)(void *grayscale_opaque_ptr, ssvl_camera_side side, uint16_t *grayscale_frame_buffer, uint16_t pixel_width, uint16_t pixel_height),
-                                        void *grayscale_opaque_ptr){
-    ssvl->on_grayscale_cb = on_grayscale_cb;
-    ssvl->grayscale_opaque_ptr = grayscale_opaque_ptr;
-}
+        for(; candidate+16 <= candidate_count; candidate+=16){
+            __m128i acc0 = zero_128, acc1 = zero_128, acc2 = zero_128, acc3 = zero_128;
 
+            for(uint16_t first_y=0; first_y<window_dimensions; first_y+=flush_rows){
+                const uint16_t end_y = (window_dimensions - first_y > flush_rows) ? (uint16_t)(first_y + flush_rows) : window_dimensions;
+                __m128i sum_lo = zero_128, sum_hi = zero_128;
 
-SSVL_FUNC void ssvl_set_on_disparity_cb(ssvl_t *ssvl,
-                                        void (*on_disparity_cb)(void *disparity_opaque_ptr, float *disparity_buffer, uint16_t disparity_width, uint16_t disparity_height),
-                                        void *disparity_opaque_ptr){
-    ssvl->on_disparity_cb = on_disparity_cb;
-    ssvl->disparity_opaque_ptr = disparity_opaque_ptr;
-}
+                for(uint16_t y=first_y; y<end_y; y++){
+                    const uint8_t *original_row = original_cam_buffer + (original_window_y+y)*ssvl->width + original_window_x;
+                    const uint8_t *compare_row = compare_cam_buffer + (compare_window_y+y)*ssvl->width + compare_window_x + candidate;
 
+                    for(uint16_t x=0; x<window_dimensions; x++){
+                        const __m128i original_sample = _mm_set1_epi8((char)original_row[x]);
+                        const __m128i compare = _mm_loadu_si128((const __m128i*)(compare_row + x));
 
-SSVL_FUNC void ssvl_set_on_depth_cb(ssvl_t *ssvl,
-                                    void (*on_depth_cb)(void *depth_opaque_ptr, float *disparity_depth_buffer, uint16_t depth_width, uint16_t depth_height, float max_depth_mm),
-                                    void *depth_opaque_ptr){
-    ssvl->on_depth_cb = on_depth_cb;
-    ssvl->depth_opaque_ptr = depth_opaque_ptr;
-}
+                        // |a-b| on unsigned 8-bit lanes is the OR of both saturating subtractions
+                        const __m128i diff = _mm_or_si128(_mm_subs_epu8(original_sample, compare), _mm_subs_epu8(compare, original_sample));
 
+                        sum_lo = _mm_add_epi16(sum_lo, _mm_unpacklo_epi8(diff, zero_128));
+                        sum_hi = _mm_add_epi16(sum_hi, _mm_unpackhi_epi8(diff, zero_128));
+                    }
+                }
 
-// Give back the memory for various buffers,
-// does not deallocate `ssvl_t` structure
-SSVL_FUNC void ssvl_destroy(ssvl_t *ssvl){
-    // Only deallocate buffers if they are set and not custom
-    if(ssvl->buffers_set == true && ssvl->custom_buffers_set == false){
-        SSVL_FREE(ssvl->frame_buffers[0]);
-        SSVL_FREE(ssvl->frame_buffers[1]);
-        SSVL_FREE(ssvl->disparity_depth_buffer);
-    }
+                acc0 = _mm_add_epi32(acc0, _mm_unpacklo_epi16(sum_lo, zero_128));
+                acc1 = _mm_add_epi32(acc1, _mm_unpackhi_epi16(sum_lo, zero_128));
+                acc2 = _mm_add_epi32(acc2, _mm_unpacklo_epi16(sum_hi, zero_128));
+                acc3 = _mm_add_epi32(acc3, _mm_unpackhi_epi16(sum_hi, zero_128));
+            }
 
-    // Reset flags
-    ssvl->buffers_set = false;
-    ssvl->custom_buffers_set = false;
-}
+            _mm_storeu_si128((__m128i*)(sads + candidate), acc0);
+            _mm_storeu_si128((__m128i*)(sads + candidate + 4), acc1);
+            _mm_storeu_si128((__m128i*)(sads + candidate + 8), acc2);
+            _mm_storeu_si128((__m128i*)(sads + candidate + 12), acc3);
+        }
+    #elif defined(SSVL_SSE2)
+        const __m128i zero_128 = _mm_setzero_si128();
 
+        for(; candidate+16 <= candidate_count; candidate+=16){
+            __m128i acc0 = zero_128, acc1 = zero_128, acc2 = zero_128, acc3 = zero_128;
 
-// ///////////////////////////////////////////
-//          PRIMARY LIBRARY USAGE
-// vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
+            for(uint16_t y=0; y<window_dimensions; y++){
+                const uint16_t *original_row = original_cam_buffer + (original_window_y+y)*ssvl->width + original_window_x;
+                const uint16_t *compare_row = compare_cam_buffer + (compare_window_y+y)*ssvl->width + compare_window_x + candidate;
 
-// Converts 16-bit RGB565 to 16-bit grayscale
-// https://en.wikipedia.org/wiki/Grayscale#:~:text=Ylinear%2C-,which%20is%20given%20by,-%5B6%5D
-SSVL_FUNC void ssvl_convert_rgb565_to_grayscale(uint16_t *buffer, uint32_t pixel_count){
-    // Masks for bits for each color channel
-    const uint16_t r_mask = 0b1111100000000000;
-    const uint16_t g_mask = 0b0000011111100000;
-    const uint16_t b_mask = 0b0000000000011111;
+                for(uint16_t x=0; x<window_dimensions; x++){
+                    const __m128i original_sample = _mm_set1_epi16((short)original_row[x]);
+                    const __m128i compare_lo = _mm_loadu_si128((const __m128i*)(compare_row + x));
+                    const __m128i compare_hi = _mm_loadu_si128((const __m128i*)(compare_row + x + 8));
+
+                    // |a-b| on unsigned 16-bit lanes is the OR of both saturating subtractions
+                    const __m128i diff_lo = _mm_or_si128(_mm_subs_epu16(original_sample, compare_lo), _mm_subs_epu16(compare_lo, original_sample));
+                    const __m128i diff_hi = _mm_or_si128(_mm_subs_epu16(original_sample, compare_hi), _mm_subs_epu16(compare_hi, original_sample));
+
+                    acc0 = _mm_add_epi32(acc0, _mm_unpacklo_epi16(diff_lo, zero_128));
+                    acc1 = _mm_add_epi32(acc1, _mm_unpackhi_epi16(diff_lo, zero_128));
+                    acc2 = _mm_add_epi32(acc2, _mm_unpacklo_epi16(diff_hi, zero_128));
+                    acc3 = _mm_add_epi32(acc3, _mm_unpackhi_epi16(diff_hi, zero_128));
+                }
+            }
+
+            _mm_storeu_si128((__m128i*)(sads + candidate), acc0);
+            _mm_storeu_si128((__m128i*)(sads + candidate + 4), acc1);
+            _mm_storeu_si128((__m128i*)(sads + candidate + 8), acc2);
+            _mm_storeu_si128((__m128i*)(sads + candidate + 12), acc3);
+        }
+    #elif defined(SSVL_NEON) && defined(SSVL_GRAY8)
+        for(; candidate+16 <= candidate_count; candidate+=16){
+            uint32x4_t acc0 = vdupq_n_u32(0), acc1 = vdupq_n_u32(0), acc2 = vdupq_n_u32(0), acc3 = vdupq_n_u32(0);
+
+            for(uint16_t first_y=0; first_y<window_dimensions; first_y+=flush_rows){
+                const uint16_t end_y = (window_dimensions - first_y > flush_rows) ? (uint16_t)(first_y + flush_rows) : window_dimensions;
+                uint16x8_t sum_lo = vdupq_n_u16(0), sum_hi = vdupq_n_u16(0);
+
+                for(uint16_t y=first_y; y<end_y; y++){
+                    const uint8_t *original_row = original_cam_buffer + (original_window_y+y)*ssvl->width + original_window_x;
+                    const uint8_t *compare_row = compare_cam_buffer + (compare_window_y+y)*ssvl->width + compare_window_x + candidate;
+
+                    for(uint16_t x=0; x<window_dimensions; x++){
+                        const uint8x8_t original_sample = vdup_n_u8(original_row[x]);
+                        const uint8x16_t compare = vld1q_u8(compare_row + x);
+
+                        // Widening absolute difference and accumulate
+                        sum_lo = vabal_u8(sum_lo, vget_low_u8(compare), original_sample);
+                        sum_hi = vabal_u8(sum_hi, vget_high_u8(compare), original_sample);
+                    }
+                }
+
+                acc0 = vaddw_u16(acc0, vget_low_u16(sum_lo));
+                acc1 = vaddw_u16(acc1, vget_high_u16(sum_lo));
+                acc2 = vaddw_u16(acc2, vget_low_u16(sum_hi));
+                acc3 = vaddw_u16(acc3, vget_high_u16(sum_hi));
+            }
+
+            vst1q_u32(sads + candidate, acc0);
+            vst1q_u32(sads + candidate + 4, acc1);
+            vst1q_u32(sads + candidate + 8, acc2);
+            vst1q_u32(sads + candidate + 12, acc3);
+        }
+    #elif defined(SSVL_NEON)
+        for(; candidate+16 <= candidate_count; candidate+=16){
+            uint32x4_t acc0 = vdupq_n_u32(0), acc1 = vdupq_n_u32(0), acc2 = vdupq_n_u32(0), acc3 = vdupq_n_u32(0);
+
+            for(uint16_t y=0; y<window_dimensions; y++){
+                const uint16_t *original_row = original_cam_buffer + (original_window_y+y)*ssvl->width + original_window_x;
+                const uint16_t *compare_row = compare_cam_buffer + (compare_window_y+y)*ssvl->width + compare_window_x + candidate;
+
+                for(uint16_t x=0; x<window_dimensions; x++){
+                    const uint16x4_t original_sample = vdup_n_u16(original_row[x]);
+                    const uint16x8_t compare_lo = vld1q_u16(compare_row + x);
+                    const uint16x8_t compare_hi = vld1q_u16(compare_row + x + 8);
+
+                    // Widening absolute difference and accumulate
+                    acc0 = vabal_u16(acc0, vget_low_u16(compare_lo), original_sample);
+                    acc1 = vabal_u16(acc1, vget_high_u16(compare_lo), original_sample);
+                    acc2 = vabal_u16(acc2, vget_low_u16(compare_hi), original_sample);
+                    acc3 = vabal_u16(acc3, vget_high_u16(compare_hi), original_sample);
+                }
+            }
+
+            vst1q_u32(sads + candidate, acc0);
+            vst1q_u32(sads + candidate + 4, acc1);
+            vst1q_u32(sads + candidate + 8, acc2);
+            vst1q_u32(sads + candidate + 12, acc3);
+        }
+    #endif
+
+    // Scalar reference for whatever candidates are left over
+    for(; candidate<candidate_count; candidate++){
+        sads[candidate] = ssvl_sad_comparer(ssvl, original_cam_buffer, compare_cam_buffer,
+                                            original_window_x, original_window_y,
+                                            compare_window_x + candidate, compare_window_y,
+                                            window_dimensions);
+    }
+}
+
+
+// Number of set bits, a single instruction where the compiler has one for the target
+SSVL_FUNC uint32_t ssvl_popcount(uint32_t bits){
+    #if defined(__GNUC__) || defined(__clang__)
+        return (uint32_t)__builtin_popcount(bits);
+    #else
+        bits = bits - ((bits >> 1) & 0x55555555u);
+        bits = (bits & 0x33333333u) + ((bits >> 2) & 0x33333333u);
+        return (((bits + (bits >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+    #endif
+}
+
+
+// Census descriptors of the eye whose frame buffer is `cam_buffer`
+SSVL_FUNC const uint32_t *ssvl_census_buffer(ssvl_t *ssvl, const ssvl_gray_t *cam_buffer){
+    return ssvl->census_buffers[(cam_buffer == ssvl->frame_buffers[SSVL_RIGHT_CAMERA]) ? SSVL_RIGHT_CAMERA : SSVL_LEFT_CAMERA];
+}
+
+
+// Hamming distance between the census descriptors of two windows: how many of the neighbour
+// comparisons differ over all pixels of the windows (see `ssvl_config_t.census`, required).
+// The frame buffers passed in only pick which eye's descriptors are used
+SSVL_KERNEL_FUNC uint32_t ssvl_census_comparer(ssvl_t *ssvl, ssvl_gray_t *original_cam_buffer, ssvl_gray_t *compare_cam_buffer,
+                                        uint16_t original_window_x, uint16_t original_window_y,
+                                        uint16_t compare_window_x, uint16_t compare_window_y,
+                                        uint8_t window_dimensions){
+    const uint32_t *original_census = ssvl_census_buffer(ssvl, original_cam_buffer);
+    const uint32_t *compare_census = ssvl_census_buffer(ssvl, compare_cam_buffer);
+    uint32_t distance = 0;
+
+    for(uint16_t y=0; y<window_dimensions; y++){
+        const uint32_t *original_row = original_census + (original_window_y+y)*ssvl->width + original_window_x;
+        const uint32_t *compare_row = compare_census + (compare_window_y+y)*ssvl->width + compare_window_x;
+
+        for(uint16_t x=0; x<window_dimensions; x++){
+            distance += ssvl_popcount(original_row[x] ^ compare_row[x]);
+        }
+    }
+
+    return distance;
+}
+
+
+// Same as `ssvl_census_comparer` but scores `candidate_count` windows at once like
+// `ssvl_sad_multi_comparer`, bit-identical results. Each original descriptor is broadcast
+// against neighbouring candidates (AVX2: 8, NEON: 4) and bits are counted per byte (nibble
+// table lookups on AVX2) and summed in 16-bit lanes for a row of the window
+SSVL_KERNEL_FUNC void ssvl_census_multi_comparer(ssvl_t *ssvl, ssvl_gray_t *original_cam_buffer, ssvl_gray_t *compare_cam_buffer,
+                                          uint16_t original_window_x, uint16_t original_window_y,
+                                          uint16_t compare_window_x, uint16_t compare_window_y,
+                                          uint8_t window_dimensions, uint16_t candidate_count, uint32_t *distances){
+    uint16_t candidate = 0;
+
+    #if defined(SSVL_AVX2) || defined(SSVL_NEON)
+        const uint32_t *original_census = ssvl_census_buffer(ssvl, original_cam_buffer);
+        const uint32_t *compare_census = ssvl_census_buffer(ssvl, compare_cam_buffer);
+    #endif
+
+    #if defined(SSVL_AVX2)
+        const __m256i nibble_bits = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                     0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i low_nibbles = _mm256_set1_epi8(0x0F);
+        const __m256i ones8 = _mm256_set1_epi8(1);
+        const __m256i ones16 = _mm256_set1_epi16(1);
+
+        for(; candidate+8 <= candidate_count; candidate+=8){
+            __m256i acc = _mm256_setzero_si256();
+
+            for(uint16_t y=0; y<window_dimensions; y++){
+                const uint32_t *original_row = original_census + (original_window_y+y)*ssvl->width + original_window_x;
+                const uint32_t *compare_row = compare_census + (compare_window_y+y)*ssvl->width + compare_window_x + candidate;
+                __m256i row_sums = _mm256_setzero_si256();
+
+                for(uint16_t x=0; x<window_dimensions; x++){
+                    const __m256i differing = _mm256_xor_si256(_mm256_set1_epi32((int)original_row[x]), _mm256_loadu_si256((const __m256i*)(compare_row + x)));
+                    const __m256i byte_bits = _mm256_add_epi8(_mm256_shuffle_epi8(nibble_bits, _mm256_and_si256(differing, low_nibbles)),
+                                                              _mm256_shuffle_epi8(nibble_bits, _mm256_and_si256(_mm256_srli_epi16(differing, 4), low_nibbles)));
+
+                    // Pairs of bytes to 16-bit, at most 16*255 after a row
+                    row_sums = _mm256_add_epi16(row_sums, _mm256_maddubs_epi16(byte_bits, ones8));
+                }
+
+                acc = _mm256_add_epi32(acc, _mm256_madd_epi16(row_sums, ones16));
+            }
+
+            _mm256_storeu_si256((__m256i*)(distances + candidate), acc);
+        }
+    #elif defined(SSVL_NEON)
+        for(; candidate+4 <= candidate_count; candidate+=4){
+            uint32x4_t acc = vdupq_n_u32(0);
+
+            for(uint16_t y=0; y<window_dimensions; y++){
+                const uint32_t *original_row = original_census + (original_window_y+y)*ssvl->width + original_window_x;
+                const uint32_t *compare_row = compare_census + (compare_window_y+y)*ssvl->width + compare_window_x + candidate;
+                uint16x8_t row_sums = vdupq_n_u16(0);
+
+                for(uint16_t x=0; x<window_dimensions; x++){
+                    const uint32x4_t differing = veorq_u32(vdupq_n_u32(original_row[x]), vld1q_u32(compare_row + x));
+                    row_sums = vpadalq_u8(row_sums, vcntq_u8(vreinterpretq_u8_u32(differing)));
+                }
+
+                acc = vpadalq_u16(acc, row_sums);
+            }
+
+            vst1q_u32(distances + candidate, acc);
+        }
+    #endif
+
+    for(; candidate<candidate_count; candidate++){
+        distances[candidate] = ssvl_census_comparer(ssvl, original_cam_buffer, compare_cam_buffer,
+                                                    original_window_x, original_window_y,
+                                                    compare_window_x + candidate, compare_window_y,
+                                                    window_dimensions);
+    }
+}
+
+
+// ///////////////////////////////////////////
+//           SPECIALIZED COMPARERS
+// vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
+
+#if defined(SSVL_AVX2) && defined(SSVL_GRAY8)
+    // Picks both 128-bit lanes' 4 byte block of the original and offset into the candidates for `_mm256_mpsadbw_epu8`
+    #define SSVL_MPSADBW_BLOCK(block, offset) ((block) | ((offset) << 2) | ((block) << 3) | ((offset) << 5))
+
+    // Batched SAD of windows 4, 8 or 16 pixels wide, a constant once inlined: `mpsadbw` sums |L-R|
+    // of a 4 pixel run of the original row against 8 neighbouring candidates at once (per 128-bit
+    // lane, the upper lane is candidates 8 ~ 15). A whole 16x16 window still fits 16-bit sums.
+    // Scores blocks of 16 candidates while the loads stay inside the last candidate window and
+    // returns how many candidates it scored
+    SSVL_KERNEL_FUNC uint16_t ssvl_sad_mpsadbw_comparer(ssvl_t *ssvl, ssvl_gray_t *original_cam_buffer, ssvl_gray_t *compare_cam_buffer,
+                                                        uint16_t original_window_x, uint16_t original_window_y,
+                                                        uint16_t compare_window_x, uint16_t compare_window_y,
+                                                        uint8_t window_dimensions, uint16_t candidate_count, uint32_t *sads){
+        uint16_t candidate = 0;
+
+        for(; candidate+24 <= candidate_count; candidate+=16){
+            __m256i sums = _mm256_setzero_si256();
+
+            for(uint16_t y=0; y<window_dimensions; y++){
+                const uint8_t *original_row = original_cam_buffer + (original_window_y+y)*ssvl->width + original_window_x;
+                const uint8_t *compare_row = compare_cam_buffer + (compare_window_y+y)*ssvl->width + compare_window_x + candidate;
+                __m128i original_pixels;
+
+                if(window_dimensions == 4){
+                    int32_t pixels;
+                    memcpy(&pixels, original_row, sizeof(pixels));
+                    original_pixels = _mm_cvtsi32_si128(pixels);
+                }else if(window_dimensions == 8){
+                    original_pixels = _mm_loadl_epi64((const __m128i*)original_row);
+                }else{
+                    original_pixels = _mm_loadu_si128((const __m128i*)original_row);
+                }
+
+                const __m256i original = _mm256_broadcastsi128_si256(original_pixels);
+                const __m256i compare = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)compare_row)),
+                                                                _mm_loadu_si128((const __m128i*)(compare_row + 8)), 1);
+
+                sums = _mm256_add_epi16(sums, _mm256_mpsadbw_epu8(compare, original, SSVL_MPSADBW_BLOCK(0, 0)));
+
+                if(window_dimensions >= 8){
+                    sums = _mm256_add_epi16(sums, _mm256_mpsadbw_epu8(compare, original, SSVL_MPSADBW_BLOCK(1, 1)));
+                }
+
+                if(window_dimensions == 16){
+                    const __m256i compare_right = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(compare_row + 8))),
+                                                                          _mm_loadu_si128((const __m128i*)(compare_row + 16)), 1);
+
+                    sums = _mm256_add_epi16(sums, _mm256_mpsadbw_epu8(compare_right, original, SSVL_MPSADBW_BLOCK(2, 0)));
+                    sums = _mm256_add_epi16(sums, _mm256_mpsadbw_epu8(compare_right, original, SSVL_MPSADBW_BLOCK(3, 1)));
+                }
+            }
+
+            _mm256_storeu_si256((__m256i*)(sads + candidate), _mm256_cvtepu16_epi32(_mm256_castsi256_si128(sums)));
+            _mm256_storeu_si256((__m256i*)(sads + candidate + 8), _mm256_cvtepu16_epi32(_mm256_extracti128_si256(sums, 1)));
+        }
+
+        return candidate;
+    }
+#endif
+
+
+// `ssvl_sad_multi_comparer` for specializations, `mpsadbw` first where it applies
+SSVL_KERNEL_FUNC void ssvl_sad_specialized_comparer(ssvl_t *ssvl, ssvl_gray_t *original_cam_buffer, ssvl_gray_t *compare_cam_buffer,
+                                                    uint16_t original_window_x, uint16_t original_window_y,
+                                                    uint16_t compare_window_x, uint16_t compare_window_y,
+                                                    uint8_t window_dimensions, uint16_t candidate_count, uint32_t *sads){
+    uint16_t scored = 0;
+
+    #if defined(SSVL_AVX2) && defined(SSVL_GRAY8)
+        if(window_dimensions == 4 || window_dimensions == 8 || window_dimensions == 16){
+            scored = ssvl_sad_mpsadbw_comparer(ssvl, original_cam_buffer, compare_cam_buffer, original_window_x, original_window_y,
+                                               compare_window_x, compare_window_y, window_dimensions, candidate_count, sads);
+        }
+    #endif
+
+    ssvl_sad_multi_comparer(ssvl, original_cam_buffer, compare_cam_buffer, original_window_x, original_window_y,
+                            compare_window_x + scored, compare_window_y, window_dimensions, candidate_count - scored, sads + scored);
+}
+
+
+// Defines `ssvl_sad_multi_comparer_<dimensions>` and `ssvl_census_multi_comparer_<dimensions>`:
+// the batched comparers with `window_dimensions` fixed at `dimensions` (the argument is ignored).
+// With a constant the compiler can unroll the window loops, keeps whole windows of 8-bit sums in
+// 16-bit lanes without checking when to widen them, and AVX2 builds with `SSVL_GRAY8` use
+// `mpsadbw` for windows 4, 8 and 16 wide. `ssvl_configure` picks the ones built in below for
+// `search_window_dimensions`, other sizes can be added with this macro (or
+// `ssvl::use_window_comparers` in ssvl.hpp) and `ssvl_set_multi_comparers`
+#define SSVL_SPECIALIZE_WINDOW(dimensions)                                                                                              \
+    SSVL_FUNC void ssvl_sad_multi_comparer_##dimensions(ssvl_t *ssvl, ssvl_gray_t *original_cam_buffer, ssvl_gray_t *compare_cam_buffer,   \
+                                                       uint16_t original_window_x, uint16_t original_window_y,                          \
+                                                       uint16_t compare_window_x, uint16_t compare_window_y,                            \
+                                                       uint8_t window_dimensions, uint16_t candidate_count, uint32_t *sads){            \
+        (void)window_dimensions;                                                                                                        \
+        ssvl_sad_specialized_comparer(ssvl, original_cam_buffer, compare_cam_buffer, original_window_x, original_window_y,             \
+                                      compare_window_x, compare_window_y, dimensions, candidate_count, sads);                           \
+    }                                                                                                                                   \
+                                                                                                                                        \
+    SSVL_FUNC void ssvl_census_multi_comparer_##dimensions(ssvl_t *ssvl, ssvl_gray_t *original_cam_buffer, ssvl_gray_t *compare_cam_buffer,\
+                                                          uint16_t original_window_x, uint16_t original_window_y,                       \
+                                                          uint16_t compare_window_x, uint16_t compare_window_y,                         \
+                                                          uint8_t window_dimensions, uint16_t candidate_count, uint32_t *distances){    \
+        (void)window_dimensions;                                                                                                        \
+        ssvl_census_multi_comparer(ssvl, original_cam_buffer, compare_cam_buffer, original_window_x, original_window_y,                \
+                                   compare_window_x, compare_window_y, dimensions, candidate_count, distances);                         \
+    }
+
+// Common window sizes, `#define SSVL_NO_SPECIALIZED_COMPARERS` to only build the generic ones
+#if !defined(SSVL_NO_SPECIALIZED_COMPARERS)
+    SSVL_SPECIALIZE_WINDOW(4)
+    SSVL_SPECIALIZE_WINDOW(5)
+    SSVL_SPECIALIZE_WINDOW(8)
+    SSVL_SPECIALIZE_WINDOW(16)
+#endif
+
+
+// Points `sad_multi_comparer` and `census_multi_comparer` at the built-in specialization for
+// `search_window_dimensions`, or the generic comparers if there isn't one (or it doesn't gain
+// anything, see `SSVL_SPECIALIZE_SAD`)
+SSVL_FUNC void ssvl_select_multi_comparers(ssvl_t *ssvl){
+    ssvl->sad_multi_comparer = ssvl_sad_multi_comparer;
+    ssvl->census_multi_comparer = ssvl_census_multi_comparer;
+
+    #if !defined(SSVL_NO_SPECIALIZED_COMPARERS)
+        switch(ssvl->search_window_dimensions){
+            case 4:
+                ssvl->sad_multi_comparer = ssvl_sad_multi_comparer_4;
+                ssvl->census_multi_comparer = ssvl_census_multi_comparer_4;
+            break;
+            case 5:
+                ssvl->sad_multi_comparer = ssvl_sad_multi_comparer_5;
+                ssvl->census_multi_comparer = ssvl_census_multi_comparer_5;
+            break;
+            case 8:
+                ssvl->sad_multi_comparer = ssvl_sad_multi_comparer_8;
+                ssvl->census_multi_comparer = ssvl_census_multi_comparer_8;
+            break;
+            case 16:
+                ssvl->sad_multi_comparer = ssvl_sad_multi_comparer_16;
+                ssvl->census_multi_comparer = ssvl_census_multi_comparer_16;
+            break;
+        }
+
+        #if !defined(SSVL_SPECIALIZE_SAD)
+            ssvl->sad_multi_comparer = ssvl_sad_multi_comparer;
+        #endif
+    #endif
+}
+
+
+// ///////////////////////////////////////////
+//                  MEMORY
+// vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
+
+// Reserves `size` bytes of the library's memory block at the next `SSVL_MEMORY_ALIGNMENT` boundary
+// after `offset` (block offsets, the block itself is aligned) and moves `offset` past them. Returns
+// where they are, NULL when `memory` is NULL and the block is only being measured
+SSVL_FUNC void *ssvl_carve(uint8_t *memory, size_t *offset, size_t size){
+    const size_t start = (*offset + SSVL_MEMORY_ALIGNMENT - 1) & ~(size_t)(SSVL_MEMORY_ALIGNMENT - 1);
+    *offset = start + size;
+
+    return (memory != NULL) ? memory + start : NULL;
+}
+
+
+// ///////////////////////////////////////////
+//                 THREADING
+// vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
+
+// Runs `task` for every index 0 ~ task_count-1 through `parallel_for`
+// if set, otherwise in order on the calling thread as worker 0
+SSVL_FUNC void ssvl_parallel_for(ssvl_t *ssvl, uint32_t task_count, ssvl_task_t task, void *task_ctx){
+    if(ssvl->parallel_for != NULL){
+        ssvl->parallel_for(ssvl->parallel_opaque_ptr, task_count, task, task_ctx);
+        return;
+    }
+
+    for(uint32_t task_index=0; task_index<task_count; task_index++){
+        task(task_ctx, task_index, 0);
+    }
+}
+
+
+#if defined(SSVL_PTHREADS)
+
+// Default pool: threads sleep until `ssvl_thread_pool_parallel_for` publishes
+// a job and then pull task indices one at a time from a shared counter until
+// none are left. Pulling single rows keeps every thread busy even though rows
+// can take very different amounts of time
+typedef struct ssvl_thread_pool_t{
+    pthread_mutex_t mutex;
+    pthread_cond_t job_cond;                    // Signalled when a job is published or the pool stops
+    pthread_cond_t done_cond;                   // Signalled when the last pool thread leaves a job
+
+    pthread_t *threads;
+    uint8_t thread_count;                       // Pool threads, the thread calling `parallel_for` also works
+
+    ssvl_task_t task;
+    void *task_ctx;
+    uint32_t task_count;
+    uint32_t next_task_index;
+    uint32_t busy_thread_count;                 // Pool threads that haven't finished with the current job
+    uint32_t job_generation;                    // Increments per job so sleeping threads know there's a new one
+    bool stop;
+}ssvl_thread_pool_t;
+
+
+// Pulls and runs tasks of the current job until there are none left, `mutex` must be held
+SSVL_FUNC void ssvl_thread_pool_work(ssvl_thread_pool_t *pool, uint32_t worker_index){
+    while(pool->next_task_index < pool->task_count){
+        const uint32_t task_index = pool->next_task_index++;
+
+        pthread_mutex_unlock(&pool->mutex);
+        pool->task(pool->task_ctx, task_index, worker_index);
+        pthread_mutex_lock(&pool->mutex);
+    }
+}
+
+
+SSVL_FUNC void *ssvl_thread_pool_thread(void *arg){
+    ssvl_thread_pool_t *pool = (ssvl_thread_pool_t*)((void**)arg)[0];
+    const uint32_t worker_index = (uint32_t)(uintptr_t)((void**)arg)[1];
+    uint32_t seen_generation = 0;
+
+    SSVL_FREE(arg);
+
+    pthread_mutex_lock(&pool->mutex);
+
+    while(true){
+        while(pool->stop == false && pool->job_generation == seen_generation){
+            pthread_cond_wait(&pool->job_cond, &pool->mutex);
+        }
+
+        if(pool->stop){
+            break;
+        }
+
+        seen_generation = pool->job_generation;
+        ssvl_thread_pool_work(pool, worker_index);
+
+        pool->busy_thread_count--;
+        if(pool->busy_thread_count == 0){
+            pthread_cond_signal(&pool->done_cond);
+        }
+    }
+
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+
+// `parallel_for` implementation of the default pool, `parallel_opaque_ptr` is the pool
+SSVL_FUNC void ssvl_thread_pool_parallel_for(void *parallel_opaque_ptr, uint32_t task_count, ssvl_task_t task, void *task_ctx){
+    ssvl_thread_pool_t *pool = (ssvl_thread_pool_t*)parallel_opaque_ptr;
+
+    pthread_mutex_lock(&pool->mutex);
+
+    pool->task = task;
+    pool->task_ctx = task_ctx;
+    pool->task_count = task_count;
+    pool->next_task_index = 0;
+    pool->busy_thread_count = pool->thread_count;
+    pool->job_generation++;
+    pthread_cond_broadcast(&pool->job_cond);
+
+    // The calling thread is the last worker
+    ssvl_thread_pool_work(pool, pool->thread_count);
+
+    while(pool->busy_thread_count > 0){
+        pthread_cond_wait(&pool->done_cond, &pool->mutex);
+    }
+
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+
+// Starts `thread_count` pool threads, returns NULL on failure
+SSVL_FUNC ssvl_thread_pool_t *ssvl_thread_pool_create(uint8_t thread_count){
+    ssvl_thread_pool_t *pool = (ssvl_thread_pool_t*)SSVL_MALLOC(sizeof(ssvl_thread_pool_t));
+    if(pool == NULL){
+        return NULL;
+    }
+
+    memset(pool, 0, sizeof(ssvl_thread_pool_t));
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->job_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+
+    pool->threads = (pthread_t*)SSVL_MALLOC(thread_count * sizeof(pthread_t));
+
+    for(uint8_t i=0; i<thread_count && pool->threads != NULL; i++){
+        // Thread frees its arguments once read
+        void **arg = (void**)SSVL_MALLOC(2 * sizeof(void*));
+        if(arg == NULL){
+            break;
+        }
+
+        arg[0] = pool;
+        arg[1] = (void*)(uintptr_t)i;
+
+        if(pthread_create(&pool->threads[i], NULL, ssvl_thread_pool_thread, arg) != 0){
+            SSVL_FREE(arg);
+            break;
+        }
+
+        pool->thread_count++;
+    }
+
+    return pool;
+}
+
+
+SSVL_FUNC void ssvl_thread_pool_destroy(ssvl_thread_pool_t *pool){
+    pthread_mutex_lock(&pool->mutex);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->job_cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for(uint8_t i=0; i<pool->thread_count; i++){
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->done_cond);
+    pthread_cond_destroy(&pool->job_cond);
+    pthread_mutex_destroy(&pool->mutex);
+
+    SSVL_FREE(pool->threads);
+    SSVL_FREE(pool);
+}
+
+
+// Where each frame slot of the asynchronous pipeline is
+typedef enum ssvl_async_slot_state_enum {SSVL_SLOT_FREE=0, SSVL_SLOT_FILLING=1, SSVL_SLOT_QUEUED=2, SSVL_SLOT_PROCESSING=3} ssvl_async_slot_state;
+
+// Asynchronous pipeline (`ssvl_config_t.async_slots`): the feeding thread fills a slot and queues
+// it, the processing thread (started with the first queued frame) takes the oldest queued slot,
+// processes it with the instance's own buffers pointed at the slot's frames and publishes the
+// depths to `depth_buffer` for `ssvl_poll_depth`/`ssvl_wait_depth`
+typedef struct ssvl_async_t{
+    pthread_mutex_t mutex;
+    pthread_cond_t queued_cond;                 // Signalled when a frame is queued or the pipeline stops
+    pthread_cond_t finished_cond;               // Signalled when a frame is finished (frees a slot and publishes depths)
+    pthread_t thread;
+    bool thread_started;
+    bool stop;
+
+    ssvl_t *ssvl;
+    ssvl_async_policy policy;
+    uint8_t slot_count;
+    uint8_t *slot_states;                       // `ssvl_async_slot_state` of each slot
+    uint32_t *slot_sequences;                   // Sequence number of each slot's frame, set when it's queued
+    uint64_t *slot_fed_bytes;                   // `SSVL_STATS`: bytes fed for each slot's frame, set when it's queued
+    ssvl_gray_t *slot_buffers;                  // Left and right frame of every slot one after the other (`pixel_count` each)
+
+    uint8_t filling_slot;                       // Slot `ssvl_feed` is filling (`ssvl_t.async_feed_buffers` are its frames)
+    uint32_t fed_sequence;                      // Sequence number of the last frame queued
+    uint32_t dropped_frames;                    // Queued frames replaced by newer ones (`SSVL_ASYNC_DROP_OLDEST`)
+    float *depth_buffer;                        // Depths of the last finished frame
+    uint32_t depth_sequence;                    // Its sequence number, 0 until a frame finishes
+    uint32_t taken_sequence;                    // Sequence number of the last depths handed out by `ssvl_poll_depth`/`ssvl_wait_depth`
+}ssvl_async_t;
+
+
+// Carves the pipeline, its slots and depth buffer from the library's memory block (see `ssvl_carve`,
+// only measures them when `memory` is NULL), the thread is started by the first queued frame
+SSVL_FUNC ssvl_async_t *ssvl_async_create(ssvl_t *ssvl, uint8_t *memory, size_t *offset, uint8_t slot_count, ssvl_async_policy policy){
+    ssvl_async_t *async = (ssvl_async_t*)ssvl_carve(memory, offset, sizeof(ssvl_async_t));
+    ssvl_gray_t *slot_buffers = (ssvl_gray_t*)ssvl_carve(memory, offset, (size_t)slot_count * 2 * ssvl->pixel_count * sizeof(ssvl_gray_t));
+    float *depth_buffer = (float*)ssvl_carve(memory, offset, ssvl->depth_cell_count * sizeof(float));
+    uint64_t *slot_fed_bytes = (uint64_t*)ssvl_carve(memory, offset, slot_count * sizeof(uint64_t));
+    uint32_t *slot_sequences = (uint32_t*)ssvl_carve(memory, offset, slot_count * sizeof(uint32_t));
+    uint8_t *slot_states = (uint8_t*)ssvl_carve(memory, offset, slot_count);
+
+    if(memory == NULL){
+        return NULL;
+    }
+
+    memset(async, 0, sizeof(ssvl_async_t));
+    pthread_mutex_init(&async->mutex, NULL);
+    pthread_cond_init(&async->queued_cond, NULL);
+    pthread_cond_init(&async->finished_cond, NULL);
+
+    async->ssvl = ssvl;
+    async->policy = policy;
+    async->slot_count = slot_count;
+    async->slot_buffers = slot_buffers;
+    async->slot_sequences = slot_sequences;
+    async->slot_fed_bytes = slot_fed_bytes;
+    async->slot_states = slot_states;
+    async->depth_buffer = depth_buffer;
+
+    memset(async->slot_states, SSVL_SLOT_FREE, slot_count);
+
+    return async;
+}
+
+
+// Stops the processing thread once it's done with its current frame, frames still queued are dropped
+SSVL_FUNC void ssvl_async_destroy(ssvl_async_t *async){
+    pthread_mutex_lock(&async->mutex);
+    async->stop = true;
+    pthread_cond_broadcast(&async->queued_cond);
+    pthread_mutex_unlock(&async->mutex);
+
+    if(async->thread_started){
+        pthread_join(async->thread, NULL);
+    }
+
+    pthread_cond_destroy(&async->finished_cond);
+    pthread_cond_destroy(&async->queued_cond);
+    pthread_mutex_destroy(&async->mutex);
+}
+
+#endif  // SSVL_PTHREADS
+
+
+// ///////////////////////////////////////////
+//               RECTIFICATION
+// vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
+
+// Rotation matrix (row-major) of the rotation vector `vector`: around its direction by its length in radians
+SSVL_FUNC void ssvl_rotation_matrix(const double vector[3], double matrix[9]){
+    const double angle = sqrt(vector[0]*vector[0] + vector[1]*vector[1] + vector[2]*vector[2]);
+
+    if(angle < 1e-12){
+        const double identity[9] = {1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0};
+        memcpy(matrix, identity, sizeof(identity));
+        return;
+    }
+
+    const double x = vector[0] / angle;
+    const double y = vector[1] / angle;
+    const double z = vector[2] / angle;
+    const double c = cos(angle);
+    const double s = sin(angle);
+    const double t = 1.0 - c;
+
+    matrix[0] = t*x*x + c;      matrix[1] = t*x*y - s*z;    matrix[2] = t*x*z + s*y;
+    matrix[3] = t*x*y + s*z;    matrix[4] = t*y*y + c;      matrix[5] = t*y*z - s*x;
+    matrix[6] = t*x*z - s*y;    matrix[7] = t*y*z + s*x;    matrix[8] = t*z*z + c;
+}
+
+
+// Rotation vector of the rotation matrix `matrix`, the inverse of `ssvl_rotation_matrix` for angles below 180 degrees
+SSVL_FUNC void ssvl_rotation_vector(const double matrix[9], double vector[3]){
+    double c = (matrix[0] + matrix[4] + matrix[8] - 1.0) * 0.5;
+    if(c > 1.0) c = 1.0;
+    if(c < -1.0) c = -1.0;
+
+    const double angle = acos(c);
+    const double s = sin(angle);
+    const double scale = (s > 1e-12) ? angle / (2.0*s) : 0.0;
+
+    vector[0] = (matrix[7] - matrix[5]) * scale;
+    vector[1] = (matrix[2] - matrix[6]) * scale;
+    vector[2] = (matrix[3] - matrix[1]) * scale;
+}
+
+
+// `product` = `a` * `b`, or `a` * `b` transposed, all 3x3 row-major
+SSVL_FUNC void ssvl_multiply_3x3(const double a[9], const double b[9], bool transpose_b, double product[9]){
+    for(uint8_t row=0; row<3; row++){
+        for(uint8_t column=0; column<3; column++){
+            double sum = 0.0;
+
+            for(uint8_t k=0; k<3; k++){
+                sum += a[row*3 + k] * (transpose_b ? b[column*3 + k] : b[k*3 + column]);
+            }
+
+            product[row*3 + column] = sum;
+        }
+    }
+}
+
+
+// Rotations turning each camera into its rectified one (Bouguet's method, as OpenCV's `stereoRectify`):
+// each camera is turned half the rotation between them so they face the same way, then both are
+// turned together so the translation between them lies along the x axis (rows line up)
+SSVL_FUNC void ssvl_rectify_rotations(ssvl_t *ssvl, const ssvl_stereo_calibration_t *calibration){
+    double rotation[9];
+    double half_vector[3];
+    double half_rotation[9];
+
+    for(uint8_t i=0; i<9; i++) rotation[i] = calibration->rotation[i];
+
+    ssvl_rotation_vector(rotation, half_vector);
+
+    for(uint8_t i=0; i<3; i++) half_vector[i] *= -0.5;
+
+    ssvl_rotation_matrix(half_vector, half_rotation);
+
+    // Translation seen from the half turned cameras, and the rotation taking it onto its axis
+    double translation[3];
+
+    for(uint8_t row=0; row<3; row++){
+        translation[row] = half_rotation[row*3 + 0]*calibration->translation[0] + half_rotation[row*3 + 1]*calibration->translation[1] + half_rotation[row*3 + 2]*calibration->translation[2];
+    }
+
+    const uint8_t axis = (fabs(translation[0]) > fabs(translation[1])) ? 0 : 1;
+    double axis_vector[3] = {0.0, 0.0, 0.0};
+    axis_vector[axis] = (translation[axis] > 0.0) ? 1.0 : -1.0;
+
+    double align_vector[3] = {translation[1]*axis_vector[2] - translation[2]*axis_vector[1],
+                              translation[2]*axis_vector[0] - translation[0]*axis_vector[2],
+                              translation[0]*axis_vector[1] - translation[1]*axis_vector[0]};
+    const double align_length = sqrt(align_vector[0]*align_vector[0] + align_vector[1]*align_vector[1] + align_vector[2]*align_vector[2]);
+    const double translation_length = sqrt(translation[0]*translation[0] + translation[1]*translation[1] + translation[2]*translation[2]);
+
+    if(align_length > 0.0 && translation_length > 0.0){
+        const double scale = acos(fabs(translation[axis]) / translation_length) / align_length;
+
+        for(uint8_t i=0; i<3; i++) align_vector[i] *= scale;
+    }
+
+    double align_rotation[9];
+    double rectify_rotations[2][9];
+    ssvl_rotation_matrix(align_vector, align_rotation);
+    ssvl_multiply_3x3(align_rotation, half_rotation, true, rectify_rotations[SSVL_LEFT_CAMERA]);
+    ssvl_multiply_3x3(align_rotation, half_rotation, false, rectify_rotations[SSVL_RIGHT_CAMERA]);
+
+    for(uint8_t side=0; side<2; side++){
+        for(uint8_t i=0; i<9; i++) ssvl->rectify_rotations[side][i] = (float)rectify_rotations[side][i];
+    }
+}
+
+
+// Position (pixels) in `side`'s camera frame that pixel (`x`, `y`) of its rectified frame shows: the
+// rectified camera's ray through it, turned back into `camera` and through its lens distortion.
+// Rays pointing behind the camera give (-1, -1)
+SSVL_FUNC void ssvl_rectify_source_position(ssvl_t *ssvl, const ssvl_camera_intrinsics_t *camera, ssvl_camera_side side, uint16_t x, uint16_t y, double *source_x, double *source_y){
+    const float *rotation = ssvl->rectify_rotations[side];
+    const double ray_x = ((double)x - (ssvl->width - 1)*0.5) / ssvl->focal_length_pixels;
+    const double ray_y = ((double)y - (ssvl->height - 1)*0.5) / ssvl->focal_length_pixels;
+
+    // Transposed rotation, the camera's rotation into the rectified one undone
+    const double camera_x = rotation[0]*ray_x + rotation[3]*ray_y + rotation[6];
+    const double camera_y = rotation[1]*ray_x + rotation[4]*ray_y + rotation[7];
+    const double camera_z = rotation[2]*ray_x + rotation[5]*ray_y + rotation[8];
+
+    if(camera_z < 1e-9){
+        *source_x = -1.0;
+        *source_y = -1.0;
+        return;
+    }
+
+    const double u = camera_x / camera_z;
+    const double v = camera_y / camera_z;
+    const double r2 = u*u + v*v;
+    const double radial = 1.0 + r2*(camera->k1 + r2*(camera->k2 + r2*camera->k3));
+    const double distorted_u = u*radial + 2.0*camera->p1*u*v + camera->p2*(r2 + 2.0*u*u);
+    const double distorted_v = v*radial + camera->p1*(r2 + 2.0*v*v) + 2.0*camera->p2*u*v;
+
+    *source_x = camera->fx*distorted_u + camera->cx;
+    *source_y = camera->fy*distorted_v + camera->cy;
+}
+
+
+// Remap entry of a source position, clamped to the frame so its 2x2 pixels are always inside it
+// (positions outside the frame repeat its edge)
+SSVL_FUNC ssvl_remap_t ssvl_remap_entry(ssvl_t *ssvl, double source_x, double source_y){
+    const double one = (double)(1u << SSVL_REMAP_FRACTION_BITS);
+    ssvl_remap_t remap;
+
+    // NaN fails the first comparison too
+    if(!(source_x > 0.0)) source_x = 0.0;
+    if(!(source_y > 0.0)) source_y = 0.0;
+    if(source_x > ssvl->width - 1) source_x = ssvl->width - 1;
+    if(source_y > ssvl->height - 1) source_y = ssvl->height - 1;
+
+    remap.x = (uint16_t)source_x;
+    remap.y = (uint16_t)source_y;
+    if(remap.x > ssvl->width - 2) remap.x = ssvl->width - 2;
+    if(remap.y > ssvl->height - 2) remap.y = ssvl->height - 2;
+
+    remap.weight_x = (uint8_t)((source_x - remap.x)*one + 0.5);
+    remap.weight_y = (uint8_t)((source_y - remap.y)*one + 0.5);
+
+    return remap;
+}
+
+
+// Streaming: most rows any rectified pixel's source pixels are from its own row, sizes the
+// ring of fed rows (see `ssvl_t.rectify_source_rows`)
+SSVL_FUNC uint32_t ssvl_rectify_max_displacement(ssvl_t *ssvl, const ssvl_stereo_calibration_t *calibration){
+    uint32_t displacement = 0;
+
+    for(uint8_t side=0; side<2; side++){
+        for(uint16_t y=0; y<ssvl->height; y++){
+            for(uint16_t x=0; x<ssvl->width; x++){
+                double source_x;
+                double source_y;
+                ssvl_rectify_source_position(ssvl, &calibration->cameras[side], (ssvl_camera_side)side, x, y, &source_x, &source_y);
+
+                const ssvl_remap_t remap = ssvl_remap_entry(ssvl, source_x, source_y);
+                const uint32_t distance = (remap.y > y) ? remap.y - y : y - remap.y;
+                if(distance + 1 > displacement) displacement = distance + 1;
+            }
+        }
+    }
+
+    return displacement;
+}
+
+
+// Fills `rectify_maps` and, when streaming, the fed rows each rectified row waits for
+// (`rectify_source_ends`) and the rows that have to stay in the ring (`rectify_source_starts`)
+SSVL_FUNC void ssvl_rectify_build_maps(ssvl_t *ssvl, const ssvl_stereo_calibration_t *calibration){
+    for(uint16_t y=0; y<ssvl->height; y++){
+        uint16_t first_row = ssvl->height - 1;
+        uint16_t end_row = 0;
+
+        for(uint8_t side=0; side<2; side++){
+            ssvl_remap_t *map_row = ssvl->rectify_maps[side] + (uint32_t)y*ssvl->width;
+
+            for(uint16_t x=0; x<ssvl->width; x++){
+                double source_x;
+                double source_y;
+                ssvl_rectify_source_position(ssvl, &calibration->cameras[side], (ssvl_camera_side)side, x, y, &source_x, &source_y);
+
+                map_row[x] = ssvl_remap_entry(ssvl, source_x, source_y);
+
+                if(map_row[x].y < first_row) first_row = map_row[x].y;
+                if(map_row[x].y + 2 > end_row) end_row = map_row[x].y + 2;
+            }
+        }
+
+        if(ssvl->streaming){
+            ssvl->rectify_source_starts[y] = first_row;
+            ssvl->rectify_source_ends[y] = end_row;
+        }
+    }
+
+    // Rows are rectified in order, so a row also waits for the rows before it and
+    // source rows stay until no later row reads them
+    if(ssvl->streaming){
+        for(uint16_t y=1; y<ssvl->height; y++){
+            if(ssvl->rectify_source_ends[y] < ssvl->rectify_source_ends[y-1]) ssvl->rectify_source_ends[y] = ssvl->rectify_source_ends[y-1];
+        }
+
+        for(uint16_t y=ssvl->height-1; y>0; y--){
+            if(ssvl->rectify_source_starts[y-1] > ssvl->rectify_source_starts[y]) ssvl->rectify_source_starts[y-1] = ssvl->rectify_source_starts[y];
+        }
+    }
+}
+
+
+// Points `rectify_rows` of `side` at the rows of `source`, `stride` bytes apart and wrapping around
+// after `ring_rows` rows. `gray` if they're grayscale rows fed earlier rather than `input_format`
+SSVL_FUNC void ssvl_rectify_point_rows(ssvl_t *ssvl, ssvl_camera_side side, const uint8_t *source, uint32_t stride, uint16_t ring_rows, bool gray){
+    for(uint16_t y=0; y<ssvl->height; y++){
+        ssvl->rectify_rows[side][y] = source + (uint32_t)(y % ring_rows)*stride;
+    }
+
+    ssvl->rectify_rows_gray = gray;
+}
+
+
+// ///////////////////////////////////////////
+//                POINT CLOUD
+// vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
+
+// Rays through the middle of every depth cell's window (x/z per column, y/z per row), from
+// `focal_length_pixels` and the principal point in the middle of the frame, and an empty voxel table
+SSVL_FUNC void ssvl_init_points(ssvl_t *ssvl){
+    const double window_middle = (ssvl->search_window_dimensions - 1) * 0.5;
+
+    for(uint16_t x=0; x<ssvl->depth_width; x++){
+        ssvl->point_rays_x[x] = (float)(((double)x*ssvl->cell_stride + window_middle - (ssvl->width - 1)*0.5) / ssvl->focal_length_pixels);
+    }
+
+    for(uint16_t y=0; y<ssvl->depth_height; y++){
+        ssvl->point_rays_y[y] = (float)(((double)y*ssvl->cell_stride + window_middle - (ssvl->height - 1)*0.5) / ssvl->focal_length_pixels);
+    }
+
+    if(ssvl->voxel_table != NULL){
+        memset(ssvl->voxel_table, 0, ((size_t)ssvl->voxel_table_mask + 1) * sizeof(ssvl_voxel_t));
+        ssvl->voxel_stamp = 0;
+    }
+}
+
+
+// `when_set` in the lanes set in `mask`, `otherwise` in the rest (SSE2 has no blend)
+#if defined(SSVL_SSE2)
+SSVL_FUNC __m128 ssvl_select_ps(__m128 mask, __m128 when_set, __m128 otherwise){
+    return _mm_or_ps(_mm_and_ps(mask, when_set), _mm_andnot_ps(mask, otherwise));
+}
+#endif
+
+
+// Reprojects row `y` of depth cells to points (see `ssvl_config_t.point_cloud`): z is the cell's
+// depth and x and y are z along its ray, NaN for cells without a depth. Float disparities are
+// converted to depths on the way (the same as `ssvl_disparity_depth`), the ones of 1 ~ width-1
+// pixels have a depth. Compact and voxel points are then packed at the row's start
+SSVL_FUNC void ssvl_reproject_row(ssvl_t *ssvl, uint16_t y){
+    const uint32_t row_start = (uint32_t)y*ssvl->depth_width;
+    const uint32_t depth_width = ssvl->depth_width;
+    float *points_x = ssvl->point_buffers[0] + row_start;
+    float *points_y = ssvl->point_buffers[1] + row_start;
+    float *points_z = ssvl->point_buffers[2] + row_start;
+    const float *rays_x = ssvl->point_rays_x;
+    const float ray_y = ssvl->point_rays_y[y];
+    uint32_t x = 0;
+
+    if(ssvl->output_format == SSVL_OUTPUT_FLOAT){
+        float *row = ssvl->disparity_depth_buffer + row_start;
+        const float focal_baseline = ssvl->focal_length_pixels * ssvl->baseline_mm;
+
+        #if defined(SSVL_AVX2)
+            const __m256 one_256 = _mm256_set1_ps(1.0f);
+            const __m256 width_256 = _mm256_set1_ps((float)ssvl->width);
+            const __m256 focal_baseline_256 = _mm256_set1_ps(focal_baseline);
+            const __m256 max_depth_256 = _mm256_set1_ps(ssvl->max_depth_mm);
+            const __m256 no_point_256 = _mm256_set1_ps(NAN);
+            const __m256 ray_y_256 = _mm256_set1_ps(ray_y);
+
+            for(; x+8 <= depth_width; x+=8){
+                const __m256 disparity = _mm256_loadu_ps(row + x);
+                const __m256 valid = _mm256_and_ps(_mm256_cmp_ps(disparity, one_256, _CMP_GE_OQ), _mm256_cmp_ps(disparity, width_256, _CMP_LT_OQ));
+                const __m256 marked = _mm256_cmp_ps(disparity, _mm256_setzero_ps(), _CMP_LT_OQ);
+                const __m256 depth = _mm256_div_ps(focal_baseline_256, disparity);
+                const __m256 z = _mm256_blendv_ps(no_point_256, depth, valid);
+
+                _mm256_storeu_ps(row + x, _mm256_blendv_ps(_mm256_blendv_ps(max_depth_256, disparity, marked), depth, valid));
+                _mm256_storeu_ps(points_x + x, _mm256_mul_ps(z, _mm256_loadu_ps(rays_x + x)));
+                _mm256_storeu_ps(points_y + x, _mm256_mul_ps(z, ray_y_256));
+                _mm256_storeu_ps(points_z + x, z);
+            }
+        #elif defined(SSVL_SSE2)
+            const __m128 one_128 = _mm_set1_ps(1.0f);
+            const __m128 width_128 = _mm_set1_ps((float)ssvl->width);
+            const __m128 focal_baseline_128 = _mm_set1_ps(focal_baseline);
+            const __m128 max_depth_128 = _mm_set1_ps(ssvl->max_depth_mm);
+            const __m128 no_point_128 = _mm_set1_ps(NAN);
+            const __m128 ray_y_128 = _mm_set1_ps(ray_y);
+
+            for(; x+4 <= depth_width; x+=4){
+                const __m128 disparity = _mm_loadu_ps(row + x);
+                const __m128 valid = _mm_and_ps(_mm_cmpge_ps(disparity, one_128), _mm_cmplt_ps(disparity, width_128));
+                const __m128 marked = _mm_cmplt_ps(disparity, _mm_setzero_ps());
+                const __m128 depth = _mm_div_ps(focal_baseline_128, disparity);
+                const __m128 z = ssvl_select_ps(valid, depth, no_point_128);
+
+                _mm_storeu_ps(row + x, ssvl_select_ps(valid, depth, ssvl_select_ps(marked, disparity, max_depth_128)));
+                _mm_storeu_ps(points_x + x, _mm_mul_ps(z, _mm_loadu_ps(rays_x + x)));
+                _mm_storeu_ps(points_y + x, _mm_mul_ps(z, ray_y_128));
+                _mm_storeu_ps(points_z + x, z);
+            }
+        #elif defined(SSVL_NEON) && defined(__aarch64__)
+            // 32-bit NEON has no division, those depths are divided one at a time below
+            const float32x4_t one_128 = vdupq_n_f32(1.0f);
+            const float32x4_t width_128 = vdupq_n_f32((float)ssvl->width);
+            const float32x4_t focal_baseline_128 = vdupq_n_f32(focal_baseline);
+            const float32x4_t max_depth_128 = vdupq_n_f32(ssvl->max_depth_mm);
+            const float32x4_t no_point_128 = vdupq_n_f32(NAN);
+
+            for(; x+4 <= depth_width; x+=4){
+                const float32x4_t disparity = vld1q_f32(row + x);
+                const uint32x4_t valid = vandq_u32(vcgeq_f32(disparity, one_128), vcltq_f32(disparity, width_128));
+                const uint32x4_t marked = vcltq_f32(disparity, vdupq_n_f32(0.0f));
+                const float32x4_t depth = vdivq_f32(focal_baseline_128, disparity);
+                const float32x4_t z = vbslq_f32(valid, depth, no_point_128);
+
+                vst1q_f32(row + x, vbslq_f32(valid, depth, vbslq_f32(marked, disparity, max_depth_128)));
+                vst1q_f32(points_x + x, vmulq_f32(z, vld1q_f32(rays_x + x)));
+                vst1q_f32(points_y + x, vmulq_n_f32(z, ray_y));
+                vst1q_f32(points_z + x, z);
+            }
+        #endif
+
+        for(; x<depth_width; x++){
+            const float disparity = row[x];
+            const bool valid = disparity >= 1.0f && disparity < ssvl->width;
+            const float depth = valid ? focal_baseline / disparity : ((disparity < 0.0f) ? disparity : ssvl->max_depth_mm);
+            const float z = valid ? depth : NAN;
+
+            row[x] = depth;
+            points_x[x] = z * rays_x[x];
+            points_y[x] = z * ray_y;
+            points_z[x] = z;
+        }
+    }else{
+        // Fixed point disparities of at least a pixel that aren't marks or `SSVL_DISPARITY_INVALID`
+        const uint16_t *disparities = ssvl->disparity_u16_buffer + row_start;
+        const uint16_t *depths = ssvl->depth_mm_buffer + row_start;
+        const uint32_t smallest_disparity = 1u << ssvl->disparity_fraction_bits;
+
+        #if defined(SSVL_AVX2)
+            const __m256i smallest_256 = _mm256_set1_epi32((int)smallest_disparity - 1);
+            const __m256i marks_256 = _mm256_set1_epi32(SSVL_CELL_U16_SKIPPED);
+            const __m256 no_point_256 = _mm256_set1_ps(NAN);
+            const __m256 ray_y_256 = _mm256_set1_ps(ray_y);
+
+            for(; x+8 <= depth_width; x+=8){
+                const __m256i disparity = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(disparities + x)));
+                const __m256i valid = _mm256_and_si256(_mm256_cmpgt_epi32(disparity, smallest_256), _mm256_cmpgt_epi32(marks_256, disparity));
+                const __m256 depth = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(depths + x))));
+                const __m256 z = _mm256_blendv_ps(no_point_256, depth, _mm256_castsi256_ps(valid));
+
+                _mm256_storeu_ps(points_x + x, _mm256_mul_ps(z, _mm256_loadu_ps(rays_x + x)));
+                _mm256_storeu_ps(points_y + x, _mm256_mul_ps(z, ray_y_256));
+                _mm256_storeu_ps(points_z + x, z);
+            }
+        #elif defined(SSVL_SSE2)
+            const __m128i smallest_128 = _mm_set1_epi32((int)smallest_disparity - 1);
+            const __m128i marks_128 = _mm_set1_epi32(SSVL_CELL_U16_SKIPPED);
+            const __m128 no_point_128 = _mm_set1_ps(NAN);
+            const __m128 ray_y_128 = _mm_set1_ps(ray_y);
+
+            for(; x+8 <= depth_width; x+=8){
+                const __m128i disparity_16 = _mm_loadu_si128((const __m128i*)(disparities + x));
+                const __m128i depth_16 = _mm_loadu_si128((const __m128i*)(depths + x));
+
+                for(uint32_t half=0; half<2; half++){
+                    const __m128i disparity = (half == 0) ? _mm_unpacklo_epi16(disparity_16, _mm_setzero_si128()) : _mm_unpackhi_epi16(disparity_16, _mm_setzero_si128());
+                    const __m128i depth = (half == 0) ? _mm_unpacklo_epi16(depth_16, _mm_setzero_si128()) : _mm_unpackhi_epi16(depth_16, _mm_setzero_si128());
+                    const __m128i valid = _mm_and_si128(_mm_cmpgt_epi32(disparity, smallest_128), _mm_cmpgt_epi32(marks_128, disparity));
+                    const __m128 z = ssvl_select_ps(_mm_castsi128_ps(valid), _mm_cvtepi32_ps(depth), no_point_128);
+                    const uint32_t lane = x + 4*half;
+
+                    _mm_storeu_ps(points_x + lane, _mm_mul_ps(z, _mm_loadu_ps(rays_x + lane)));
+                    _mm_storeu_ps(points_y + lane, _mm_mul_ps(z, ray_y_128));
+                    _mm_storeu_ps(points_z + lane, z);
+                }
+            }
+        #elif defined(SSVL_NEON)
+            const uint32x4_t smallest_128 = vdupq_n_u32(smallest_disparity);
+            const uint32x4_t marks_128 = vdupq_n_u32(SSVL_CELL_U16_SKIPPED);
+            const float32x4_t no_point_128 = vdupq_n_f32(NAN);
+
+            for(; x+8 <= depth_width; x+=8){
+                const uint16x8_t disparity_16 = vld1q_u16(disparities + x);
+                const uint16x8_t depth_16 = vld1q_u16(depths + x);
+
+                for(uint32_t half=0; half<2; half++){
+                    const uint32x4_t disparity = vmovl_u16((half == 0) ? vget_low_u16(disparity_16) : vget_high_u16(disparity_16));
+                    const uint32x4_t depth = vmovl_u16((half == 0) ? vget_low_u16(depth_16) : vget_high_u16(depth_16));
+                    const uint32x4_t valid = vandq_u32(vcgeq_u32(disparity, smallest_128), vcltq_u32(disparity, marks_128));
+                    const float32x4_t z = vbslq_f32(valid, vcvtq_f32_u32(depth), no_point_128);
+                    const uint32_t lane = x + 4*half;
+
+                    vst1q_f32(points_x + lane, vmulq_f32(z, vld1q_f32(rays_x + lane)));
+                    vst1q_f32(points_y + lane, vmulq_n_f32(z, ray_y));
+                    vst1q_f32(points_z + lane, z);
+                }
+            }
+        #endif
+
+        for(; x<depth_width; x++){
+            const float z = (disparities[x] >= smallest_disparity && disparities[x] < SSVL_CELL_U16_SKIPPED) ? (float)depths[x] : NAN;
+
+            points_x[x] = z * rays_x[x];
+            points_y[x] = z * ray_y;
+            points_z[x] = z;
+        }
+    }
+
+    if(ssvl->point_cloud == SSVL_POINT_CLOUD_DENSE){
+        return;
+    }
+
+    uint32_t count = 0;
+
+    for(x=0; x<depth_width; x++){
+        if(isnan(points_z[x])) continue;
+
+        points_x[count] = points_x[x];
+        points_y[count] = points_y[x];
+        points_z[count] = points_z[x];
+        count++;
+    }
+
+    ssvl->point_row_counts[y] = count;
+}
+
+
+// Cube coordinate of a point coordinate in `voxel_size_mm` units, clamped to fit
+SSVL_FUNC int32_t ssvl_voxel_coordinate(float scaled){
+    const float cube = floorf(scaled);
+    return (cube < -1073741824.0f) ? -1073741824 : ((cube > 1073741824.0f) ? 1073741824 : (int32_t)cube);
+}
+
+
+// Merges the `point_count` points in each cube of `voxel_size_mm` into their mean, in place: a
+// cube's sums are kept where its first point is moved to, never after a point not read yet.
+// The table is only cleared when stamps wrap around, older entries are free
+SSVL_FUNC void ssvl_merge_voxels(ssvl_t *ssvl){
+    float *points_x = ssvl->point_buffers[0];
+    float *points_y = ssvl->point_buffers[1];
+    float *points_z = ssvl->point_buffers[2];
+    ssvl_voxel_t *table = ssvl->voxel_table;
+    const float inverse_size = 1.0f / ssvl->voxel_size_mm;
+    uint32_t voxel_count = 0;
+
+    ssvl->voxel_stamp++;
+
+    if(ssvl->voxel_stamp == 0){
+        memset(table, 0, ((size_t)ssvl->voxel_table_mask + 1) * sizeof(ssvl_voxel_t));
+        ssvl->voxel_stamp = 1;
+    }
+
+    const uint32_t stamp = ssvl->voxel_stamp;
+
+    for(uint32_t i=0; i<ssvl->point_count; i++){
+        const float x = points_x[i];
+        const float y = points_y[i];
+        const float z = points_z[i];
+        const int32_t key_x = ssvl_voxel_coordinate(x * inverse_size);
+        const int32_t key_y = ssvl_voxel_coordinate(y * inverse_size);
+        const int32_t key_z = ssvl_voxel_coordinate(z * inverse_size);
+
+        // Spatial hash of the cube, probing on from there
+        uint32_t slot = ((uint32_t)key_x*73856093u ^ (uint32_t)key_y*19349663u ^ (uint32_t)key_z*83492791u) & ssvl->voxel_table_mask;
+
+        while(table[slot].stamp == stamp && (table[slot].key[0] != key_x || table[slot].key[1] != key_y || table[slot].key[2] != key_z)){
+            slot = (slot + 1) & ssvl->voxel_table_mask;
+        }
+
+        ssvl_voxel_t *voxel = &table[slot];
+
+        if(voxel->stamp != stamp){
+            voxel->stamp = stamp;
+            voxel->point_index = voxel_count;
+            voxel->key[0] = key_x;
+            voxel->key[1] = key_y;
+            voxel->key[2] = key_z;
+
+            points_x[voxel_count] = x;
+            points_y[voxel_count] = y;
+            points_z[voxel_count] = z;
+            ssvl->voxel_counts[voxel_count] = 1;
+            voxel_count++;
+        }else{
+            points_x[voxel->point_index] += x;
+            points_y[voxel->point_index] += y;
+            points_z[voxel->point_index] += z;
+            ssvl->voxel_counts[voxel->point_index]++;
+        }
+    }
+
+    for(uint32_t i=0; i<voxel_count; i++){
+        const float inverse_count = 1.0f / (float)ssvl->voxel_counts[i];
+
+        points_x[i] *= inverse_count;
+        points_y[i] *= inverse_count;
+        points_z[i] *= inverse_count;
+    }
+
+    ssvl->point_count = voxel_count;
+}
+
+
+// Sets `point_count` once every row of the frame is reprojected: compact and voxel rows are
+// moved together (each was packed at its own start) and voxels merged
+SSVL_FUNC void ssvl_finish_points(ssvl_t *ssvl){
+    if(ssvl->point_cloud == SSVL_POINT_CLOUD_DENSE){
+        ssvl->point_count = ssvl->depth_cell_count;
+        return;
+    }
+
+    uint32_t count = 0;
+
+    for(uint16_t y=0; y<ssvl->depth_height; y++){
+        const uint32_t row_start = (uint32_t)y*ssvl->depth_width;
+        const uint32_t row_count = ssvl->point_row_counts[y];
+
+        if(row_start != count && row_count > 0){
+            for(uint8_t axis=0; axis<3; axis++){
+                memmove(ssvl->point_buffers[axis] + count, ssvl->point_buffers[axis] + row_start, row_count * sizeof(float));
+            }
+        }
+
+        count += row_count;
+    }
+
+    ssvl->point_count = count;
+
+    if(ssvl->point_cloud == SSVL_POINT_CLOUD_VOXEL){
+        ssvl_merge_voxels(ssvl);
+    }
+}
+
+
+// ///////////////////////////////////////////
+//         LIBRARY SETUP AND STOPPING
+// vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
+
+// Forgets the previous frame's disparities (see `ssvl_config_t.temporal`), every cell of the
+// next frame searches the whole range. Call after scene cuts or large camera moves
+SSVL_FUNC void ssvl_reset_temporal(ssvl_t *ssvl){
+    if(ssvl->temporal_disparities == NULL) return;
+
+    for(uint32_t i=0; i<ssvl->depth_cell_count; i++){
+        ssvl->temporal_disparities[i] = SSVL_DISPARITY_INVALID;
+    }
+}
+
+
+// Fills `config` with the required settings and defaults for everything else
+SSVL_FUNC void ssvl_config_init(ssvl_config_t *config, uint16_t cameras_width, uint16_t cameras_height, uint8_t search_window_dimensions, float baseline_mm, float fov_degrees){
+    memset(config, 0, sizeof(ssvl_config_t));
+
+    config->cameras_width = cameras_width;
+    config->cameras_height = cameras_height;
+    config->search_window_dimensions = search_window_dimensions;
+    config->baseline_mm = baseline_mm;
+    config->fov_degrees = fov_degrees;
+    config->allocate = true;
+    config->thread_count = 1;
+    config->sgm_p1 = 32;
+    config->sgm_p2 = 256;
+    config->pyramid_radius = 2;
+    config->temporal_radius = 2;
+}
+
+
+// Checks `config` and sets up the instance from it, everything but its buffers (see `ssvl_layout_memory`).
+// Returns `false` and sets `SSVL_STATUS_INVALID_CONFIG` if the configuration can't be used
+SSVL_FUNC bool ssvl_configure(ssvl_t *ssvl, const ssvl_config_t *config){
+    const uint16_t cameras_width = config->cameras_width;
+    const uint16_t cameras_height = config->cameras_height;
+    const uint8_t search_window_dimensions = config->search_window_dimensions;
+
+    ssvl->memory = NULL;
+    ssvl->buffers_set = false;
+    ssvl->custom_buffers_set = false;
+    ssvl->worker_scratch = NULL;
+    ssvl->disparity_histogram = NULL;
+    ssvl->feed_staging = NULL;
+    ssvl->census_buffers[SSVL_LEFT_CAMERA] = NULL;
+    ssvl->census_buffers[SSVL_RIGHT_CAMERA] = NULL;
+    ssvl->disparity_u16_buffer = NULL;
+    ssvl->depth_mm_buffer = NULL;
+    ssvl->depth_mm_lut = NULL;
+    ssvl->sgm_costs = NULL;
+    ssvl->sgm_sums = NULL;
+    ssvl->sgm_path_rows = NULL;
+    ssvl->pyramid_buffers[SSVL_LEFT_CAMERA] = NULL;
+    ssvl->pyramid_buffers[SSVL_RIGHT_CAMERA] = NULL;
+    ssvl->temporal_disparities = NULL;
+    ssvl->cell_mask = NULL;
+    ssvl->masked = false;
+    ssvl->frame_masked = false;
+    ssvl->rows_masked = false;
+    ssvl->frame_queryable = false;
+    ssvl->parallel_for = NULL;
+    ssvl->parallel_opaque_ptr = NULL;
+    ssvl->thread_pool = NULL;
+    ssvl->async = NULL;
+    ssvl->async_feed_buffers[SSVL_LEFT_CAMERA] = NULL;
+    ssvl->async_feed_buffers[SSVL_RIGHT_CAMERA] = NULL;
+    ssvl->rectify_maps[SSVL_LEFT_CAMERA] = NULL;
+    ssvl->rectify_maps[SSVL_RIGHT_CAMERA] = NULL;
+    ssvl->rectify_rows[SSVL_LEFT_CAMERA] = NULL;
+    ssvl->rectify_rows[SSVL_RIGHT_CAMERA] = NULL;
+    ssvl->rectify_rows_gray = false;
+    ssvl->rectify_sources[SSVL_LEFT_CAMERA] = NULL;
+    ssvl->rectify_sources[SSVL_RIGHT_CAMERA] = NULL;
+    ssvl->rectify_source_starts = NULL;
+    ssvl->rectify_source_ends = NULL;
+    ssvl->rectify_rows_done = 0;
+    ssvl->point_rays_x = NULL;
+    ssvl->point_rays_y = NULL;
+    ssvl->point_buffers[0] = NULL;
+    ssvl->point_buffers[1] = NULL;
+    ssvl->point_buffers[2] = NULL;
+    ssvl->point_row_counts = NULL;
+    ssvl->point_count = 0;
+    ssvl->voxel_table = NULL;
+    ssvl->voxel_table_mask = 0;
+    ssvl->voxel_stamp = 0;
+    ssvl->voxel_counts = NULL;
+    ssvl->frame_sequence = 0;
+    memset(&ssvl->stats, 0, sizeof(ssvl_stats_t));
+    ssvl->stats_frame_start_ns = 0;
+    ssvl->stats_stage_start_ns = 0;
+    ssvl->stats_fed_bytes = 0;
+    ssvl->stats_queued_fed_bytes = 0;
+    ssvl->status_code = SSVL_STATUS_OK;
+
+    // if there are no pixels or search window square dimensions are not
+    // a multiple of the width or height, do not create library instance
+    if(cameras_width == 0 || cameras_height == 0 || search_window_dimensions == 0 || cameras_width % search_window_dimensions != 0 || cameras_height % search_window_dimensions != 0){
+        ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_CONFIG);
+        return false;
+    }
+
+    // Streaming bands are rows of cells that don't overlap
+    const uint8_t cell_stride = (config->output_stride == 0) ? search_window_dimensions : config->output_stride;
+
+    if(cell_stride > search_window_dimensions || (config->streaming && cell_stride != search_window_dimensions)){
+        ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_CONFIG);
+        return false;
+    }
+
+    const bool bayer = config->input_format >= SSVL_FORMAT_BAYER_RGGB8;
+
+    // Bayer luma is made from pairs of rows and 2x2 blocks
+    if(config->input_format > SSVL_FORMAT_BAYER_GBRG8 || (bayer && (cameras_height % 2 != 0 || cameras_width < 2))){
+        ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_CONFIG);
+        return false;
+    }
+
+    // Path costs only fit 16 bits with bounded penalties, and whole frames never exist when streaming
+    if(config->sgm > SSVL_SGM_SINGLE_PASS || config->sgm_p1 > config->sgm_p2 || config->sgm_p2 > SSVL_SGM_COST_MAX+1 ||
+       (config->streaming && config->sgm != SSVL_SGM_OFF && config->sgm != SSVL_SGM_SINGLE_PASS)){
+        ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_CONFIG);
+        return false;
+    }
+
+    // The pyramid narrows every cell's own range, other stages need the whole range or whole frames
+    if(config->pyramid_levels > SSVL_PYRAMID_MAX_LEVELS ||
+       (config->pyramid_levels > 1 && (config->sgm != SSVL_SGM_OFF || config->lr_check || config->streaming))){
+        ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_CONFIG);
+        return false;
+    }
+
+    // Same for the temporal bands
+    if(config->temporal && (config->sgm != SSVL_SGM_OFF || config->lr_check)){
+        ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_CONFIG);
+        return false;
+    }
+
+    // The asynchronous pipeline needs a thread and whole frames to queue
+    if(config->async_slots > 1 && (config->streaming || config->async_policy > SSVL_ASYNC_BLOCK)){
+        ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_CONFIG);
+        return false;
+    }
+
+    #if !defined(SSVL_PTHREADS)
+        if(config->async_slots > 1){
+            ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_CONFIG);
+            return false;
+        }
+    #endif
+
+    // The pipeline hands out float depths
+    if(config->output_format > SSVL_OUTPUT_UINT16 || (config->output_format == SSVL_OUTPUT_UINT16 && config->async_slots > 1)){
+        ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_CONFIG);
+        return false;
+    }
+
+    // Rectified pixels are interpolated from 2x2 source pixels through cameras that have to project
+    if(config->rectify){
+        const ssvl_camera_intrinsics_t *cameras = config->calibration.cameras;
+
+        if(cameras_width < 2 || cameras_height < 2 || !(cameras[0].fx > 0.0f && cameras[0].fy > 0.0f && cameras[1].fx > 0.0f && cameras[1].fy > 0.0f)){
+            ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_CONFIG);
+            return false;
+        }
+    }
+
+    // Voxels need a size to merge points in
+    if(config->point_cloud > SSVL_POINT_CLOUD_VOXEL || (config->point_cloud == SSVL_POINT_CLOUD_VOXEL && !(config->voxel_size_mm > 0.0f))){
+        ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_CONFIG);
+        return false;
+    }
+
+    // Track these for later usage
+    ssvl->width = cameras_width;
+    ssvl->height = cameras_height;
+    ssvl->search_window_dimensions = search_window_dimensions;
+    ssvl->baseline_mm = config->baseline_mm;
+    ssvl->field_of_view_degrees = config->fov_degrees;
+
+    // https://answers.opencv.org/question/17076/conversion-focal-distance-from-mm-to-pixels/
+    // https://gamedev.stackexchange.com/questions/166993/interpreting-focal-length-in-units-of-pixels
+    // https://computergraphics.stackexchange.com/questions/10593/is-focal-length-equal-to-the-distance-from-the-optical-center-to-the-near-clippi
+    ssvl->focal_length_pixels = ((float)ssvl->width*0.5f) / tanf(config->fov_degrees * 0.5f * 3.141593f/180.0f);
+
+    // Rectified cameras share the smaller focal length of the calibration, which sets the field of view
+    ssvl->rectify = config->rectify;
+
+    if(ssvl->rectify){
+        const float left_fy = config->calibration.cameras[SSVL_LEFT_CAMERA].fy;
+        const float right_fy = config->calibration.cameras[SSVL_RIGHT_CAMERA].fy;
+
+        ssvl->focal_length_pixels = (left_fy < right_fy) ? left_fy : right_fy;
+        ssvl->field_of_view_degrees = 2.0f * atanf((float)ssvl->width*0.5f / ssvl->focal_length_pixels) * 180.0f/3.141593f;
+        ssvl_rectify_rotations(ssvl, &config->calibration);
+    }
+
+    // https://stackoverflow.com/a/19423059
+    // https://stackoverflow.com/a/75745742
+    ssvl->max_depth_mm = ssvl->focal_length_pixels * ssvl->baseline_mm;
+
+    // A depth cell for every window that fits, `cell_stride` pixels apart
+    ssvl->cell_stride = cell_stride;
+    ssvl->depth_width = (ssvl->width - ssvl->search_window_dimensions) / cell_stride + 1;
+    ssvl->depth_height = (ssvl->height - ssvl->search_window_dimensions) / cell_stride + 1;
+    ssvl->depth_cell_count = ssvl->depth_width * ssvl->depth_height;
+    ssvl->census_band_count = ssvl->height / ssvl->search_window_dimensions;
+
+    // Disparity search range, the right-most cell can't look further left than the image edge.
+    // Depths are converted to disparities through depth = focal_length_pixels * baseline_mm / disparity
+    const uint16_t largest_disparity = (ssvl->depth_width-1) * cell_stride;
+    const float focal_baseline = ssvl->focal_length_pixels * ssvl->baseline_mm;
+    float min_disparity = (float)config->min_disparity;
+    float max_disparity = (config->max_disparity == 0) ? (float)largest_disparity : (float)config->max_disparity;
+
+    if(config->max_depth_mm > 0.0f){
+        min_disparity = ceilf(focal_baseline / config->max_depth_mm);
+        ssvl->max_depth_mm = config->max_depth_mm;
+    }
+
+    if(config->min_depth_mm > 0.0f){
+        max_disparity = floorf(focal_baseline / config->min_depth_mm);
+    }
+
+    if(max_disparity > (float)largest_disparity){
+        max_disparity = (float)largest_disparity;
+    }
+
+    if(min_disparity > max_disparity){
+        ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_CONFIG);
+        return false;
+    }
+
+    ssvl->min_disparity = (uint16_t)min_disparity;
+    ssvl->max_disparity = (uint16_t)max_disparity;
+
+    // Fixed point disparities have to stay below the values marking cells
+    ssvl->output_format = config->output_format;
+    ssvl->disparity_fraction_bits = config->disparity_fraction_bits;
+
+    if(ssvl->output_format == SSVL_OUTPUT_UINT16 && (ssvl->disparity_fraction_bits > 15 || ((uint32_t)ssvl->max_disparity << ssvl->disparity_fraction_bits) >= SSVL_CELL_U16_SKIPPED)){
+        ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_CONFIG);
+        return false;
+    }
+
+    ssvl->active_min_disparity = ssvl->min_disparity;
+    ssvl->active_max_disparity = ssvl->max_disparity;
+    ssvl->adaptive_disparity_range = config->adaptive_disparity_range;
+
+    ssvl->point_cloud = config->point_cloud;
+    ssvl->voxel_size_mm = config->voxel_size_mm;
+
+    ssvl->grayscale_opaque_ptr = NULL;
+    ssvl->on_grayscale_cb = NULL;
+
+    ssvl->disparity_opaque_ptr = NULL;
+    ssvl->on_disparity_cb = NULL;
+
+    ssvl->depth_opaque_ptr = NULL;
+    ssvl->on_depth_cb = NULL;
+
+    ssvl->depth_row_opaque_ptr = NULL;
+    ssvl->on_depth_row_cb = NULL;
+
+    ssvl->points_opaque_ptr = NULL;
+    ssvl->on_points_cb = NULL;
+
+    ssvl->trace_opaque_ptr = NULL;
+    ssvl->on_trace_cb = NULL;
+
+    // Grayscale weight tables, same Rec. 709 luminance weights as `ssvl_convert_rgb565_to_grayscale`
+    // scaled to `SSVL_GRAY_MAX` output with `SSVL_GRAYSCALE_FRACTION_BITS` of fraction
+    const double grayscale_scale = (double)SSVL_GRAY_MAX * (double)(1u << SSVL_GRAYSCALE_FRACTION_BITS);
+    const uint32_t r_weight = (uint32_t)(0.2126 / 31.0 * grayscale_scale + 0.5);
+    const uint32_t g_weight = (uint32_t)(0.7152 / 63.0 * grayscale_scale + 0.5);
+    const uint32_t b_weight = (uint32_t)(0.07122 / 31.0 * grayscale_scale + 0.5);
+
+    for(uint32_t i=0; i<32; i++) ssvl->grayscale_r_lut[i] = i * r_weight;
+    for(uint32_t i=0; i<64; i++) ssvl->grayscale_g_lut[i] = i * g_weight;
+    for(uint32_t i=0; i<32; i++) ssvl->grayscale_b_lut[i] = i * b_weight;
+
+    ssvl->frames_grayscale = false;
+    ssvl->frames_pyramid = false;
+
+    ssvl->input_format = config->input_format;
+    ssvl->input_bytes_per_pixel = (ssvl->input_format == SSVL_FORMAT_GRAY8 || bayer) ? 1 : 2;
+    ssvl->grayscale_task_rows = bayer ? 2 : search_window_dimensions;
+
+    // Every level's window has to fit inside it
+    ssvl->pyramid_levels = (config->pyramid_levels > 1) ? config->pyramid_levels : 1;
+    ssvl->pyramid_radius = config->pyramid_radius;
+
+    while(ssvl->pyramid_levels > 1 && ((ssvl->width >> (ssvl->pyramid_levels-1)) < search_window_dimensions || (ssvl->height >> (ssvl->pyramid_levels-1)) < search_window_dimensions)){
+        ssvl->pyramid_levels--;
+    }
+
+    // Grayscale tasks build the levels from their own rows, so they start on rows that are
+    // multiples of the coarsest level's blocks (the last task of each eye may be shorter)
+    if(ssvl->pyramid_levels > 1){
+        const uint16_t block_rows = 1u << (ssvl->pyramid_levels-1);
+
+        while(ssvl->grayscale_task_rows % block_rows != 0){
+            ssvl->grayscale_task_rows += bayer ? 2 : search_window_dimensions;
+        }
+    }
+
+    // Same weights for 8-bit Bayer samples, every 2x2 block has one red, one blue and two greens
+    // (sharing the green weight). Colors of the 2x2 pattern: 0 red, 1 green, 2 blue
+    if(bayer){
+        static const uint8_t bayer_patterns[4][2][2] = {{{0, 1}, {1, 2}},   // RGGB
+                                                        {{2, 1}, {1, 0}},   // BGGR
+                                                        {{1, 0}, {2, 1}},   // GRBG
+                                                        {{1, 2}, {0, 1}}};  // GBRG
+        const double bayer_scale = ((double)SSVL_GRAY_MAX / 255.0) * (double)(1u << SSVL_BAYER_FRACTION_BITS);
+        const uint32_t color_weights[3] = {(uint32_t)(0.2126 * bayer_scale + 0.5), (uint32_t)(0.7152 * 0.5 * bayer_scale + 0.5), (uint32_t)(0.07122 * bayer_scale + 0.5)};
+        const uint8_t (*pattern)[2] = bayer_patterns[ssvl->input_format - SSVL_FORMAT_BAYER_RGGB8];
+
+        for(uint8_t parity=0; parity<2; parity++){
+            ssvl->bayer_weights[parity][0] = color_weights[pattern[0][parity]];
+            ssvl->bayer_weights[parity][1] = color_weights[pattern[0][parity ^ 1]];
+            ssvl->bayer_weights[parity][2] = color_weights[pattern[1][parity]];
+            ssvl->bayer_weights[parity][3] = color_weights[pattern[1][parity ^ 1]];
+        }
+    }
+
+    // Set the default algorithm that compares pixel
+    // blocks on 1D search line between left and right
+    // camera eyes
+    ssvl->aggregate_pixel_comparer = ssvl_sad_comparer;
+    ssvl_select_multi_comparers(ssvl);
+
+    ssvl->search_engine = SSVL_ENGINE_WINDOW_SEARCH;
+
+    ssvl->census = config->census;
+
+    if(ssvl->census){
+        ssvl->aggregate_pixel_comparer = ssvl_census_comparer;
+    }
+
+    ssvl->lr_check = config->lr_check;
+
+    // Smallest shift that brings the largest possible window cost down to `SSVL_SGM_COST_MAX`
+    ssvl->sgm = config->sgm;
+    ssvl->sgm_p1 = config->sgm_p1;
+    ssvl->sgm_p2 = config->sgm_p2;
+    ssvl->sgm_cost_shift = 0;
+    ssvl->sgm_disparity_stride = ssvl->max_disparity - ssvl->min_disparity + 1;
+
+    const uint32_t window_pixels = search_window_dimensions * search_window_dimensions;
+    const uint32_t largest_window_cost = ssvl->census ? (SSVL_CENSUS_DIMENSIONS*SSVL_CENSUS_DIMENSIONS - 1) * window_pixels : SSVL_GRAY_MAX * window_pixels;
+
+    while((largest_window_cost >> ssvl->sgm_cost_shift) > SSVL_SGM_COST_MAX){
+        ssvl->sgm_cost_shift++;
+    }
+
+    ssvl->temporal = config->temporal;
+    ssvl->temporal_radius = config->temporal_radius;
+    ssvl->temporal_max_cost = config->temporal_max_cost;
+
+    if(ssvl->temporal_max_cost == 0){
+        ssvl->temporal_max_cost = window_pixels * (ssvl->census ? SSVL_TEMPORAL_CENSUS_PIXEL_COST : SSVL_TEMPORAL_SAD_PIXEL_COST);
+    }
+
+    ssvl->worker_count = (config->thread_count > 0) ? config->thread_count : 1;
+
+    // Rows of overlapping cells only add and drop `cell_stride` pixel rows to the cost volume column
+    // sums of the row above (if the search is a cost volume). That beats summing the window's rows
+    // again once windows are several strides tall, smaller ones lose more to the larger working set.
+    // Each search task is then a few consecutive rows so workers keep their sums going
+    ssvl->share_rows = 4*cell_stride < search_window_dimensions &&
+                       (ssvl->lr_check || ssvl->sgm != SSVL_SGM_OFF || (ssvl->temporal == false && ssvl->pyramid_levels == 1));
+    ssvl->search_task_rows = 1;
+
+    if(ssvl->share_rows){
+        const uint32_t task_count = 4 * ssvl->worker_count;
+        ssvl->search_task_rows = (uint16_t)((ssvl->depth_height + task_count - 1) / task_count);
+    }
+
+    // Calculate number of pixels and elements in frame and depth buffers
+    ssvl->pixel_count = cameras_width*cameras_height;
+    ssvl->frame_buffer_size = ssvl->pixel_count * ssvl->input_bytes_per_pixel;
+    ssvl->disparity_depth_buffer_size = ssvl->depth_cell_count * sizeof(float);
+
+    ssvl->frame_buffers_amounts[SSVL_LEFT_CAMERA] = 0;
+    ssvl->frame_buffers_amounts[SSVL_RIGHT_CAMERA] = 0;
+
+    // Streaming only keeps a ring of bands, one being searched and at least one being fed
+    // (plus the rows census reads above and below the one being searched)
+    ssvl->streaming = config->streaming;
+    ssvl->stream_next_band = 0;
+    ssvl->frame_buffer_rows = ssvl->height;
+
+    if(ssvl->streaming){
+        const uint32_t min_ring_bands = 2 + (ssvl->census ? (2*SSVL_CENSUS_RADIUS + search_window_dimensions - 1) / search_window_dimensions : 0);
+
+        uint32_t ring_bands = (config->stream_ring_rows + search_window_dimensions - 1) / search_window_dimensions;
+        if(ring_bands < min_ring_bands) ring_bands = min_ring_bands;
+        if(ring_bands > ssvl->depth_height) ring_bands = ssvl->depth_height;
+
+        ssvl->frame_buffer_rows = (uint16_t)(ring_bands * search_window_dimensions);
+    }
+
+    // Fed rows wait in a ring of their own until the rows rectified from them are searched, so it
+    // holds as many rows as the frame buffers' ring plus those around each row it's rectified from
+    // (and a pair of Bayer rows)
+    ssvl->rectify_source_rows = ssvl->height;
+
+    if(ssvl->rectify && ssvl->streaming){
+        const uint32_t source_rows = ssvl->frame_buffer_rows + 2*ssvl_rectify_max_displacement(ssvl, &config->calibration) + 4;
+
+        if(source_rows < ssvl->height) ssvl->rectify_source_rows = (uint16_t)source_rows;
+    }
+
+    return true;
+}
+
+
+// Lays out every buffer of an instance set up by `ssvl_configure` in one block of memory (each
+// aligned, see `ssvl_carve`) and points the instance at them. Returns the size of the block, only
+// measuring it when `memory` is NULL
+SSVL_FUNC size_t ssvl_layout_memory(ssvl_t *ssvl, const ssvl_config_t *config, uint8_t *memory){
+    size_t offset = 0;
+
+    // Worker scratch is small: for the cost volume engine, a row of column sums and rows of window
+    // costs and best costs/disparities. The `ssvl_worker_scratch_t` array is followed by each worker's memory
+    const uint32_t sgm_path_size = (ssvl->sgm != SSVL_SGM_OFF) ? 2 * (ssvl->sgm_disparity_stride + 3) : 0;
+    const uint32_t right_size = ssvl->lr_check ? ssvl->width : 0;
+    const uint32_t worker_scratch_size = (ssvl->width + 2*ssvl->depth_width + right_size) * sizeof(uint32_t) + (ssvl->depth_width + right_size + sgm_path_size) * sizeof(uint16_t);
+
+    ssvl->worker_scratch = (ssvl_worker_scratch_t*)ssvl_carve(memory, &offset, ssvl->worker_count * sizeof(ssvl_worker_scratch_t));
+
+    for(uint8_t worker_index=0; worker_index<ssvl->worker_count; worker_index++){
+        uint8_t *worker_memory = (uint8_t*)ssvl_carve(memory, &offset, worker_scratch_size);
+        uint32_t *row_column_sums = NULL;
+
+        if(ssvl->share_rows){
+            row_column_sums = (uint32_t*)ssvl_carve(memory, &offset, (size_t)ssvl->sgm_disparity_stride * ssvl->width * sizeof(uint32_t));
+        }
+
+        if(memory == NULL){
+            continue;
+        }
+
+        ssvl_worker_scratch_t *scratch = &ssvl->worker_scratch[worker_index];
+        scratch->column_sums = (uint32_t*)worker_memory;
+        scratch->cell_best_costs = scratch->column_sums + ssvl->width;
+        scratch->cell_window_costs = scratch->cell_best_costs + ssvl->depth_width;
+        scratch->right_best_costs = scratch->cell_window_costs + ssvl->depth_width;
+        scratch->cell_disparities = (uint16_t*)(scratch->right_best_costs + right_size);
+        scratch->right_disparities = scratch->cell_disparities + ssvl->depth_width;
+        scratch->sgm_paths = scratch->right_disparities + right_size;
+        scratch->row_column_sums = row_column_sums;
+        scratch->shared_row = -1;
+        scratch->temporal_fallbacks = 0;
+        scratch->comparer_calls = 0;
+        scratch->candidates = 0;
+    }
+
+    if(ssvl->adaptive_disparity_range){
+        ssvl->disparity_histogram = (uint32_t*)ssvl_carve(memory, &offset, (ssvl->max_disparity + 1) * sizeof(uint32_t));
+    }
+
+    if(ssvl->input_format >= SSVL_FORMAT_BAYER_RGGB8){
+        ssvl->feed_staging = (uint8_t*)ssvl_carve(memory, &offset, 2 * 2 * ssvl->width);
+    }
+
+    // Rectification maps and source row pointers, and where fed frames wait to be rectified (the
+    // slots when async)
+    if(ssvl->rectify){
+        for(uint8_t side=0; side<2; side++){
+            ssvl->rectify_maps[side] = (ssvl_remap_t*)ssvl_carve(memory, &offset, ssvl->pixel_count * sizeof(ssvl_remap_t));
+            ssvl->rectify_rows[side] = (const uint8_t**)ssvl_carve(memory, &offset, ssvl->height * sizeof(const uint8_t*));
+
+            if(config->async_slots <= 1){
+                ssvl->rectify_sources[side] = (ssvl_gray_t*)ssvl_carve(memory, &offset, (size_t)ssvl->rectify_source_rows * ssvl->width * sizeof(ssvl_gray_t));
+            }
+        }
+
+        if(ssvl->streaming){
+            ssvl->rectify_source_starts = (uint16_t*)ssvl_carve(memory, &offset, ssvl->height * sizeof(uint16_t));
+            ssvl->rectify_source_ends = (uint16_t*)ssvl_carve(memory, &offset, ssvl->height * sizeof(uint16_t));
+        }
+    }
+
+    // Descriptors are library scratch, always in the block
+    if(ssvl->census){
+        ssvl->census_buffers[SSVL_LEFT_CAMERA] = (uint32_t*)ssvl_carve(memory, &offset, (size_t)ssvl->frame_buffer_rows * ssvl->width * sizeof(uint32_t));
+        ssvl->census_buffers[SSVL_RIGHT_CAMERA] = (uint32_t*)ssvl_carve(memory, &offset, (size_t)ssvl->frame_buffer_rows * ssvl->width * sizeof(uint32_t));
+    }
+
+    // SGM costs and sums for every cell (a row of cells for a single pass), and two rows of
+    // path buffers for the 3 paths arriving from the row above/below
+    if(ssvl->sgm != SSVL_SGM_OFF){
+        const uint32_t volume_rows = (ssvl->sgm == SSVL_SGM_SINGLE_PASS) ? 1 : ssvl->depth_height;
+        const size_t volume_entries = (size_t)volume_rows * ssvl->depth_width * ssvl->sgm_disparity_stride;
+        const size_t path_row_entries = 3 * 2 * ssvl->depth_width * (ssvl->sgm_disparity_stride + 3);
+
+        ssvl->sgm_costs = (uint16_t*)ssvl_carve(memory, &offset, volume_entries * sizeof(uint16_t));
+        ssvl->sgm_sums = (uint16_t*)ssvl_carve(memory, &offset, volume_entries * sizeof(uint16_t));
+        ssvl->sgm_path_rows = (uint16_t*)ssvl_carve(memory, &offset, path_row_entries * sizeof(uint16_t));
+    }
+
+    // Pyramid levels 1 and up, halving each time
+    if(ssvl->pyramid_levels > 1){
+        uint32_t level_rows = 0;
+
+        for(uint8_t level=1; level<ssvl->pyramid_levels; level++){
+            level_rows += ssvl->height >> level;
+        }
+
+        ssvl->pyramid_buffers[SSVL_LEFT_CAMERA] = (ssvl_gray_t*)ssvl_carve(memory, &offset, level_rows * ssvl->width * sizeof(ssvl_gray_t));
+        ssvl->pyramid_buffers[SSVL_RIGHT_CAMERA] = (ssvl_gray_t*)ssvl_carve(memory, &offset, level_rows * ssvl->width * sizeof(ssvl_gray_t));
+    }
+
+    if(ssvl->temporal){
+        ssvl->temporal_disparities = (uint16_t*)ssvl_carve(memory, &offset, ssvl->depth_cell_count * sizeof(uint16_t));
+    }
+
+    // Cell mask and its per frame states (see `ssvl_grayscale_side_task_count`), small enough
+    // to always be there so setting a mask never allocates
+    const uint32_t side_task_count = (ssvl->height + ssvl->grayscale_task_rows - 1) / ssvl->grayscale_task_rows;
+
+    ssvl->cell_mask = (uint8_t*)ssvl_carve(memory, &offset, ssvl->depth_cell_count);
+    ssvl->cell_computed = (uint8_t*)ssvl_carve(memory, &offset, ssvl->depth_cell_count);
+    ssvl->grayscale_task_states = (uint8_t*)ssvl_carve(memory, &offset, 2 * side_task_count);
+    ssvl->census_band_states = (uint8_t*)ssvl_carve(memory, &offset, 2 * ssvl->census_band_count);
+
+    #if defined(SSVL_PTHREADS)
+        if(config->async_slots > 1){
+            ssvl->async = ssvl_async_create(ssvl, memory, &offset, config->async_slots, config->async_policy);
+        }
+    #endif
+
+    // Fixed point outputs replace the float depth buffer
+    if(ssvl->output_format == SSVL_OUTPUT_UINT16){
+        ssvl->disparity_u16_buffer = (uint16_t*)ssvl_carve(memory, &offset, ssvl->depth_cell_count * sizeof(uint16_t));
+        ssvl->depth_mm_buffer = (uint16_t*)ssvl_carve(memory, &offset, ssvl->depth_cell_count * sizeof(uint16_t));
+        ssvl->depth_mm_lut = (uint16_t*)ssvl_carve(memory, &offset, (ssvl->max_disparity + 1) * sizeof(uint16_t));
+        ssvl->disparity_depth_buffer = NULL;
+    }
+
+    // Points and the rays they're on, and for voxels a table at most half full even if every
+    // point is in a cube of its own
+    if(ssvl->point_cloud != SSVL_POINT_CLOUD_OFF){
+        ssvl->point_rays_x = (float*)ssvl_carve(memory, &offset, ssvl->depth_width * sizeof(float));
+        ssvl->point_rays_y = (float*)ssvl_carve(memory, &offset, ssvl->depth_height * sizeof(float));
+
+        for(uint8_t axis=0; axis<3; axis++){
+            ssvl->point_buffers[axis] = (float*)ssvl_carve(memory, &offset, ssvl->depth_cell_count * sizeof(float));
+        }
+
+        if(ssvl->point_cloud != SSVL_POINT_CLOUD_DENSE){
+            ssvl->point_row_counts = (uint32_t*)ssvl_carve(memory, &offset, ssvl->depth_height * sizeof(uint32_t));
+        }
+
+        if(ssvl->point_cloud == SSVL_POINT_CLOUD_VOXEL){
+            uint32_t table_entries = 1;
+            while(table_entries < 2*ssvl->depth_cell_count) table_entries <<= 1;
+
+            ssvl->voxel_table_mask = table_entries - 1;
+            ssvl->voxel_table = (ssvl_voxel_t*)ssvl_carve(memory, &offset, table_entries * sizeof(ssvl_voxel_t));
+            ssvl->voxel_counts = (uint32_t*)ssvl_carve(memory, &offset, ssvl->depth_cell_count * sizeof(uint32_t));
+        }
+    }
+
+    // Frame buffers and depth buffer, unless the user is going to set them (see `ssvl_set_buffers`)
+    if(config->allocate){
+        ssvl->frame_buffers[SSVL_LEFT_CAMERA] = (ssvl_gray_t*)ssvl_carve(memory, &offset, (size_t)ssvl->frame_buffer_rows * ssvl->width * sizeof(ssvl_gray_t));
+        ssvl->frame_buffers[SSVL_RIGHT_CAMERA] = (ssvl_gray_t*)ssvl_carve(memory, &offset, (size_t)ssvl->frame_buffer_rows * ssvl->width * sizeof(ssvl_gray_t));
+
+        if(ssvl->output_format == SSVL_OUTPUT_FLOAT){
+            ssvl->disparity_depth_buffer = (float*)ssvl_carve(memory, &offset, ssvl->disparity_depth_buffer_size);
+        }
+    }
+
+    return offset;
+}
+
+
+// Finishes `ssvl_init_with_config`/`ssvl_init_with_arena` with the aligned block of memory for the buffers
+SSVL_FUNC void ssvl_init_memory(ssvl_t *ssvl, const ssvl_config_t *config, uint8_t *memory){
+    ssvl_layout_memory(ssvl, config, memory);
+
+    // Every cell starts without a previous disparity
+    ssvl_reset_temporal(ssvl);
+
+    if(ssvl->rectify){
+        ssvl_rectify_build_maps(ssvl, &config->calibration);
+    }
+
+    if(ssvl->point_cloud != SSVL_POINT_CLOUD_OFF){
+        ssvl_init_points(ssvl);
+    }
+
+    // Rounded depth of every disparity, the same as `ssvl_disparity_depth` otherwise
+    if(ssvl->depth_mm_lut != NULL){
+        const float focal_baseline = ssvl->focal_length_pixels * ssvl->baseline_mm;
+
+        for(uint32_t disparity=0; disparity<=ssvl->max_disparity; disparity++){
+            const float depth_mm = (disparity >= 1) ? focal_baseline / (float)disparity : ssvl->max_depth_mm;
+            ssvl->depth_mm_lut[disparity] = (depth_mm + 0.5f < (float)SSVL_DEPTH_MM_MAX) ? (uint16_t)(depth_mm + 0.5f) : SSVL_DEPTH_MM_MAX;
+        }
+    }
+
+    #if defined(SSVL_PTHREADS)
+        if(ssvl->worker_count > 1){
+            ssvl->thread_pool = ssvl_thread_pool_create(ssvl->worker_count - 1);
+
+            // Without a pool rows are processed serially
+            if(ssvl->thread_pool != NULL){
+                ssvl->parallel_for = ssvl_thread_pool_parallel_for;
+                ssvl->parallel_opaque_ptr = ssvl->thread_pool;
+            }
+        }
+    #endif
+
+    // Stop here if user does not want ssvl to make buffers
+    if(config->allocate == false){
+        return;
+    }
+
+    // Indicate that the buffers are ready
+    // and that these are *not* custom buffers
+    // (they are part of the library's memory then)
+    ssvl->buffers_set = true;
+    ssvl->custom_buffers_set = false;
+
+    #if defined(SSVL_DEBUG)
+        SSVL_PRINTF("SSVL:");
+        SSVL_PRINTF("\t width (pixels): \t\t\t\t\t\t%d\n", ssvl->width);
+        SSVL_PRINTF("\t height (pixels): \t\t\t\t\t\t%d\n", ssvl->height);
+        SSVL_PRINTF("\t search_window_dimensions (pixels): \t\t\t\t%d\n", ssvl->search_window_dimensions);
+        SSVL_PRINTF("\t output stride (pixels): \t\t\t\t\t%d\n", ssvl->cell_stride);
+        SSVL_PRINTF("\t baseline (mm): \t\t\t\t\t\t%0.3f\n", ssvl->baseline_mm);
+        SSVL_PRINTF("\t FOV (degrees): \t\t\t\t\t\t%0.3f\n", ssvl->field_of_view_degrees);
+        SSVL_PRINTF("\t focal length (pixels): \t\t\t\t\t%0.3f\n", ssvl->focal_length_pixels);
+        SSVL_PRINTF("\t max depth (mm): \t\t\t\t\t\t%0.3f\n", ssvl->max_depth_mm);
+        SSVL_PRINTF("\t max depth (m): \t\t\t\t\t\t%0.3f\n", ssvl->max_depth_mm/1000.0f);
+        SSVL_PRINTF("\t disparity range (pixels): \t\t\t\t\t%d ~ %d\n", ssvl->min_disparity, ssvl->max_disparity);
+        SSVL_PRINTF("\t frame buffer size (bytes): \t\t\t\t\t%d\n", ssvl->frame_buffer_size);
+        SSVL_PRINTF("\t frame buffer rows (pixels): \t\t\t\t\t%d\n", ssvl->frame_buffer_rows);
+    #endif
+}
+
+
+// Bytes of memory `ssvl_init_with_arena` needs for `config`, every buffer the library will use:
+//  * 2 `ssvl_gray_t` cameras_width*cameras_height frame buffers = 2*sizeof(ssvl_gray_t)*cameras_width*cameras_height bytes
+//    (only a ring of rows when streaming) and 1 32-bit/float depth buffer = 4*depth_width*depth_height bytes, unless
+//    `allocate` is false
+//  * Worker scratch, a few rows of costs per `thread_count`, and the cell mask, 2 bytes per depth cell
+//  * With `census`, 2 `uint32_t` descriptor buffers as big as the frame buffers
+//  * With `sgm`, the cost volume and path buffers: 4*depth_cell_count*disparities bytes for 4 and 8 paths,
+//    4*depth_width*disparities for a single pass
+//  * With `pyramid_levels`, 2 buffers of the levels' rows (less than the frame buffers)
+//  * With `temporal`, a `uint16_t` disparity per depth cell
+//  * With `async_slots` > 1, that many pairs of frame buffers and another depth buffer
+//  * With `rectify`, a 6 byte `ssvl_remap_t` and a row pointer per pixel and row of each camera, and unless
+//    async, 2 more `ssvl_gray_t` frame buffers for fed frames (a ring of rows when streaming)
+//  * With `point_cloud`, 3 float buffers as big as the depth buffer, plus for `SSVL_POINT_CLOUD_VOXEL` 4 bytes
+//    per depth cell and a table of 2 ~ 4 20-byte entries per depth cell
+//
+// Each buffer starts on a `SSVL_MEMORY_ALIGNMENT` boundary, the padding is included. Returns 0
+// if the configuration can't be used
+SSVL_FUNC size_t ssvl_required_memory(const ssvl_config_t *config){
+    ssvl_t ssvl;
+
+    if(ssvl_configure(&ssvl, config) == false){
+        return 0;
+    }
+
+    return ssvl_layout_memory(&ssvl, config, NULL);
+}
+
+
+// Initialize the `ssvl` library from a filled `config` (see `ssvl_config_init`). Allocates every
+// buffer listed by `ssvl_required_memory` as one aligned block (the default pthreads pool's
+// thread handles are allocated on their own).
+//
+// Returns `false` and sets `SSVL_STATUS_INVALID_CONFIG` if the configuration can't be used or
+// `SSVL_STATUS_OUT_OF_MEMORY` if the block can't be allocated
+SSVL_FUNC bool ssvl_init_with_config(ssvl_t *ssvl, const ssvl_config_t *config){
+    if(ssvl_configure(ssvl, config) == false){
+        return false;
+    }
+
+    // Over-allocated to align the block
+    const size_t memory_size = ssvl_layout_memory(ssvl, config, NULL);
+    ssvl->memory = SSVL_MALLOC(memory_size + SSVL_MEMORY_ALIGNMENT - 1);
+
+    if(ssvl->memory == NULL){
+        ssvl_set_status_code(ssvl, SSVL_STATUS_OUT_OF_MEMORY);
+        return false;
+    }
+
+    const uintptr_t address = ((uintptr_t)ssvl->memory + SSVL_MEMORY_ALIGNMENT - 1) & ~(uintptr_t)(SSVL_MEMORY_ALIGNMENT - 1);
+    ssvl_init_memory(ssvl, config, (uint8_t*)address);
+
+    return true;
+}
+
+
+// `ssvl_init_with_config` carving every buffer from `arena` (e.g. a region of fast SRAM) instead of
+// allocating them. `arena` must start on a `SSVL_MEMORY_ALIGNMENT` boundary and hold at least
+// `ssvl_required_memory(config)` bytes, it's the caller's until `ssvl_destroy` and never freed by
+// the library. Nothing else is allocated, apart from the default pthreads pool's thread handles.
+//
+// Returns `false` and sets `SSVL_STATUS_INVALID_CONFIG` if the configuration can't be used or
+// `SSVL_STATUS_INVALID_ARGUMENT` if `arena` is misaligned or too small
+SSVL_FUNC bool ssvl_init_with_arena(ssvl_t *ssvl, const ssvl_config_t *config, void *arena, size_t arena_size){
+    if(ssvl_configure(ssvl, config) == false){
+        return false;
+    }
+
+    if(arena == NULL || (uintptr_t)arena % SSVL_MEMORY_ALIGNMENT != 0 || arena_size < ssvl_layout_memory(ssvl, config, NULL)){
+        ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_ARGUMENT);
+        return false;
+    }
+
+    ssvl_init_memory(ssvl, config, (uint8_t*)arena);
+
+    return true;
+}
+
+
+// Initialize the `ssvl` library with default settings (full disparity range), see `ssvl_init_with_config`.
+//
+// Set `allocate` to `true` if the library should allocate frame and depth buffers, otherwise, set
+// false if you're going to call `ssvl_set_buffers` to reuse memory you may already have allocated
+SSVL_FUNC bool ssvl_init(ssvl_t *ssvl, uint16_t cameras_width, uint16_t cameras_height, uint8_t search_window_dimensions, float baseline_mm, float fov_degrees, bool allocate){
+    ssvl_config_t config;
+    ssvl_config_init(&config, cameras_width, cameras_height, search_window_dimensions, baseline_mm, fov_degrees);
+    config.allocate = allocate;
+
+    return ssvl_init_with_config(ssvl, &config);
+}
+
+
+// If `allocate` was set to `false` in call to `ssvl_init`, use this function
+// to set the 2 frame buffers and 1 depth buffer to custom locations. Returns true
+// if set locations successfully, false (`SSVL_STATUS_INVALID_ARGUMENT`) if not because
+// frame buffers have fewer than `pixel_count` elements (when streaming, they only need
+// `frame_buffer_rows*width`) or the depth buffer fewer than `depth_cell_count`. `SSVL_OUTPUT_UINT16`
+// ignores the depth buffer (NULL, 0 is fine), its buffers are always the library's
+SSVL_FUNC bool ssvl_set_buffers(ssvl_t *ssvl, ssvl_gray_t *frame_buffers[], uint32_t frame_buffers_lengths, float *disparity_depth_buffer, uint32_t disparity_depth_buffer_length){
+    // Check that the buffers are long enough to store information for every camera pixel and depth cell
+    if(frame_buffers_lengths < (uint32_t)ssvl->frame_buffer_rows * ssvl->width || (ssvl->output_format == SSVL_OUTPUT_FLOAT && disparity_depth_buffer_length < ssvl->depth_cell_count)){
+        ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_ARGUMENT);
+        return false;
+    }
+
+    // Set the buffers to the user's custom locations
+    ssvl->frame_buffers[0] = frame_buffers[0];
+    ssvl->frame_buffers[1] = frame_buffers[1];
+    ssvl->disparity_depth_buffer = (ssvl->output_format == SSVL_OUTPUT_FLOAT) ? disparity_depth_buffer : NULL;
+
+    // Buffers are ready and are custom (not do deallocate on deinit of library)
+    ssvl->buffers_set = true;
+    ssvl->custom_buffers_set = true;
+
+    return true;
+}
+
+
+// Pick how `ssvl_process` searches for disparities, see `ssvl_search_engine`
+SSVL_FUNC void ssvl_set_search_engine(ssvl_t *ssvl, ssvl_search_engine search_engine){
+    ssvl->search_engine = search_engine;
+}
+
+
+// Use your own batched comparers for `search_window_dimensions` (e.g. `SSVL_SPECIALIZE_WINDOW`
+// ones for other sizes), NULL keeps the current one. They must give the same costs as
+// `ssvl_sad_multi_comparer` and `ssvl_census_multi_comparer`
+SSVL_FUNC void ssvl_set_multi_comparers(ssvl_t *ssvl, ssvl_multi_comparer_t sad_multi_comparer, ssvl_multi_comparer_t census_multi_comparer){
+    if(sad_multi_comparer != NULL) ssvl->sad_multi_comparer = sad_multi_comparer;
+    if(census_multi_comparer != NULL) ssvl->census_multi_comparer = census_multi_comparer;
+}
+
+
+// Use your own worker pool for `ssvl_process` (see `ssvl_t.parallel_for`), replacing the default
+// pthreads pool if there is one. `parallel_for` must never run more than `ssvl_config_t.thread_count`
+// tasks at once and must pass each running task a different `worker_index` below that
+SSVL_FUNC void ssvl_set_parallel_for(ssvl_t *ssvl,
+                                     void (*parallel_for)(void *parallel_opaque_ptr, uint32_t task_count, ssvl_task_t task, void *task_ctx),
+                                     void *parallel_opaque_ptr){
+    ssvl->parallel_for = parallel_for;
+    ssvl->parallel_opaque_ptr = parallel_opaque_ptr;
+}
+
+
+SSVL_FUNC void ssvl_set_on_grayscale_cb(ssvl_t *ssvl,
+                                        void (*on_grayscale_cb)(void *grayscale_opaque_ptr, ssvl_camera_side side, ssvl_gray_t *grayscale_frame_buffer, uint16_t pixel_width, uint16_t pixel_height),
+                                        void *grayscale_opaque_ptr){
+    ssvl->on_grayscale_cb = on_grayscale_cb;
+    ssvl->grayscale_opaque_ptr = grayscale_opaque_ptr;
+}
+
+
+SSVL_FUNC void ssvl_set_on_disparity_cb(ssvl_t *ssvl,
+                                        void (*on_disparity_cb)(void *disparity_opaque_ptr, float *disparity_buffer, uint16_t disparity_width, uint16_t disparity_height),
+                                        void *disparity_opaque_ptr){
+    ssvl->on_disparity_cb = on_disparity_cb;
+    ssvl->disparity_opaque_ptr = disparity_opaque_ptr;
+}
+
+
+SSVL_FUNC void ssvl_set_on_depth_cb(ssvl_t *ssvl,
+                                    void (*on_depth_cb)(void *depth_opaque_ptr, float *disparity_depth_buffer, uint16_t depth_width, uint16_t depth_height, float max_depth_mm),
+                                    void *depth_opaque_ptr){
+    ssvl->on_depth_cb = on_depth_cb;
+    ssvl->depth_opaque_ptr = depth_opaque_ptr;
+}
+
+
+// Called with each row of depths once it's calculated, in order from the top. When
+// streaming, this is as soon as its band has been fed for both eyes
+SSVL_FUNC void ssvl_set_on_depth_row_cb(ssvl_t *ssvl,
+                                        void (*on_depth_row_cb)(void *depth_row_opaque_ptr, float *depth_row, uint16_t depth_row_index, uint16_t depth_width, float max_depth_mm),
+                                        void *depth_row_opaque_ptr){
+    ssvl->on_depth_row_cb = on_depth_row_cb;
+    ssvl->depth_row_opaque_ptr = depth_row_opaque_ptr;
+}
+
+
+// Called with the frame's points after `on_depth_cb` (see `ssvl_config_t.point_cloud`), the
+// first `point_count` entries of each buffer. Not called without `point_cloud`
+SSVL_FUNC void ssvl_set_on_points_cb(ssvl_t *ssvl,
+                                     void (*on_points_cb)(void *points_opaque_ptr, float *points_x, float *points_y, float *points_z, uint32_t point_count),
+                                     void *points_opaque_ptr){
+    ssvl->on_points_cb = on_points_cb;
+    ssvl->points_opaque_ptr = points_opaque_ptr;
+}
+
+
+// Called at the beginning and end of every `ssvl_stage` of a frame with a `SSVL_STATS_CLOCK_NS`
+// timestamp (once per band when streaming) to lay stages out on a timeline. Only called when
+// built with `SSVL_STATS`
+SSVL_FUNC void ssvl_set_on_trace_cb(ssvl_t *ssvl,
+                                    void (*on_trace_cb)(void *trace_opaque_ptr, ssvl_stage stage, bool begin, uint64_t timestamp_ns),
+                                    void *trace_opaque_ptr){
+    ssvl->on_trace_cb = on_trace_cb;
+    ssvl->trace_opaque_ptr = trace_opaque_ptr;
+}
+
+
+// Give back the memory for various buffers (nothing for an arena, it's the caller's),
+// does not deallocate `ssvl_t` structure
+SSVL_FUNC void ssvl_destroy(ssvl_t *ssvl){
+    // The processing thread may still be using the buffers
+    #if defined(SSVL_PTHREADS)
+        if(ssvl->async != NULL){
+            ssvl_async_destroy((ssvl_async_t*)ssvl->async);
+            ssvl->async = NULL;
+            ssvl->async_feed_buffers[SSVL_LEFT_CAMERA] = NULL;
+            ssvl->async_feed_buffers[SSVL_RIGHT_CAMERA] = NULL;
+        }
+
+        if(ssvl->thread_pool != NULL){
+            ssvl_thread_pool_destroy((ssvl_thread_pool_t*)ssvl->thread_pool);
+            ssvl->thread_pool = NULL;
+        }
+    #endif
+
+    ssvl->parallel_for = NULL;
+    ssvl->parallel_opaque_ptr = NULL;
+
+    // Every library buffer is in the one block, custom buffers are the user's
+    if(ssvl->memory != NULL){
+        SSVL_FREE(ssvl->memory);
+        ssvl->memory = NULL;
+    }
+
+    ssvl->worker_scratch = NULL;
+    ssvl->disparity_histogram = NULL;
+    ssvl->feed_staging = NULL;
+    ssvl->sgm_costs = NULL;
+    ssvl->sgm_sums = NULL;
+    ssvl->sgm_path_rows = NULL;
+    ssvl->pyramid_buffers[SSVL_LEFT_CAMERA] = NULL;
+    ssvl->pyramid_buffers[SSVL_RIGHT_CAMERA] = NULL;
+    ssvl->temporal_disparities = NULL;
+    ssvl->census_buffers[SSVL_LEFT_CAMERA] = NULL;
+    ssvl->census_buffers[SSVL_RIGHT_CAMERA] = NULL;
+    ssvl->disparity_u16_buffer = NULL;
+    ssvl->depth_mm_buffer = NULL;
+    ssvl->depth_mm_lut = NULL;
+    ssvl->rectify_maps[SSVL_LEFT_CAMERA] = NULL;
+    ssvl->rectify_maps[SSVL_RIGHT_CAMERA] = NULL;
+    ssvl->rectify_rows[SSVL_LEFT_CAMERA] = NULL;
+    ssvl->rectify_rows[SSVL_RIGHT_CAMERA] = NULL;
+    ssvl->rectify_sources[SSVL_LEFT_CAMERA] = NULL;
+    ssvl->rectify_sources[SSVL_RIGHT_CAMERA] = NULL;
+    ssvl->rectify_source_starts = NULL;
+    ssvl->rectify_source_ends = NULL;
+    ssvl->point_rays_x = NULL;
+    ssvl->point_rays_y = NULL;
+    ssvl->point_buffers[0] = NULL;
+    ssvl->point_buffers[1] = NULL;
+    ssvl->point_buffers[2] = NULL;
+    ssvl->point_row_counts = NULL;
+    ssvl->point_count = 0;
+    ssvl->voxel_table = NULL;
+    ssvl->voxel_counts = NULL;
+    ssvl->cell_mask = NULL;
+    ssvl->masked = false;
+    ssvl->frame_masked = false;
+    ssvl->rows_masked = false;
+
+    if(ssvl->custom_buffers_set == false){
+        ssvl->frame_buffers[SSVL_LEFT_CAMERA] = NULL;
+        ssvl->frame_buffers[SSVL_RIGHT_CAMERA] = NULL;
+        ssvl->disparity_depth_buffer = NULL;
+    }
+
+    // Reset flags
+    ssvl->buffers_set = false;
+    ssvl->custom_buffers_set = false;
+}
+
+
+// ///////////////////////////////////////////
+//          PRIMARY LIBRARY USAGE
+// vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
+
+// Converts 16-bit RGB565 to 16-bit grayscale
+// https://en.wikipedia.org/wiki/Grayscale#:~:text=Ylinear%2C-,which%20is%20given%20by,-%5B6%5D
+SSVL_FUNC void ssvl_convert_rgb565_to_grayscale(uint16_t *buffer, uint32_t pixel_count){
+    // Masks for bits for each color channel
+    const uint16_t r_mask = 0b1111100000000000;
+    const uint16_t g_mask = 0b0000011111100000;
+    const uint16_t b_mask = 0b0000000000011111;
 
     // Amount to shift right to get bits as normal byte int
     const uint8_t r_shift_amount = 11;
     const uint8_t g_shift_amount = 5;
     const uint8_t b_shift_amount = 0;
 
-    // Total magnitude of each color channel is when all bits
-    // in the channel are 1, which happens to be the mask
-    const uint16_t r_total_magnitude = r_mask >> r_shift_amount;
-    const uint16_t g_total_magnitude = g_mask >> g_shift_amount;
-    const uint16_t b_total_magnitude = b_mask >> b_shift_amount;
+    // Total magnitude of each color channel is when all bits
+    // in the channel are 1, which happens to be the mask
+    const uint16_t r_total_magnitude = r_mask >> r_shift_amount;
+    const uint16_t g_total_magnitude = g_mask >> g_shift_amount;
+    const uint16_t b_total_magnitude = b_mask >> b_shift_amount;
+
+    for(uint32_t i=0; i<pixel_count; i++){
+        // Extract the color channel bits and shift all the way right
+        uint16_t r = (buffer[i] & r_mask) >> r_shift_amount;
+        uint16_t g = (buffer[i] & g_mask) >> g_shift_amount;
+        uint16_t b = (buffer[i] & b_mask) >> b_shift_amount;
+
+        // Normalize each channel to 0.0 ~ 1.0
+        float r_normal = (float)r / (float)r_total_magnitude;
+        float g_normal = (float)g / (float)g_total_magnitude;
+        float b_normal = (float)b / (float)b_total_magnitude;
+
+        // https://en.wikipedia.org/wiki/Grayscale#:~:text=Ylinear%2C-,which%20is%20given%20by,-%5B6%5D
+        // 0.0 ~ 1.0
+        float luminance = 0.2126*r_normal + 0.7152*g_normal + 0.07122*b_normal;
+
+        // Put the linear value back into the buffer for
+        // disparity pixel block comparisons as a int
+        // with 16-bits for resolution
+        buffer[i] = (uint16_t)(luminance * (float)UINT16_MAX);
+    }
+}
+
+
+// Integer version of `ssvl_convert_rgb565_to_grayscale` that reads `pixel_count` native-endian
+// RGB565 pixels from `source` (any alignment) and writes 16-bit grayscale to `destination`
+// (may be the same memory). Uses the fixed-point channel tables built by `ssvl_init` and is
+// within one LSB of the float version. The AVX2/NEON paths multiply by the same weights
+// (the tables are `channel * weight`) so every path gives identical results
+SSVL_FUNC void ssvl_convert_rgb565_to_grayscale_lut(ssvl_t *ssvl, ssvl_gray_t *destination, const uint8_t *source, uint32_t pixel_count){
+    const uint32_t *r_lut = ssvl->grayscale_r_lut;
+    const uint32_t *g_lut = ssvl->grayscale_g_lut;
+    const uint32_t *b_lut = ssvl->grayscale_b_lut;
+    uint32_t i = 0;
+
+    #if defined(SSVL_AVX2)
+        const __m256i r_weight = _mm256_set1_epi32((int)r_lut[1]);
+        const __m256i g_weight = _mm256_set1_epi32((int)g_lut[1]);
+        const __m256i b_weight = _mm256_set1_epi32((int)b_lut[1]);
+        const __m256i six_bits = _mm256_set1_epi32(0x3F);
+        const __m256i five_bits = _mm256_set1_epi32(0x1F);
+
+        for(; i+16 <= pixel_count; i+=16){
+            const __m256i pixels = _mm256_loadu_si256((const __m256i*)(source + i*2));
+            __m256i grays[2];
+
+            for(uint8_t half=0; half<2; half++){
+                const __m256i pixels32 = _mm256_cvtepu16_epi32(half == 0 ? _mm256_castsi256_si128(pixels) : _mm256_extracti128_si256(pixels, 1));
+                const __m256i r = _mm256_srli_epi32(pixels32, 11);
+                const __m256i g = _mm256_and_si256(_mm256_srli_epi32(pixels32, 5), six_bits);
+                const __m256i b = _mm256_and_si256(pixels32, five_bits);
+
+                __m256i sum = _mm256_mullo_epi32(r, r_weight);
+                sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(g, g_weight));
+                sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(b, b_weight));
+                grays[half] = _mm256_srli_epi32(sum, SSVL_GRAYSCALE_FRACTION_BITS);
+            }
+
+            // Pack works within 128-bit lanes, put the 64-bit quarters back in order
+            const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(grays[0], grays[1]), 0xD8);
+
+            #if defined(SSVL_GRAY8)
+                _mm_storeu_si128((__m128i*)(destination + i), _mm_packus_epi16(_mm256_castsi256_si128(packed), _mm256_extracti128_si256(packed, 1)));
+            #else
+                _mm256_storeu_si256((__m256i*)(destination + i), packed);
+            #endif
+        }
+    #elif defined(SSVL_NEON)
+        const uint32x4_t six_bits = vdupq_n_u32(0x3F);
+        const uint32x4_t five_bits = vdupq_n_u32(0x1F);
+
+        for(; i+8 <= pixel_count; i+=8){
+            const uint16x8_t pixels = vreinterpretq_u16_u8(vld1q_u8(source + i*2));
+            uint16x4_t grays[2];
+
+            for(uint8_t half=0; half<2; half++){
+                const uint32x4_t pixels32 = vmovl_u16(half == 0 ? vget_low_u16(pixels) : vget_high_u16(pixels));
+                const uint32x4_t r = vshrq_n_u32(pixels32, 11);
+                const uint32x4_t g = vandq_u32(vshrq_n_u32(pixels32, 5), six_bits);
+                const uint32x4_t b = vandq_u32(pixels32, five_bits);
+
+                uint32x4_t sum = vmulq_n_u32(r, r_lut[1]);
+                sum = vmlaq_n_u32(sum, g, g_lut[1]);
+                sum = vmlaq_n_u32(sum, b, b_lut[1]);
+                grays[half] = vmovn_u32(vshrq_n_u32(sum, SSVL_GRAYSCALE_FRACTION_BITS));
+            }
+
+            #if defined(SSVL_GRAY8)
+                vst1_u8(destination + i, vmovn_u16(vcombine_u16(grays[0], grays[1])));
+            #else
+                vst1q_u16(destination + i, vcombine_u16(grays[0], grays[1]));
+            #endif
+        }
+    #endif
+
+    // Table lookups (3 loads and 2 adds a pixel), no multiplies for cores without fast ones
+    for(; i<pixel_count; i++){
+        uint16_t pixel;
+        memcpy(&pixel, source + i*2, sizeof(uint16_t));
+
+        destination[i] = (ssvl_gray_t)((r_lut[pixel >> 11] + g_lut[(pixel >> 5) & 0x3F] + b_lut[pixel & 0x1F]) >> SSVL_GRAYSCALE_FRACTION_BITS);
+    }
+}
+
+
+// Takes the Y bytes of `pixel_count` YUYV pixels as grayscale, widened to 16-bit (Y*257 so
+// 255 becomes 65535) unless `SSVL_GRAY8`. `destination` may be the same memory as `source`
+SSVL_FUNC void ssvl_convert_yuyv_to_grayscale(ssvl_gray_t *destination, const uint8_t *source, uint32_t pixel_count){
+    uint32_t i = 0;
+
+    #if defined(SSVL_GRAY8)
+        #if defined(SSVL_AVX2)
+            const __m256i luma_mask = _mm256_set1_epi16(0x00FF);
+
+            for(; i+32 <= pixel_count; i+=32){
+                const __m256i luma_lo = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(source + i*2)), luma_mask);
+                const __m256i luma_hi = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(source + i*2 + 32)), luma_mask);
+
+                // Pack works within 128-bit lanes, put the 64-bit quarters back in order
+                _mm256_storeu_si256((__m256i*)(destination + i), _mm256_permute4x64_epi64(_mm256_packus_epi16(luma_lo, luma_hi), 0xD8));
+            }
+        #elif defined(SSVL_SSE2)
+            const __m128i luma_mask = _mm_set1_epi16(0x00FF);
+
+            for(; i+16 <= pixel_count; i+=16){
+                const __m128i luma_lo = _mm_and_si128(_mm_loadu_si128((const __m128i*)(source + i*2)), luma_mask);
+                const __m128i luma_hi = _mm_and_si128(_mm_loadu_si128((const __m128i*)(source + i*2 + 16)), luma_mask);
+                _mm_storeu_si128((__m128i*)(destination + i), _mm_packus_epi16(luma_lo, luma_hi));
+            }
+        #elif defined(SSVL_NEON)
+            for(; i+16 <= pixel_count; i+=16){
+                vst1q_u8(destination + i, vld2q_u8(source + i*2).val[0]);
+            }
+        #endif
+
+        for(; i<pixel_count; i++){
+            destination[i] = source[i*2];
+        }
+    #else
+        #if defined(SSVL_AVX2)
+            const __m256i luma_mask = _mm256_set1_epi16(0x00FF);
+
+            for(; i+16 <= pixel_count; i+=16){
+                const __m256i luma = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(source + i*2)), luma_mask);
+                _mm256_storeu_si256((__m256i*)(destination + i), _mm256_or_si256(luma, _mm256_slli_epi16(luma, 8)));
+            }
+        #elif defined(SSVL_SSE2)
+            const __m128i luma_mask = _mm_set1_epi16(0x00FF);
+
+            for(; i+8 <= pixel_count; i+=8){
+                const __m128i luma = _mm_and_si128(_mm_loadu_si128((const __m128i*)(source + i*2)), luma_mask);
+                _mm_storeu_si128((__m128i*)(destination + i), _mm_or_si128(luma, _mm_slli_epi16(luma, 8)));
+            }
+        #elif defined(SSVL_NEON)
+            const uint16x8_t luma_mask = vdupq_n_u16(0x00FF);
+
+            for(; i+8 <= pixel_count; i+=8){
+                const uint16x8_t luma = vandq_u16(vreinterpretq_u16_u8(vld1q_u8(source + i*2)), luma_mask);
+                vst1q_u16(destination + i, vorrq_u16(luma, vshlq_n_u16(luma, 8)));
+            }
+        #endif
+
+        for(; i<pixel_count; i++){
+            destination[i] = (uint16_t)(source[i*2] * 257);
+        }
+    #endif
+}
+
+
+// Takes `pixel_count` 8-bit gray pixels as grayscale, widened to 16-bit (value*257 so 255
+// becomes 65535) unless `SSVL_GRAY8`. Widening works from the end back so `destination`
+// may be the same memory as `source`
+SSVL_FUNC void ssvl_convert_gray8_to_grayscale(ssvl_gray_t *destination, const uint8_t *source, uint32_t pixel_count){
+    #if defined(SSVL_GRAY8)
+        memmove(destination, source, pixel_count);
+    #else
+        uint32_t i = pixel_count;
+
+        #if defined(SSVL_SSE2) || defined(SSVL_NEON)
+            const uint32_t vector_count = pixel_count & ~15u;
+
+            for(; i>vector_count; i--){
+                destination[i-1] = (uint16_t)(source[i-1] * 257);
+            }
+
+            // Interleaving a byte with itself gives value*257 as a little-endian 16-bit value
+            for(; i>0; i-=16){
+                #if defined(SSVL_SSE2)
+                    const __m128i pixels = _mm_loadu_si128((const __m128i*)(source + i - 16));
+                    _mm_storeu_si128((__m128i*)(destination + i - 8), _mm_unpackhi_epi8(pixels, pixels));
+                    _mm_storeu_si128((__m128i*)(destination + i - 16), _mm_unpacklo_epi8(pixels, pixels));
+                #else
+                    const uint8x16_t pixels = vld1q_u8(source + i - 16);
+                    const uint8x16x2_t widened = vzipq_u8(pixels, pixels);
+                    vst1q_u8((uint8_t*)(destination + i - 8), widened.val[1]);
+                    vst1q_u8((uint8_t*)(destination + i - 16), widened.val[0]);
+                #endif
+            }
+        #endif
+
+        for(; i>0; i--){
+            destination[i-1] = (uint16_t)(source[i-1] * 257);
+        }
+    #endif
+}
+
+
+// Takes `pixel_count` native-endian 16-bit gray pixels as grayscale, narrowed to their
+// high byte with `SSVL_GRAY8`. `destination` may be the same memory as `source`
+SSVL_FUNC void ssvl_convert_gray16_to_grayscale(ssvl_gray_t *destination, const uint8_t *source, uint32_t pixel_count){
+    #if defined(SSVL_GRAY8)
+        for(uint32_t i=0; i<pixel_count; i++){
+            uint16_t pixel;
+            memcpy(&pixel, source + i*2, sizeof(uint16_t));
+            destination[i] = (uint8_t)(pixel >> 8);
+        }
+    #else
+        memmove(destination, source, pixel_count * sizeof(uint16_t));
+    #endif
+}
+
+
+// Luma of the 2x2 block of 8-bit Bayer samples starting at column `x` of a pair of rows
+SSVL_FUNC ssvl_gray_t ssvl_bayer_block_luma(ssvl_t *ssvl, const uint8_t *source_top, const uint8_t *source_bottom, uint32_t x){
+    const uint32_t *weights = ssvl->bayer_weights[x & 1];
+    const uint32_t sum = weights[0]*source_top[x] + weights[1]*source_top[x+1] + weights[2]*source_bottom[x] + weights[3]*source_bottom[x+1];
+
+    return (ssvl_gray_t)(sum >> SSVL_BAYER_FRACTION_BITS);
+}
+
+
+// Luma of a pair of rows of 8-bit Bayer samples: every pixel is the weighted sum of the 2x2
+// block starting at it, which always holds one red, one blue and two green samples, so the
+// full horizontal resolution is kept. Both rows of the pair get the same luma and the last
+// column repeats the one before it. The destinations may be the same memory as the sources:
+// 16-bit grayscale is wider than the samples so columns are converted from the end back,
+// 8-bit from the front
+SSVL_FUNC void ssvl_convert_bayer_to_grayscale(ssvl_t *ssvl, ssvl_gray_t *destination_top, ssvl_gray_t *destination_bottom,
+                                               const uint8_t *source_top, const uint8_t *source_bottom, uint32_t pixel_count){
+    // Blocks of 8 columns (starting on even columns) are vectorized, each is loaded before
+    // it's stored. Columns after the last whole block are done one at a time
+    #if defined(SSVL_SSE2) || defined(SSVL_NEON)
+        const uint32_t block_count = (pixel_count - 1) / 8;
+    #else
+        const uint32_t block_count = 0;
+    #endif
+
+    #if !defined(SSVL_GRAY8)
+        for(uint32_t x=pixel_count-1; x>block_count*8; x--){
+            const ssvl_gray_t gray = ssvl_bayer_block_luma(ssvl, source_top, source_bottom, x-1);
+            destination_top[x-1] = gray;
+            destination_bottom[x-1] = gray;
+        }
+    #endif
+
+    #if defined(SSVL_SSE2)
+        // Pairs of neighbouring samples times pairs of weights (even column, odd column, ...)
+        const uint32_t *even = ssvl->bayer_weights[0];
+        const uint32_t *odd = ssvl->bayer_weights[1];
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i top_weights = _mm_set_epi16((short)odd[1], (short)odd[0], (short)even[1], (short)even[0], (short)odd[1], (short)odd[0], (short)even[1], (short)even[0]);
+        const __m128i bottom_weights = _mm_set_epi16((short)odd[3], (short)odd[2], (short)even[3], (short)even[2], (short)odd[3], (short)odd[2], (short)even[3], (short)even[2]);
+    #elif defined(SSVL_NEON)
+        const uint32_t *even = ssvl->bayer_weights[0];
+        const uint32_t *odd = ssvl->bayer_weights[1];
+        const uint16_t top_left_weights[4] = {(uint16_t)even[0], (uint16_t)odd[0], (uint16_t)even[0], (uint16_t)odd[0]};
+        const uint16_t top_right_weights[4] = {(uint16_t)even[1], (uint16_t)odd[1], (uint16_t)even[1], (uint16_t)odd[1]};
+        const uint16_t bottom_left_weights[4] = {(uint16_t)even[2], (uint16_t)odd[2], (uint16_t)even[2], (uint16_t)odd[2]};
+        const uint16_t bottom_right_weights[4] = {(uint16_t)even[3], (uint16_t)odd[3], (uint16_t)even[3], (uint16_t)odd[3]};
+        const uint16x4_t weights[4] = {vld1_u16(top_left_weights), vld1_u16(top_right_weights), vld1_u16(bottom_left_weights), vld1_u16(bottom_right_weights)};
+    #endif
+
+    #if defined(SSVL_SSE2) || defined(SSVL_NEON)
+        for(uint32_t block=0; block<block_count; block++){
+            #if defined(SSVL_GRAY8)
+                const uint32_t x = block*8;
+            #else
+                const uint32_t x = (block_count - 1 - block)*8;
+            #endif
+
+            #if defined(SSVL_SSE2)
+                const __m128i top = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(source_top + x)), zero);
+                const __m128i top_next = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(source_top + x + 1)), zero);
+                const __m128i bottom = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(source_bottom + x)), zero);
+                const __m128i bottom_next = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(source_bottom + x + 1)), zero);
+
+                __m128i low = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(top, top_next), top_weights), _mm_madd_epi16(_mm_unpacklo_epi16(bottom, bottom_next), bottom_weights));
+                __m128i high = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(top, top_next), top_weights), _mm_madd_epi16(_mm_unpackhi_epi16(bottom, bottom_next), bottom_weights));
+                low = _mm_srli_epi32(low, SSVL_BAYER_FRACTION_BITS);
+                high = _mm_srli_epi32(high, SSVL_BAYER_FRACTION_BITS);
+
+                #if defined(SSVL_GRAY8)
+                    const __m128i grays = _mm_packs_epi32(low, high);
+                    _mm_storel_epi64((__m128i*)(destination_top + x), _mm_packus_epi16(grays, grays));
+                    _mm_storel_epi64((__m128i*)(destination_bottom + x), _mm_packus_epi16(grays, grays));
+                #else
+                    // No unsigned 32 to 16-bit pack in SSE2, shift into signed range and back
+                    const __m128i sign_bias = _mm_set1_epi32(0x8000);
+                    const __m128i grays = _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(low, sign_bias), _mm_sub_epi32(high, sign_bias)), _mm_set1_epi16((short)0x8000));
+                    _mm_storeu_si128((__m128i*)(destination_top + x), grays);
+                    _mm_storeu_si128((__m128i*)(destination_bottom + x), grays);
+                #endif
+            #elif defined(SSVL_NEON)
+                const uint16x8_t samples[4] = {vmovl_u8(vld1_u8(source_top + x)), vmovl_u8(vld1_u8(source_top + x + 1)),
+                                               vmovl_u8(vld1_u8(source_bottom + x)), vmovl_u8(vld1_u8(source_bottom + x + 1))};
+                uint32x4_t low = vmull_u16(vget_low_u16(samples[0]), weights[0]);
+                uint32x4_t high = vmull_u16(vget_high_u16(samples[0]), weights[0]);
+
+                for(uint8_t k=1; k<4; k++){
+                    low = vmlal_u16(low, vget_low_u16(samples[k]), weights[k]);
+                    high = vmlal_u16(high, vget_high_u16(samples[k]), weights[k]);
+                }
+
+                const uint16x8_t grays = vcombine_u16(vshrn_n_u32(low, SSVL_BAYER_FRACTION_BITS), vshrn_n_u32(high, SSVL_BAYER_FRACTION_BITS));
+
+                #if defined(SSVL_GRAY8)
+                    vst1_u8(destination_top + x, vmovn_u16(grays));
+                    vst1_u8(destination_bottom + x, vmovn_u16(grays));
+                #else
+                    vst1q_u16(destination_top + x, grays);
+                    vst1q_u16(destination_bottom + x, grays);
+                #endif
+            #endif
+        }
+    #endif
+
+    #if defined(SSVL_GRAY8)
+        for(uint32_t x=block_count*8; x+1<pixel_count; x++){
+            const ssvl_gray_t gray = ssvl_bayer_block_luma(ssvl, source_top, source_bottom, x);
+            destination_top[x] = gray;
+            destination_bottom[x] = gray;
+        }
+    #endif
+
+    // Last column, no block starts there
+    destination_top[pixel_count-1] = destination_top[pixel_count-2];
+    destination_bottom[pixel_count-1] = destination_bottom[pixel_count-2];
+}
+
+
+// Converts `pixel_count` pixels of a row in `input_format` (other than Bayer, see
+// `ssvl_convert_bayer_to_grayscale`) to 16-bit grayscale. `destination` may be the
+// same memory as `source`
+SSVL_FUNC void ssvl_convert_to_grayscale(ssvl_t *ssvl, ssvl_gray_t *destination, const uint8_t *source, uint32_t pixel_count){
+    switch(ssvl->input_format){
+        case SSVL_FORMAT_YUYV:
+            ssvl_convert_yuyv_to_grayscale(destination, source, pixel_count);
+        break;
+        case SSVL_FORMAT_GRAY8:
+            ssvl_convert_gray8_to_grayscale(destination, source, pixel_count);
+        break;
+        case SSVL_FORMAT_GRAY16:
+            ssvl_convert_gray16_to_grayscale(destination, source, pixel_count);
+        break;
+        default:
+            ssvl_convert_rgb565_to_grayscale_lut(ssvl, destination, source, pixel_count);
+        break;
+    }
+}
+
+
+// Grayscale of source pixel (`x`, `y`) in `source_format` (an `ssvl_input_format` or
+// `SSVL_RECTIFY_GRAY_SOURCE`) through `rows`, the same value the conversions above give
+// it. Bayer pixels are the luma of the 2x2 block at them in their pair of rows
+SSVL_KERNEL_FUNC ssvl_gray_t ssvl_rectify_source_pixel(ssvl_t *ssvl, const uint8_t *const *rows, uint32_t x, uint32_t y, uint8_t source_format){
+    switch(source_format){
+        case SSVL_RECTIFY_GRAY_SOURCE:
+            return ((const ssvl_gray_t*)rows[y])[x];
+        case SSVL_FORMAT_YUYV:
+            #if defined(SSVL_GRAY8)
+                return rows[y][x*2];
+            #else
+                return (ssvl_gray_t)(rows[y][x*2] * 257);
+            #endif
+        case SSVL_FORMAT_GRAY8:
+            #if defined(SSVL_GRAY8)
+                return rows[y][x];
+            #else
+                return (ssvl_gray_t)(rows[y][x] * 257);
+            #endif
+        case SSVL_FORMAT_GRAY16:
+        {
+            uint16_t pixel;
+            memcpy(&pixel, rows[y] + x*2, sizeof(uint16_t));
+
+            #if defined(SSVL_GRAY8)
+                return (ssvl_gray_t)(pixel >> 8);
+            #else
+                return pixel;
+            #endif
+        }
+        case SSVL_FORMAT_RGB565:
+        {
+            uint16_t pixel;
+            memcpy(&pixel, rows[y] + x*2, sizeof(uint16_t));
+
+            return (ssvl_gray_t)((ssvl->grayscale_r_lut[pixel >> 11] + ssvl->grayscale_g_lut[(pixel >> 5) & 0x3F] + ssvl->grayscale_b_lut[pixel & 0x1F]) >> SSVL_GRAYSCALE_FRACTION_BITS);
+        }
+        default:
+        {
+            // The last column repeats the one before it
+            const uint32_t pair_y = y & ~1u;
+            return ssvl_bayer_block_luma(ssvl, rows[pair_y], rows[pair_y + 1], (x + 1 < ssvl->width) ? x : x - 1);
+        }
+    }
+}
+
+
+// Rectified row `y` of `side` into `destination`: every pixel is interpolated from the 2x2 source
+// pixels its `rectify_maps` entry points at, converted to grayscale as they're read. Inlined for
+// each source format by `ssvl_rectify_row` so the format is picked once per row
+SSVL_KERNEL_FUNC void ssvl_rectify_row_format(ssvl_t *ssvl, ssvl_camera_side side, uint16_t y, ssvl_gray_t *destination, uint8_t source_format){
+    const ssvl_remap_t *map_row = ssvl->rectify_maps[side] + (uint32_t)y*ssvl->width;
+    const uint8_t *const *rows = ssvl->rectify_rows[side];
+    const uint32_t one = 1u << SSVL_REMAP_FRACTION_BITS;
+    const uint32_t half = 1u << (2*SSVL_REMAP_FRACTION_BITS - 1);
+
+    for(uint16_t x=0; x<ssvl->width; x++){
+        const ssvl_remap_t remap = map_row[x];
+        const uint32_t top = ssvl_rectify_source_pixel(ssvl, rows, remap.x, remap.y, source_format) * (one - remap.weight_x) +
+                             ssvl_rectify_source_pixel(ssvl, rows, remap.x + 1, remap.y, source_format) * remap.weight_x;
+        const uint32_t bottom = ssvl_rectify_source_pixel(ssvl, rows, remap.x, remap.y + 1, source_format) * (one - remap.weight_x) +
+                                ssvl_rectify_source_pixel(ssvl, rows, remap.x + 1, remap.y + 1, source_format) * remap.weight_x;
+
+        destination[x] = (ssvl_gray_t)((top * (one - remap.weight_y) + bottom * remap.weight_y + half) >> (2*SSVL_REMAP_FRACTION_BITS));
+    }
+}
+
+
+// Rectifies row `y` of `side` from `rectify_rows` into `destination`, see `ssvl_config_t.rectify`
+SSVL_FUNC void ssvl_rectify_row(ssvl_t *ssvl, ssvl_camera_side side, uint16_t y, ssvl_gray_t *destination){
+    if(ssvl->rectify_rows_gray){
+        ssvl_rectify_row_format(ssvl, side, y, destination, SSVL_RECTIFY_GRAY_SOURCE);
+        return;
+    }
+
+    switch(ssvl->input_format){
+        case SSVL_FORMAT_YUYV:
+            ssvl_rectify_row_format(ssvl, side, y, destination, SSVL_FORMAT_YUYV);
+        break;
+        case SSVL_FORMAT_GRAY8:
+            ssvl_rectify_row_format(ssvl, side, y, destination, SSVL_FORMAT_GRAY8);
+        break;
+        case SSVL_FORMAT_GRAY16:
+            ssvl_rectify_row_format(ssvl, side, y, destination, SSVL_FORMAT_GRAY16);
+        break;
+        case SSVL_FORMAT_RGB565:
+            ssvl_rectify_row_format(ssvl, side, y, destination, SSVL_FORMAT_RGB565);
+        break;
+        default:
+            ssvl_rectify_row_format(ssvl, side, y, destination, SSVL_FORMAT_BAYER_RGGB8);
+        break;
+    }
+}
+
+
+// Row of `frame_buffers` that pixel row `y` of the frame is stored in. Frames are stored
+// whole unless streaming, where rows wrap around the ring of `frame_buffer_rows` (always
+// whole bands so a band is contiguous)
+SSVL_FUNC uint16_t ssvl_frame_buffer_row(ssvl_t *ssvl, uint16_t y){
+    return y % ssvl->frame_buffer_rows;
+}
+
+
+// Where pixel `pixel_index` of the frame for `side` is stored in `frame_buffers`
+SSVL_FUNC ssvl_gray_t *ssvl_frame_buffer_pixel(ssvl_t *ssvl, ssvl_camera_side side, uint32_t pixel_index){
+    const uint16_t y = (uint16_t)(pixel_index / ssvl->width);
+    return ssvl->frame_buffers[side] + ssvl_frame_buffer_row(ssvl, y)*ssvl->width + (pixel_index - y*ssvl->width);
+}
+
+
+// Where `ssvl_feed` converts pixel `pixel_index` of the frame for `side` to: `frame_buffers`,
+// the slot being filled when async (slots hold whole frames), or `rectify_sources` to wait there
+// until it's rectified into `frame_buffers`
+SSVL_FUNC ssvl_gray_t *ssvl_feed_buffer_pixel(ssvl_t *ssvl, ssvl_camera_side side, uint32_t pixel_index){
+    if(ssvl->async_feed_buffers[side] != NULL){
+        return ssvl->async_feed_buffers[side] + pixel_index;
+    }
+
+    if(ssvl->rectify){
+        const uint16_t y = (uint16_t)(pixel_index / ssvl->width);
+        return ssvl->rectify_sources[side] + (uint32_t)(y % ssvl->rectify_source_rows)*ssvl->width + (pixel_index - y*ssvl->width);
+    }
+
+    return ssvl_frame_buffer_pixel(ssvl, side, pixel_index);
+}
+
+
+// Census descriptor of pixel `x` of the centre row of `rows` (`SSVL_CENSUS_DIMENSIONS` rows
+// of grayscale around it). A bit per neighbour in row order, the first one the most
+// significant, set if the neighbour is darker. Columns past the edges repeat the edge
+SSVL_FUNC uint32_t ssvl_census_pixel(const ssvl_gray_t *const *rows, uint16_t width, int32_t x){
+    const ssvl_gray_t centre = rows[SSVL_CENSUS_RADIUS][x];
+    uint32_t descriptor = 0;
+
+    for(uint8_t i=0; i<SSVL_CENSUS_DIMENSIONS*SSVL_CENSUS_DIMENSIONS; i++){
+        if(i == SSVL_CENSUS_DIMENSIONS*SSVL_CENSUS_DIMENSIONS/2){
+            continue;
+        }
+
+        int32_t neighbour_x = x + i%SSVL_CENSUS_DIMENSIONS - SSVL_CENSUS_RADIUS;
+        if(neighbour_x < 0) neighbour_x = 0;
+        if(neighbour_x >= width) neighbour_x = width - 1;
+
+        descriptor = (descriptor << 1) | (rows[i/SSVL_CENSUS_DIMENSIONS][neighbour_x] < centre ? 1 : 0);
+    }
+
+    return descriptor;
+}
+
+
+// Census descriptors of a row of `width` pixels (see `ssvl_census_pixel`) into `destination`.
+// Away from the edges pixels are done a vector at a time: each neighbour comparison is a
+// SIMD compare whose all-ones lanes (-1) are shifted into the descriptors as `bits*2 - (-1)`,
+// built in 16-bit (8-bit grayscale: 8-bit) pieces that are interleaved at the end
+SSVL_FUNC void ssvl_census_transform_row(uint32_t *destination, const ssvl_gray_t *const *rows, uint16_t width){
+    int32_t x = 0;
+
+    for(; x<SSVL_CENSUS_RADIUS && x<width; x++){
+        destination[x] = ssvl_census_pixel(rows, width, x);
+    }
+
+    #if defined(SSVL_SSE2) || defined(SSVL_NEON)
+        const uint8_t centre_index = SSVL_CENSUS_DIMENSIONS*SSVL_CENSUS_DIMENSIONS/2;
+    #endif
+
+    #if defined(SSVL_AVX2) && defined(SSVL_GRAY8)
+        const __m256i bias = _mm256_set1_epi8((char)0x80);
+        const __m256i zero = _mm256_setzero_si256();
+
+        for(; x+32+SSVL_CENSUS_RADIUS <= width; x+=32){
+            const __m256i centre = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(rows[SSVL_CENSUS_RADIUS] + x)), bias);
+            __m256i bits[3] = {zero, zero, zero};   // Descriptor bits 16-23 (the first 8 neighbours), 8-15 and 0-7
+            uint8_t neighbour = 0;
+
+            for(uint8_t i=0; i<SSVL_CENSUS_DIMENSIONS*SSVL_CENSUS_DIMENSIONS; i++){
+                if(i == centre_index) continue;
+
+                const ssvl_gray_t *neighbours = rows[i/SSVL_CENSUS_DIMENSIONS] + x + i%SSVL_CENSUS_DIMENSIONS - SSVL_CENSUS_RADIUS;
+                const __m256i darker = _mm256_cmpgt_epi8(centre, _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)neighbours), bias));
+                __m256i *piece = &bits[neighbour/8];
+
+                *piece = _mm256_sub_epi8(_mm256_add_epi8(*piece, *piece), darker);
+                neighbour++;
+            }
+
+            // Per 128-bit lane unpacking: pixels 0-7 and 16-23 from the low halves, 8-15 and 24-31 from the high
+            const __m256i low_words[2] = {_mm256_unpacklo_epi8(bits[2], bits[1]), _mm256_unpackhi_epi8(bits[2], bits[1])};
+            const __m256i high_words[2] = {_mm256_unpacklo_epi8(bits[0], zero), _mm256_unpackhi_epi8(bits[0], zero)};
+
+            for(uint8_t half=0; half<2; half++){
+                const __m256i first = _mm256_unpacklo_epi16(low_words[half], high_words[half]);
+                const __m256i second = _mm256_unpackhi_epi16(low_words[half], high_words[half]);
+
+                _mm256_storeu_si256((__m256i*)(destination + x + half*8), _mm256_permute2x128_si256(first, second, 0x20));
+                _mm256_storeu_si256((__m256i*)(destination + x + half*8 + 16), _mm256_permute2x128_si256(first, second, 0x31));
+            }
+        }
+    #elif defined(SSVL_AVX2)
+        const __m256i bias = _mm256_set1_epi16((short)0x8000);
+
+        for(; x+16+SSVL_CENSUS_RADIUS <= width; x+=16){
+            const __m256i centre = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(rows[SSVL_CENSUS_RADIUS] + x)), bias);
+            __m256i bits[2] = {_mm256_setzero_si256(), _mm256_setzero_si256()};   // Descriptor bits 16-23 (the first 8 neighbours) and 0-15
+            uint8_t neighbour = 0;
+
+            for(uint8_t i=0; i<SSVL_CENSUS_DIMENSIONS*SSVL_CENSUS_DIMENSIONS; i++){
+                if(i == centre_index) continue;
+
+                const ssvl_gray_t *neighbours = rows[i/SSVL_CENSUS_DIMENSIONS] + x + i%SSVL_CENSUS_DIMENSIONS - SSVL_CENSUS_RADIUS;
+                const __m256i darker = _mm256_cmpgt_epi16(centre, _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)neighbours), bias));
+                __m256i *piece = &bits[(neighbour < 8) ? 0 : 1];
+
+                *piece = _mm256_sub_epi16(_mm256_add_epi16(*piece, *piece), darker);
+                neighbour++;
+            }
+
+            // Pixels 0-3 and 8-11 in `first`, 4-7 and 12-15 in `second`
+            const __m256i first = _mm256_unpacklo_epi16(bits[1], bits[0]);
+            const __m256i second = _mm256_unpackhi_epi16(bits[1], bits[0]);
+
+            _mm256_storeu_si256((__m256i*)(destination + x), _mm256_permute2x128_si256(first, second, 0x20));
+            _mm256_storeu_si256((__m256i*)(destination + x + 8), _mm256_permute2x128_si256(first, second, 0x31));
+        }
+    #elif defined(SSVL_SSE2) && defined(SSVL_GRAY8)
+        const __m128i bias = _mm_set1_epi8((char)0x80);
+        const __m128i zero = _mm_setzero_si128();
+
+        for(; x+16+SSVL_CENSUS_RADIUS <= width; x+=16){
+            const __m128i centre = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(rows[SSVL_CENSUS_RADIUS] + x)), bias);
+            __m128i bits[3] = {zero, zero, zero};   // Descriptor bits 16-23 (the first 8 neighbours), 8-15 and 0-7
+            uint8_t neighbour = 0;
+
+            for(uint8_t i=0; i<SSVL_CENSUS_DIMENSIONS*SSVL_CENSUS_DIMENSIONS; i++){
+                if(i == centre_index) continue;
+
+                const ssvl_gray_t *neighbours = rows[i/SSVL_CENSUS_DIMENSIONS] + x + i%SSVL_CENSUS_DIMENSIONS - SSVL_CENSUS_RADIUS;
+                const __m128i darker = _mm_cmpgt_epi8(centre, _mm_xor_si128(_mm_loadu_si128((const __m128i*)neighbours), bias));
+                __m128i *piece = &bits[neighbour/8];
+
+                *piece = _mm_sub_epi8(_mm_add_epi8(*piece, *piece), darker);
+                neighbour++;
+            }
+
+            const __m128i low_words[2] = {_mm_unpacklo_epi8(bits[2], bits[1]), _mm_unpackhi_epi8(bits[2], bits[1])};
+            const __m128i high_words[2] = {_mm_unpacklo_epi8(bits[0], zero), _mm_unpackhi_epi8(bits[0], zero)};
+
+            for(uint8_t half=0; half<2; half++){
+                _mm_storeu_si128((__m128i*)(destination + x + half*8), _mm_unpacklo_epi16(low_words[half], high_words[half]));
+                _mm_storeu_si128((__m128i*)(destination + x + half*8 + 4), _mm_unpackhi_epi16(low_words[half], high_words[half]));
+            }
+        }
+    #elif defined(SSVL_SSE2)
+        const __m128i bias = _mm_set1_epi16((short)0x8000);
+
+        for(; x+8+SSVL_CENSUS_RADIUS <= width; x+=8){
+            const __m128i centre = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(rows[SSVL_CENSUS_RADIUS] + x)), bias);
+            __m128i bits[2] = {_mm_setzero_si128(), _mm_setzero_si128()};   // Descriptor bits 16-23 (the first 8 neighbours) and 0-15
+            uint8_t neighbour = 0;
+
+            for(uint8_t i=0; i<SSVL_CENSUS_DIMENSIONS*SSVL_CENSUS_DIMENSIONS; i++){
+                if(i == centre_index) continue;
+
+                const ssvl_gray_t *neighbours = rows[i/SSVL_CENSUS_DIMENSIONS] + x + i%SSVL_CENSUS_DIMENSIONS - SSVL_CENSUS_RADIUS;
+                const __m128i darker = _mm_cmpgt_epi16(centre, _mm_xor_si128(_mm_loadu_si128((const __m128i*)neighbours), bias));
+                __m128i *piece = &bits[(neighbour < 8) ? 0 : 1];
+
+                *piece = _mm_sub_epi16(_mm_add_epi16(*piece, *piece), darker);
+                neighbour++;
+            }
+
+            _mm_storeu_si128((__m128i*)(destination + x), _mm_unpacklo_epi16(bits[1], bits[0]));
+            _mm_storeu_si128((__m128i*)(destination + x + 4), _mm_unpackhi_epi16(bits[1], bits[0]));
+        }
+    #elif defined(SSVL_NEON) && defined(SSVL_GRAY8)
+        for(; x+16+SSVL_CENSUS_RADIUS <= width; x+=16){
+            const uint8x16_t centre = vld1q_u8(rows[SSVL_CENSUS_RADIUS] + x);
+            uint8x16_t bits[3] = {vdupq_n_u8(0), vdupq_n_u8(0), vdupq_n_u8(0)};   // Descriptor bits 16-23 (the first 8 neighbours), 8-15 and 0-7
+            uint8_t neighbour = 0;
+
+            for(uint8_t i=0; i<SSVL_CENSUS_DIMENSIONS*SSVL_CENSUS_DIMENSIONS; i++){
+                if(i == centre_index) continue;
+
+                const ssvl_gray_t *neighbours = rows[i/SSVL_CENSUS_DIMENSIONS] + x + i%SSVL_CENSUS_DIMENSIONS - SSVL_CENSUS_RADIUS;
+                const uint8x16_t darker = vcltq_u8(vld1q_u8(neighbours), centre);
+
+                bits[neighbour/8] = vsubq_u8(vaddq_u8(bits[neighbour/8], bits[neighbour/8]), darker);
+                neighbour++;
+            }
+
+            const uint8x16x2_t low_words = vzipq_u8(bits[2], bits[1]);
+            const uint8x16x2_t high_words = vzipq_u8(bits[0], vdupq_n_u8(0));
+
+            for(uint8_t half=0; half<2; half++){
+                const uint16x8x2_t descriptors = vzipq_u16(vreinterpretq_u16_u8(low_words.val[half]), vreinterpretq_u16_u8(high_words.val[half]));
+
+                vst1q_u32(destination + x + half*8, vreinterpretq_u32_u16(descriptors.val[0]));
+                vst1q_u32(destination + x + half*8 + 4, vreinterpretq_u32_u16(descriptors.val[1]));
+            }
+        }
+    #elif defined(SSVL_NEON)
+        for(; x+8+SSVL_CENSUS_RADIUS <= width; x+=8){
+            const uint16x8_t centre = vld1q_u16(rows[SSVL_CENSUS_RADIUS] + x);
+            uint16x8_t bits[2] = {vdupq_n_u16(0), vdupq_n_u16(0)};   // Descriptor bits 16-23 (the first 8 neighbours) and 0-15
+            uint8_t neighbour = 0;
+
+            for(uint8_t i=0; i<SSVL_CENSUS_DIMENSIONS*SSVL_CENSUS_DIMENSIONS; i++){
+                if(i == centre_index) continue;
+
+                const ssvl_gray_t *neighbours = rows[i/SSVL_CENSUS_DIMENSIONS] + x + i%SSVL_CENSUS_DIMENSIONS - SSVL_CENSUS_RADIUS;
+                const uint16x8_t darker = vcltq_u16(vld1q_u16(neighbours), centre);
+                const uint8_t piece = (neighbour < 8) ? 0 : 1;
+
+                bits[piece] = vsubq_u16(vaddq_u16(bits[piece], bits[piece]), darker);
+                neighbour++;
+            }
+
+            const uint16x8x2_t descriptors = vzipq_u16(bits[1], bits[0]);
+
+            vst1q_u32(destination + x, vreinterpretq_u32_u16(descriptors.val[0]));
+            vst1q_u32(destination + x + 4, vreinterpretq_u32_u16(descriptors.val[1]));
+        }
+    #endif
+
+    for(; x<width; x++){
+        destination[x] = ssvl_census_pixel(rows, width, x);
+    }
+}
+
+
+// Census descriptors of the rows of band `band_y` (`search_window_dimensions` rows, a row of depth
+// cells unless they overlap) of `side`. Rows up to `SSVL_CENSUS_RADIUS` above and below the band
+// are read, clamped to the frame
+SSVL_FUNC void ssvl_census_band(ssvl_t *ssvl, ssvl_camera_side side, uint16_t band_y){
+    const uint16_t first_y = band_y * ssvl->search_window_dimensions;
+
+    for(uint16_t y=first_y; y<first_y+ssvl->search_window_dimensions; y++){
+        const ssvl_gray_t *rows[SSVL_CENSUS_DIMENSIONS];
+
+        for(int32_t i=0; i<SSVL_CENSUS_DIMENSIONS; i++){
+            int32_t row = y + i - SSVL_CENSUS_RADIUS;
+            if(row < 0) row = 0;
+            if(row >= ssvl->height) row = ssvl->height - 1;
+
+            rows[i] = ssvl->frame_buffers[side] + ssvl_frame_buffer_row(ssvl, (uint16_t)row)*ssvl->width;
+        }
+
+        ssvl_census_transform_row(ssvl->census_buffers[side] + ssvl_frame_buffer_row(ssvl, y)*ssvl->width, rows, ssvl->width);
+    }
+}
+
+
+// Grayscale pixels of `level` of the pyramid of `side` (see `ssvl_config_t.pyramid_levels`),
+// `width >> level` by `height >> level` with rows `width` apart. Level 0 is the frame buffer
+SSVL_FUNC ssvl_gray_t *ssvl_pyramid_level(ssvl_t *ssvl, ssvl_camera_side side, uint8_t level){
+    if(level == 0){
+        return ssvl->frame_buffers[side];
+    }
+
+    uint32_t level_row = 0;
+
+    for(uint8_t below=1; below<level; below++){
+        level_row += ssvl->height >> below;
+    }
+
+    return ssvl->pyramid_buffers[side] + level_row * ssvl->width;
+}
+
+
+// Builds the rows of every pyramid level that only come from pixel rows `first_y` ~ `end_y`-1
+// of `side` (`first_y` a multiple of the coarsest level's blocks), each pixel is the rounded
+// average of a 2x2 block of the level below
+SSVL_FUNC void ssvl_pyramid_rows(ssvl_t *ssvl, ssvl_camera_side side, uint16_t first_y, uint16_t end_y){
+    for(uint8_t level=1; level<ssvl->pyramid_levels; level++){
+        const ssvl_gray_t *below = ssvl_pyramid_level(ssvl, side, level-1);
+        ssvl_gray_t *pixels = ssvl_pyramid_level(ssvl, side, level);
+        const uint16_t level_width = ssvl->width >> level;
+
+        for(uint32_t y=(first_y >> level); y<(uint32_t)(end_y >> level); y++){
+            const ssvl_gray_t *top = below + 2*y*ssvl->width;
+            const ssvl_gray_t *bottom = top + ssvl->width;
+            ssvl_gray_t *row = pixels + y*ssvl->width;
+
+            for(uint32_t x=0; x<level_width; x++){
+                row[x] = (ssvl_gray_t)(((uint32_t)top[2*x] + top[2*x+1] + bottom[2*x] + bottom[2*x+1] + 2) >> 2);
+            }
+        }
+    }
+}
+
+
+// Searches disparities `min_disparity` ~ `max_disparity` (clamped to the left edge of the
+// image) for the cell and returns the one with the smallest `aggregate_pixel_comparer`
+// difference, or `SSVL_DISPARITY_INVALID` if no candidate is in range. If not NULL,
+// `smallest_difference_out` is set to the difference of the returned disparity. Work is
+// counted in the calling worker's `scratch`
+SSVL_FUNC uint16_t ssvl_disparity_search_range(ssvl_t *ssvl, ssvl_worker_scratch_t *scratch, uint16_t left_cell_x, uint16_t left_cell_y,
+                                               uint16_t min_disparity, uint16_t max_disparity,
+                                               uint32_t *smallest_difference_out){
+    // Starting from the same location in the right eye as the left eye,
+    // move window from right to left by a single pixel position amount
+    // starting at position from left eye offset by the smallest disparity
+    const int32_t starting_x = left_cell_x * ssvl->cell_stride;
+    const uint16_t starting_y = ssvl_frame_buffer_row(ssvl, left_cell_y * ssvl->cell_stride);
+
+    // Right-most and left-most candidate windows in the right eye
+    const int32_t first_right_x = starting_x - min_disparity;
+    const int32_t last_right_x = (max_disparity < starting_x) ? (starting_x - max_disparity) : 0;
+
+    int32_t most_similar_x = first_right_x;
+    uint32_t smallest_difference = UINT32_MAX;
+
+    if(first_right_x < last_right_x){
+        if(smallest_difference_out != NULL) *smallest_difference_out = UINT32_MAX;
+        return SSVL_DISPARITY_INVALID;
+    }
+
+    if(ssvl->aggregate_pixel_comparer == ssvl_sad_comparer || ssvl->aggregate_pixel_comparer == ssvl_census_comparer){
+        // Built-in comparers: score a whole batch of neighbouring candidates per
+        // call and then walk the batch in the same right-to-left order as below so
+        // that ties resolve to the same (smallest) disparity
+        const bool sad = (ssvl->aggregate_pixel_comparer == ssvl_sad_comparer);
+        const ssvl_multi_comparer_t multi_comparer = sad ? ssvl->sad_multi_comparer : ssvl->census_multi_comparer;
+        uint32_t sads[SSVL_SAD_BATCH];
+
+        // Narrow ranges (temporal, adaptive) are padded to whole SIMD loops with neighbouring
+        // candidates, further left first and then right while inside the row. They're scored
+        // and ignored, cheaper than scoring the last few one at a time
+        const int32_t simd_candidates = sad ? SSVL_SAD_SIMD_CANDIDATES : SSVL_CENSUS_SIMD_CANDIDATES;
+        const int32_t scored_count = (first_right_x - last_right_x + simd_candidates) / simd_candidates * simd_candidates;
+        const int32_t last_window_x = ssvl->width - ssvl->search_window_dimensions;
+        const int32_t start_x = (first_right_x + 1 - scored_count > 0) ? (first_right_x + 1 - scored_count) : 0;
+        const int32_t end_x = (start_x + scored_count - 1 < last_window_x) ? (start_x + scored_count - 1) : last_window_x;
+
+        for(int32_t right_x=end_x; right_x>=start_x; ){
+            const int32_t batch_start_x = (right_x - start_x >= SSVL_SAD_BATCH-1) ? (right_x - (SSVL_SAD_BATCH-1)) : start_x;
+            const uint16_t batch_count = (uint16_t)(right_x - batch_start_x + 1);
+
+            multi_comparer(ssvl,
+                           ssvl->frame_buffers[SSVL_LEFT_CAMERA],
+                           ssvl->frame_buffers[SSVL_RIGHT_CAMERA],
+                           starting_x,
+                           starting_y,
+                           batch_start_x,
+                           starting_y,
+                           ssvl->search_window_dimensions,
+                           batch_count,
+                           sads);
+
+            SSVL_STATS_COUNT(scratch, 1, batch_count);
+
+            for(int32_t i=batch_count-1; i>=0; i--){
+                const int32_t candidate_x = batch_start_x + i;
+
+                if(candidate_x >= last_right_x && candidate_x <= first_right_x && sads[i] < smallest_difference){
+                    smallest_difference = sads[i];
+                    most_similar_x = candidate_x;
+                }
+            }
+
+            right_x = batch_start_x - 1;
+        }
+    }else{
+        for(int32_t right_x=first_right_x; right_x>=last_right_x; right_x--){
+            uint32_t current_difference = ssvl->aggregate_pixel_comparer(ssvl,
+                                                            ssvl->frame_buffers[SSVL_LEFT_CAMERA],
+                                                            ssvl->frame_buffers[SSVL_RIGHT_CAMERA],
+                                                            starting_x,
+                                                            starting_y,
+                                                            right_x,
+                                                            starting_y,
+                                                            ssvl->search_window_dimensions);
+
+            SSVL_STATS_COUNT(scratch, 1, 1);
+
+            if(current_difference < smallest_difference){
+                smallest_difference = current_difference;
+                most_similar_x = right_x;
+            }
+        }
+    }
+
+    if(smallest_difference_out != NULL) *smallest_difference_out = smallest_difference;
+
+    // Now that we have the block X with the smallest difference to the one
+    // in the left eye, calculate difference in X (disparity)
+    uint16_t disparity = abs(starting_x - most_similar_x);
+
+    return disparity;
+}
+
+
+// Searches the cell over the range active this frame (see `ssvl_config_t.min_disparity`,
+// `max_disparity` and `adaptive_disparity_range`), as worker 0
+SSVL_FUNC uint16_t ssvl_disparity_search(ssvl_t *ssvl, uint16_t left_cell_x, uint16_t left_cell_y){
+    return ssvl_disparity_search_range(ssvl, &ssvl->worker_scratch[0], left_cell_x, left_cell_y, ssvl->active_min_disparity, ssvl->active_max_disparity, NULL);
+}
+
+
+// SAD search of a cell's window at pyramid `level` (level pixels, same window dimensions, moved
+// inside the level's image at the right and bottom edges) over disparities `low` ~ `high`, ties
+// go to the smallest disparity. Returns `SSVL_DISPARITY_INVALID` if no candidate is left of the
+// window. Ranges are padded to whole SIMD loops of `ssvl_sad_multi_comparer` with neighbouring
+// candidates (scored and ignored), cheaper than scoring the last few one at a time
+SSVL_FUNC uint16_t ssvl_pyramid_search_level(ssvl_t *ssvl, ssvl_worker_scratch_t *scratch, uint8_t level, uint16_t left_cell_x, uint16_t left_cell_y, uint16_t low, uint16_t high){
+    const uint16_t window_dimensions = ssvl->search_window_dimensions;
+    const uint16_t level_width = ssvl->width >> level;
+    const uint16_t level_height = ssvl->height >> level;
+
+    uint16_t window_x = (uint16_t)((left_cell_x * ssvl->cell_stride) >> level);
+    uint16_t window_y = (uint16_t)((left_cell_y * ssvl->cell_stride) >> level);
+    if(window_x > level_width - window_dimensions) window_x = level_width - window_dimensions;
+    if(window_y > level_height - window_dimensions) window_y = level_height - window_dimensions;
+
+    if(high > window_x) high = window_x;
+    if(low > high) return SSVL_DISPARITY_INVALID;
+
+    ssvl_gray_t *left_pixels = ssvl_pyramid_level(ssvl, SSVL_LEFT_CAMERA, level);
+    ssvl_gray_t *right_pixels = ssvl_pyramid_level(ssvl, SSVL_RIGHT_CAMERA, level);
+    uint32_t sads[SSVL_SAD_BATCH];
+    uint32_t smallest_difference = UINT32_MAX;
+    uint16_t best_disparity = low;
+
+    // Right eye windows `first_x` ~ `last_x` are the range, `start_x` ~ `end_x` get scored:
+    // rounded up to whole SIMD loops, further left first and then right while inside the row
+    const int32_t first_x = window_x - high;
+    const int32_t last_x = window_x - low;
+    const int32_t scored_count = (last_x - first_x + SSVL_SAD_SIMD_CANDIDATES) / SSVL_SAD_SIMD_CANDIDATES * SSVL_SAD_SIMD_CANDIDATES;
+    const int32_t last_window_x = level_width - window_dimensions;
+    const int32_t start_x = (last_x + 1 - scored_count > 0) ? (last_x + 1 - scored_count) : 0;
+    const int32_t end_x = (start_x + scored_count - 1 < last_window_x) ? (start_x + scored_count - 1) : last_window_x;
+
+    for(int32_t batch_start_x=start_x; batch_start_x<=end_x; batch_start_x+=SSVL_SAD_BATCH){
+        const uint16_t batch_count = (end_x - batch_start_x + 1 > SSVL_SAD_BATCH) ? SSVL_SAD_BATCH : (uint16_t)(end_x - batch_start_x + 1);
+
+        ssvl->sad_multi_comparer(ssvl, left_pixels, right_pixels, window_x, window_y, batch_start_x, window_y, window_dimensions, batch_count, sads);
+        SSVL_STATS_COUNT(scratch, 1, batch_count);
+
+        // Right to left within the range so ties keep the smallest disparity
+        for(int32_t i=batch_count-1; i>=0; i--){
+            const int32_t right_x = batch_start_x + i;
+
+            if(right_x >= first_x && right_x <= last_x && sads[i] < smallest_difference){
+                smallest_difference = sads[i];
+                best_disparity = (uint16_t)(window_x - right_x);
+            }
+        }
+    }
+
+    return best_disparity;
+}
+
+
+// Narrows `low` ~ `high` to `radius` either side of `estimate`, to the nearest bound if
+// the estimate is outside the range
+SSVL_FUNC void ssvl_narrow_range(int32_t estimate, uint8_t radius, uint16_t *low, uint16_t *high){
+    const int32_t narrow_low = estimate - radius;
+    const int32_t narrow_high = estimate + radius;
+
+    if(narrow_low > *high){
+        *low = *high;
+    }else if(narrow_high < *low){
+        *high = *low;
+    }else{
+        if(narrow_low > *low) *low = (uint16_t)narrow_low;
+        if(narrow_high < *high) *high = (uint16_t)narrow_high;
+    }
+}
+
+
+// Coarse-to-fine search of a cell, see `ssvl_config_t.pyramid_levels`. Each level's estimate is
+// doubled for the next finer level, full resolution is searched with `ssvl_disparity_search_range`
+SSVL_FUNC uint16_t ssvl_pyramid_search(ssvl_t *ssvl, ssvl_worker_scratch_t *scratch, uint16_t left_cell_x, uint16_t left_cell_y){
+    const uint8_t coarsest = ssvl->pyramid_levels - 1;
+    uint16_t estimate = 0;
+
+    for(uint8_t level=coarsest; level>0; level--){
+        uint16_t low = ssvl->active_min_disparity >> level;
+        uint16_t high = ssvl->active_max_disparity >> level;
+
+        if(level != coarsest){
+            ssvl_narrow_range(2*estimate, ssvl->pyramid_radius, &low, &high);
+        }
+
+        estimate = ssvl_pyramid_search_level(ssvl, scratch, level, left_cell_x, left_cell_y, low, high);
+
+        // Nothing left of the window at this level, go on from the smallest disparity
+        if(estimate == SSVL_DISPARITY_INVALID) estimate = low;
+    }
+
+    uint16_t low = ssvl->active_min_disparity;
+    uint16_t high = ssvl->active_max_disparity;
+    ssvl_narrow_range(2*estimate, ssvl->pyramid_radius, &low, &high);
+
+    if(ssvl->aggregate_pixel_comparer == ssvl_sad_comparer){
+        return ssvl_pyramid_search_level(ssvl, scratch, 0, left_cell_x, left_cell_y, low, high);
+    }
+
+    return ssvl_disparity_search_range(ssvl, scratch, left_cell_x, left_cell_y, low, high, NULL);
+}
+
+
+// Temporal warm start of a cell (see `ssvl_config_t.temporal`), the disparity is kept for the
+// next frame and cells searched over the whole range are counted in the worker's `temporal_fallbacks`
+SSVL_FUNC uint16_t ssvl_temporal_search(ssvl_t *ssvl, ssvl_worker_scratch_t *scratch, uint16_t left_cell_x, uint16_t left_cell_y){
+    uint16_t *previous_disparity = ssvl->temporal_disparities + left_cell_y*ssvl->depth_width + left_cell_x;
+    uint16_t disparity = SSVL_DISPARITY_INVALID;
+    uint32_t smallest_difference = UINT32_MAX;
+    bool band_edge = false;
+
+    if(*previous_disparity != SSVL_DISPARITY_INVALID){
+        uint16_t low = ssvl->active_min_disparity;
+        uint16_t high = ssvl->active_max_disparity;
+        ssvl_narrow_range(*previous_disparity, ssvl->temporal_radius, &low, &high);
+
+        disparity = ssvl_disparity_search_range(ssvl, scratch, left_cell_x, left_cell_y, low, high, &smallest_difference);
+
+        // Still going downhill where the band stops, the minimum is likely outside of it
+        band_edge = (disparity == low && low > ssvl->active_min_disparity) || (disparity == high && high < ssvl->active_max_disparity);
+    }
+
+    if(disparity == SSVL_DISPARITY_INVALID || band_edge || smallest_difference > ssvl->temporal_max_cost){
+        disparity = (ssvl->pyramid_levels > 1) ? ssvl_pyramid_search(ssvl, scratch, left_cell_x, left_cell_y) :
+                                                  ssvl_disparity_search_range(ssvl, scratch, left_cell_x, left_cell_y, ssvl->active_min_disparity, ssvl->active_max_disparity, NULL);
+        scratch->temporal_fallbacks++;
+    }
+
+    *previous_disparity = disparity;
+    return disparity;
+}
+
+
+// Window search of a single cell: temporal, pyramid or the whole active range
+SSVL_FUNC uint16_t ssvl_cell_search(ssvl_t *ssvl, ssvl_worker_scratch_t *scratch, uint16_t left_cell_x, uint16_t left_cell_y){
+    if(ssvl->temporal){
+        return ssvl_temporal_search(ssvl, scratch, left_cell_x, left_cell_y);
+    }else if(ssvl->pyramid_levels > 1){
+        return ssvl_pyramid_search(ssvl, scratch, left_cell_x, left_cell_y);
+    }
+
+    return ssvl_disparity_search_range(ssvl, scratch, left_cell_x, left_cell_y, ssvl->active_min_disparity, ssvl->active_max_disparity, NULL);
+}
+
+
+// Column sums of absolute differences: `sums[i]` = sum over `rows` rows of |a[i]-b[i]|,
+// where consecutive rows are `stride` samples apart in both `a` and `b`. Each chunk of
+// columns is accumulated in registers down all rows and stored once (8-bit grayscale in
+// 16-bit lanes, `rows` is a window dimension so at most 255 differences of 255)
+SSVL_FUNC void ssvl_column_absolute_differences(uint32_t *sums, const ssvl_gray_t *a, const ssvl_gray_t *b, uint32_t stride, uint16_t rows, uint32_t count){
+    uint32_t i = 0;
+
+    #if defined(SSVL_AVX2) && defined(SSVL_GRAY8)
+        const __m256i zero = _mm256_setzero_si256();
+
+        for(; i+32 <= count; i+=32){
+            // Columns 0-7 and 16-23 in `sums_lo`, 8-15 and 24-31 in `sums_hi` (per 128-bit lane unpacking)
+            __m256i sums_lo = zero;
+            __m256i sums_hi = zero;
+
+            for(uint16_t y=0; y<rows; y++){
+                const __m256i va = _mm256_loadu_si256((const __m256i*)(a + y*stride + i));
+                const __m256i vb = _mm256_loadu_si256((const __m256i*)(b + y*stride + i));
+                const __m256i diff = _mm256_or_si256(_mm256_subs_epu8(va, vb), _mm256_subs_epu8(vb, va));
+
+                sums_lo = _mm256_add_epi16(sums_lo, _mm256_unpacklo_epi8(diff, zero));
+                sums_hi = _mm256_add_epi16(sums_hi, _mm256_unpackhi_epi8(diff, zero));
+            }
+
+            _mm256_storeu_si256((__m256i*)(sums + i), _mm256_cvtepu16_epi32(_mm256_castsi256_si128(sums_lo)));
+            _mm256_storeu_si256((__m256i*)(sums + i + 8), _mm256_cvtepu16_epi32(_mm256_castsi256_si128(sums_hi)));
+            _mm256_storeu_si256((__m256i*)(sums + i + 16), _mm256_cvtepu16_epi32(_mm256_extracti128_si256(sums_lo, 1)));
+            _mm256_storeu_si256((__m256i*)(sums + i + 24), _mm256_cvtepu16_epi32(_mm256_extracti128_si256(sums_hi, 1)));
+        }
+    #elif defined(SSVL_AVX2)
+        for(; i+16 <= count; i+=16){
+            __m256i sums_lo = _mm256_setzero_si256();
+            __m256i sums_hi = _mm256_setzero_si256();
+
+            for(uint16_t y=0; y<rows; y++){
+                const __m256i va = _mm256_loadu_si256((const __m256i*)(a + y*stride + i));
+                const __m256i vb = _mm256_loadu_si256((const __m256i*)(b + y*stride + i));
+                const __m256i diff = _mm256_or_si256(_mm256_subs_epu16(va, vb), _mm256_subs_epu16(vb, va));
+
+                sums_lo = _mm256_add_epi32(sums_lo, _mm256_cvtepu16_epi32(_mm256_castsi256_si128(diff)));
+                sums_hi = _mm256_add_epi32(sums_hi, _mm256_cvtepu16_epi32(_mm256_extracti128_si256(diff, 1)));
+            }
+
+            _mm256_storeu_si256((__m256i*)(sums + i), sums_lo);
+            _mm256_storeu_si256((__m256i*)(sums + i + 8), sums_hi);
+        }
+    #elif defined(SSVL_SSE2) && defined(SSVL_GRAY8)
+        const __m128i zero = _mm_setzero_si128();
+
+        for(; i+16 <= count; i+=16){
+            __m128i sums_lo = zero;
+            __m128i sums_hi = zero;
+
+            for(uint16_t y=0; y<rows; y++){
+                const __m128i va = _mm_loadu_si128((const __m128i*)(a + y*stride + i));
+                const __m128i vb = _mm_loadu_si128((const __m128i*)(b + y*stride + i));
+                const __m128i diff = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+
+                sums_lo = _mm_add_epi16(sums_lo, _mm_unpacklo_epi8(diff, zero));
+                sums_hi = _mm_add_epi16(sums_hi, _mm_unpackhi_epi8(diff, zero));
+            }
+
+            _mm_storeu_si128((__m128i*)(sums + i), _mm_unpacklo_epi16(sums_lo, zero));
+            _mm_storeu_si128((__m128i*)(sums + i + 4), _mm_unpackhi_epi16(sums_lo, zero));
+            _mm_storeu_si128((__m128i*)(sums + i + 8), _mm_unpacklo_epi16(sums_hi, zero));
+            _mm_storeu_si128((__m128i*)(sums + i + 12), _mm_unpackhi_epi16(sums_hi, zero));
+        }
+    #elif defined(SSVL_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+
+        for(; i+8 <= count; i+=8){
+            __m128i sums_lo = zero;
+            __m128i sums_hi = zero;
+
+            for(uint16_t y=0; y<rows; y++){
+                const __m128i va = _mm_loadu_si128((const __m128i*)(a + y*stride + i));
+                const __m128i vb = _mm_loadu_si128((const __m128i*)(b + y*stride + i));
+                const __m128i diff = _mm_or_si128(_mm_subs_epu16(va, vb), _mm_subs_epu16(vb, va));
+
+                sums_lo = _mm_add_epi32(sums_lo, _mm_unpacklo_epi16(diff, zero));
+                sums_hi = _mm_add_epi32(sums_hi, _mm_unpackhi_epi16(diff, zero));
+            }
+
+            _mm_storeu_si128((__m128i*)(sums + i), sums_lo);
+            _mm_storeu_si128((__m128i*)(sums + i + 4), sums_hi);
+        }
+    #elif defined(SSVL_NEON) && defined(SSVL_GRAY8)
+        for(; i+16 <= count; i+=16){
+            uint16x8_t sums_lo = vdupq_n_u16(0);
+            uint16x8_t sums_hi = vdupq_n_u16(0);
+
+            for(uint16_t y=0; y<rows; y++){
+                const uint8x16_t va = vld1q_u8(a + y*stride + i);
+                const uint8x16_t vb = vld1q_u8(b + y*stride + i);
+
+                sums_lo = vabal_u8(sums_lo, vget_low_u8(va), vget_low_u8(vb));
+                sums_hi = vabal_u8(sums_hi, vget_high_u8(va), vget_high_u8(vb));
+            }
+
+            vst1q_u32(sums + i, vmovl_u16(vget_low_u16(sums_lo)));
+            vst1q_u32(sums + i + 4, vmovl_u16(vget_high_u16(sums_lo)));
+            vst1q_u32(sums + i + 8, vmovl_u16(vget_low_u16(sums_hi)));
+            vst1q_u32(sums + i + 12, vmovl_u16(vget_high_u16(sums_hi)));
+        }
+    #elif defined(SSVL_NEON)
+        for(; i+8 <= count; i+=8){
+            uint32x4_t sums_lo = vdupq_n_u32(0);
+            uint32x4_t sums_hi = vdupq_n_u32(0);
+
+            for(uint16_t y=0; y<rows; y++){
+                const uint16x8_t va = vld1q_u16(a + y*stride + i);
+                const uint16x8_t vb = vld1q_u16(b + y*stride + i);
+
+                sums_lo = vabal_u16(sums_lo, vget_low_u16(va), vget_low_u16(vb));
+                sums_hi = vabal_u16(sums_hi, vget_high_u16(va), vget_high_u16(vb));
+            }
+
+            vst1q_u32(sums + i, sums_lo);
+            vst1q_u32(sums + i + 4, sums_hi);
+        }
+    #endif
+
+    for(; i<count; i++){
+        uint32_t sum = 0;
+
+        for(uint16_t y=0; y<rows; y++){
+            sum += (uint32_t)abs((int32_t)a[y*stride + i] - (int32_t)b[y*stride + i]);
+        }
+
+        sums[i] = sum;
+    }
+}
+
+
+// Column sums of Hamming distances between census descriptors: `sums[i]` = sum over `rows`
+// rows of popcount(a[i]^b[i]), same layout as `ssvl_column_absolute_differences`. Bits are
+// counted per byte and kept in 16-bit lanes down the rows (at most 16*255)
+SSVL_FUNC void ssvl_column_hamming_distances(uint32_t *sums, const uint32_t *a, const uint32_t *b, uint32_t stride, uint16_t rows, uint32_t count){
+    uint32_t i = 0;
+
+    #if defined(SSVL_AVX2)
+        const __m256i nibble_bits = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                     0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i low_nibbles = _mm256_set1_epi8(0x0F);
+        const __m256i ones8 = _mm256_set1_epi8(1);
+
+        for(; i+8 <= count; i+=8){
+            __m256i column_sums = _mm256_setzero_si256();
+
+            for(uint16_t y=0; y<rows; y++){
+                const __m256i differing = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + y*stride + i)), _mm256_loadu_si256((const __m256i*)(b + y*stride + i)));
+                const __m256i byte_bits = _mm256_add_epi8(_mm256_shuffle_epi8(nibble_bits, _mm256_and_si256(differing, low_nibbles)),
+                                                          _mm256_shuffle_epi8(nibble_bits, _mm256_and_si256(_mm256_srli_epi16(differing, 4), low_nibbles)));
+
+                column_sums = _mm256_add_epi16(column_sums, _mm256_maddubs_epi16(byte_bits, ones8));
+            }
+
+            _mm256_storeu_si256((__m256i*)(sums + i), _mm256_madd_epi16(column_sums, _mm256_set1_epi16(1)));
+        }
+    #elif defined(SSVL_NEON)
+        for(; i+4 <= count; i+=4){
+            uint16x8_t column_sums = vdupq_n_u16(0);
+
+            for(uint16_t y=0; y<rows; y++){
+                const uint32x4_t differing = veorq_u32(vld1q_u32(a + y*stride + i), vld1q_u32(b + y*stride + i));
+                column_sums = vpadalq_u8(column_sums, vcntq_u8(vreinterpretq_u8_u32(differing)));
+            }
+
+            vst1q_u32(sums + i, vpaddlq_u16(column_sums));
+        }
+    #endif
+
+    for(; i<count; i++){
+        uint32_t sum = 0;
+
+        for(uint16_t y=0; y<rows; y++){
+            sum += ssvl_popcount(a[y*stride + i] ^ b[y*stride + i]);
+        }
+
+        sums[i] = sum;
+    }
+}
+
+
+// Costs of columns `first_x` ~ `width`-1 of pixel rows `first_y` ~ `first_y+rows-1` for `disparity`
+// into `sums` (|L-R| summed down the columns, or Hamming distances of census descriptors)
+SSVL_FUNC void ssvl_cost_volume_band_columns(ssvl_t *ssvl, uint32_t *sums, uint16_t first_y, uint16_t rows, uint16_t disparity, uint16_t first_x){
+    const uint32_t band_offset = ssvl_frame_buffer_row(ssvl, first_y) * ssvl->width;
+    const uint32_t column_count = ssvl->width - first_x;
+
+    if(ssvl->aggregate_pixel_comparer == ssvl_census_comparer){
+        const uint32_t *left_census_band = ssvl->census_buffers[SSVL_LEFT_CAMERA] + band_offset;
+        const uint32_t *right_census_band = ssvl->census_buffers[SSVL_RIGHT_CAMERA] + band_offset;
+
+        ssvl_column_hamming_distances(sums + first_x,
+                                      left_census_band + first_x,
+                                      right_census_band + first_x - disparity,
+                                      ssvl->width,
+                                      rows,
+                                      column_count);
+    }else{
+        const ssvl_gray_t *left_band = ssvl->frame_buffers[SSVL_LEFT_CAMERA] + band_offset;
+        const ssvl_gray_t *right_band = ssvl->frame_buffers[SSVL_RIGHT_CAMERA] + band_offset;
+
+        ssvl_column_absolute_differences(sums + first_x,
+                                         left_band + first_x,
+                                         right_band + first_x - disparity,
+                                         ssvl->width,
+                                         rows,
+                                         column_count);
+    }
+}
+
+
+// First cell of a row that has candidate `disparity` (only cells at or right of it do)
+SSVL_FUNC uint16_t ssvl_cost_volume_first_cell(ssvl_t *ssvl, uint16_t disparity){
+    return (disparity + ssvl->cell_stride - 1) / ssvl->cell_stride;
+}
+
+
+// Costs of every column in the band of `left_cell_y` rows for `disparity`, from
+// `ssvl_cost_volume_first_cell` on (columns left of it aren't written). `disparity` must not go
+// past the right-most cell's left edge. With `share_rows`, the worker's sums of the row above (if
+// it was the last one `scratch` did) are moved down instead and returned in place
+SSVL_FUNC const uint32_t *ssvl_cost_volume_columns(ssvl_t *ssvl, ssvl_worker_scratch_t *scratch, uint16_t left_cell_y, uint16_t disparity){
+    const uint16_t window_dimensions = ssvl->search_window_dimensions;
+    const uint16_t cell_stride = ssvl->cell_stride;
+    const uint16_t first_y = left_cell_y * cell_stride;
+    const uint16_t first_x = ssvl_cost_volume_first_cell(ssvl, disparity) * cell_stride;
+    uint32_t *column_sums = scratch->column_sums;
+
+    if(scratch->row_column_sums == NULL){
+        ssvl_cost_volume_band_columns(ssvl, column_sums, first_y, window_dimensions, disparity, first_x);
+        return column_sums;
+    }
+
+    uint32_t *row_sums = scratch->row_column_sums + (disparity - ssvl->min_disparity) * ssvl->width;
+
+    if(scratch->shared_row >= 0 && scratch->shared_row + 1 == left_cell_y){
+        // Rows entering the windows at the bottom, then the ones leaving at the top
+        ssvl_cost_volume_band_columns(ssvl, column_sums, first_y + window_dimensions - cell_stride, cell_stride, disparity, first_x);
+
+        for(uint32_t x=first_x; x<ssvl->width; x++){
+            row_sums[x] += column_sums[x];
+        }
+
+        ssvl_cost_volume_band_columns(ssvl, column_sums, first_y - cell_stride, cell_stride, disparity, first_x);
+
+        for(uint32_t x=first_x; x<ssvl->width; x++){
+            row_sums[x] -= column_sums[x];
+        }
+    }else{
+        ssvl_cost_volume_band_columns(ssvl, row_sums, first_y, window_dimensions, disparity, first_x);
+    }
+
+    return row_sums;
+}
+
+
+// `share_rows`: every worker starts over (new frame or queries)
+SSVL_FUNC void ssvl_forget_shared_rows(ssvl_t *ssvl){
+    for(uint8_t worker_index=0; worker_index<ssvl->worker_count; worker_index++){
+        ssvl->worker_scratch[worker_index].shared_row = -1;
+    }
+}
+
+
+// Window costs of the cells `first_cell_x` ~ `depth_width`-1 from the `column_sums` of
+// `ssvl_cost_volume_columns` into `window_costs` (indexed by cell). Cells one window apart sum their
+// own columns, overlapping windows (`cell_stride` below `search_window_dimensions`) slide: each
+// cell is the one before plus the `cell_stride` columns entering minus the ones leaving
+SSVL_FUNC void ssvl_cost_volume_window_costs(ssvl_t *ssvl, const uint32_t *column_sums, uint16_t first_cell_x, uint32_t *window_costs){
+    const uint16_t window_dimensions = ssvl->search_window_dimensions;
+    const uint16_t cell_stride = ssvl->cell_stride;
+
+    if(cell_stride == window_dimensions){
+        for(uint16_t cell_x=first_cell_x; cell_x<ssvl->depth_width; cell_x++){
+            const uint32_t *cell_column_sums = column_sums + cell_x*window_dimensions;
+            uint32_t window_cost = 0;
+
+            for(uint16_t x=0; x<window_dimensions; x++){
+                window_cost += cell_column_sums[x];
+            }
+
+            window_costs[cell_x] = window_cost;
+        }
+
+        return;
+    }
+
+    const uint32_t *leaving = column_sums + (uint32_t)first_cell_x * cell_stride;
+    const uint32_t *entering = leaving + window_dimensions;
+    uint32_t window_cost = 0;
+
+    for(uint16_t x=0; x<window_dimensions; x++){
+        window_cost += leaving[x];
+    }
+
+    window_costs[first_cell_x] = window_cost;
+
+    for(uint16_t cell_x=first_cell_x+1; cell_x<ssvl->depth_width; cell_x++){
+        for(uint16_t x=0; x<cell_stride; x++){
+            window_cost += entering[x] - leaving[x];
+        }
+
+        window_costs[cell_x] = window_cost;
+        entering += cell_stride;
+        leaving += cell_stride;
+    }
+}
+
+
+// Cost volume search for a whole row of depth cells at once. Produces exactly the same
+// disparities as calling `ssvl_disparity_search` with `ssvl_sad_comparer` (or
+// `ssvl_census_comparer`, summing Hamming distances instead of |L-R|) for each cell.
+//
+// Instead of scoring every candidate window of every cell independently, disparities are
+// visited one at a time for the whole row: the |L-R| of every column in the row's band of
+// `search_window_dimensions` rows is summed once into `column_sums` (contiguous rows,
+// SIMD friendly) and each cell's window cost is the sum of its columns (overlapping
+// windows share them, see `ssvl_cost_volume_window_costs`).
+//
+// With `lr_check` the same costs also give each right eye window position its best
+// match among the row's cells (`right_best_costs`/`right_disparities` of `scratch`)
+SSVL_FUNC void ssvl_cost_volume_search_row(ssvl_t *ssvl, ssvl_worker_scratch_t *scratch, uint16_t left_cell_y, uint16_t *disparities){
+    uint32_t *window_costs = scratch->cell_window_costs;
+    uint32_t *best_costs = scratch->cell_best_costs;
+    uint32_t *right_best_costs = scratch->right_best_costs;
+    uint16_t *right_disparities = scratch->right_disparities;
+
+    for(uint16_t cell_x=0; cell_x<ssvl->depth_width; cell_x++){
+        best_costs[cell_x] = UINT32_MAX;
+        disparities[cell_x] = SSVL_DISPARITY_INVALID;
+    }
+
+    if(ssvl->lr_check){
+        memset(right_best_costs, 0xFF, ssvl->width * sizeof(uint32_t));
+    }
+
+    // Visiting disparities in increasing order and only replacing on strictly smaller
+    // costs resolves ties the same way as the right-to-left scan in `ssvl_disparity_search`.
+    // `active_max_disparity` never goes past the right-most cell's left edge
+    for(uint16_t disparity=ssvl->active_min_disparity; disparity<=ssvl->active_max_disparity; disparity++){
+        const uint16_t first_cell_x = ssvl_cost_volume_first_cell(ssvl, disparity);
+        const uint32_t *column_sums = ssvl_cost_volume_columns(ssvl, scratch, left_cell_y, disparity);
+        SSVL_STATS_COUNT(scratch, 0, ssvl->depth_width - first_cell_x);
+
+        // Each cell's window cost is the sum of its columns
+        ssvl_cost_volume_window_costs(ssvl, column_sums, first_cell_x, window_costs);
+
+        for(uint16_t cell_x=first_cell_x; cell_x<ssvl->depth_width; cell_x++){
+            const uint32_t window_cost = window_costs[cell_x];
+
+            if(window_cost < best_costs[cell_x]){
+                best_costs[cell_x] = window_cost;
+                disparities[cell_x] = disparity;
+            }
+
+            // Right window `x` is candidate `disparity` of the cell at `x + disparity` (the
+            // diagonal of the row's costs), ties also go to the smallest disparity
+            if(ssvl->lr_check){
+                const uint32_t right_x = cell_x*ssvl->cell_stride - disparity;
+
+                if(window_cost < right_best_costs[right_x]){
+                    right_best_costs[right_x] = window_cost;
+                    right_disparities[right_x] = disparity;
+                }
+            }
+        }
+    }
+
+    scratch->shared_row = left_cell_y;
+}
+
+
+// Left-right check of a cell's `disparity` found by `ssvl_cost_volume_search_row` or
+// `ssvl_sgm_select_row`: `true` if the right eye window it matched has the same
+// disparity as its best match (`scratch` filled by the same call)
+SSVL_FUNC bool ssvl_lr_consistent(ssvl_t *ssvl, ssvl_worker_scratch_t *scratch, uint16_t left_cell_x, uint16_t disparity){
+    if(disparity == SSVL_DISPARITY_INVALID){
+        return true;
+    }
+
+    return scratch->right_disparities[left_cell_x*ssvl->cell_stride - disparity] == disparity;
+}
+
+
+// Window costs of every searched disparity for a row of cells, scaled down by `sgm_cost_shift`
+// and clamped to `SSVL_SGM_COST_MAX`. `costs` holds `sgm_disparity_stride` entries per cell, entry
+// `i` is disparity `active_min_disparity + i`. Disparities past a cell's left edge cost
+// `SSVL_SGM_COST_MAX` (never selected, see `ssvl_sgm_select_row`)
+SSVL_FUNC void ssvl_sgm_cost_row(ssvl_t *ssvl, ssvl_worker_scratch_t *scratch, uint16_t left_cell_y, uint16_t *costs){
+    const uint16_t window_dimensions = ssvl->search_window_dimensions;
+    const uint16_t stride = ssvl->sgm_disparity_stride;
+    const uint8_t shift = ssvl->sgm_cost_shift;
+
+    if(ssvl->aggregate_pixel_comparer == ssvl_sad_comparer || ssvl->aggregate_pixel_comparer == ssvl_census_comparer){
+        for(uint16_t disparity=ssvl->active_min_disparity; disparity<=ssvl->active_max_disparity; disparity++){
+            const uint16_t index = disparity - ssvl->active_min_disparity;
+            const uint16_t first_cell_x = ssvl_cost_volume_first_cell(ssvl, disparity);
+            const uint32_t *column_sums = ssvl_cost_volume_columns(ssvl, scratch, left_cell_y, disparity);
+            SSVL_STATS_COUNT(scratch, 0, ssvl->depth_width - first_cell_x);
+
+            for(uint16_t cell_x=0; cell_x<first_cell_x; cell_x++){
+                costs[cell_x*stride + index] = SSVL_SGM_COST_MAX;
+            }
+
+            ssvl_cost_volume_window_costs(ssvl, column_sums, first_cell_x, scratch->cell_window_costs);
+
+            for(uint16_t cell_x=first_cell_x; cell_x<ssvl->depth_width; cell_x++){
+                const uint32_t window_cost = scratch->cell_window_costs[cell_x] >> shift;
+                costs[cell_x*stride + index] = (window_cost < SSVL_SGM_COST_MAX) ? (uint16_t)window_cost : SSVL_SGM_COST_MAX;
+            }
+        }
+
+        scratch->shared_row = left_cell_y;
+    }else{
+        const uint16_t starting_y = ssvl_frame_buffer_row(ssvl, left_cell_y * ssvl->cell_stride);
+
+        for(uint16_t cell_x=0; cell_x<ssvl->depth_width; cell_x++){
+            const uint16_t starting_x = cell_x * ssvl->cell_stride;
+
+            for(uint16_t disparity=ssvl->active_min_disparity; disparity<=ssvl->active_max_disparity; disparity++){
+                uint32_t window_cost = UINT32_MAX;
+
+                if(disparity <= starting_x){
+                    window_cost = ssvl->aggregate_pixel_comparer(ssvl,
+                                                                 ssvl->frame_buffers[SSVL_LEFT_CAMERA],
+                                                                 ssvl->frame_buffers[SSVL_RIGHT_CAMERA],
+                                                                 starting_x,
+                                                                 starting_y,
+                                                                 starting_x - disparity,
+                                                                 starting_y,
+                                                                 window_dimensions) >> shift;
+                    SSVL_STATS_COUNT(scratch, 1, 1);
+                }
+
+                costs[cell_x*stride + disparity - ssvl->active_min_disparity] = (window_cost < SSVL_SGM_COST_MAX) ? (uint16_t)window_cost : SSVL_SGM_COST_MAX;
+            }
+        }
+    }
+}
+
+
+// Smallest of 8 signed 16-bit lanes
+#if defined(SSVL_SSE2)
+SSVL_FUNC uint16_t ssvl_sgm_min_epi16(__m128i values){
+    values = _mm_min_epi16(values, _mm_srli_si128(values, 8));
+    values = _mm_min_epi16(values, _mm_srli_si128(values, 4));
+    values = _mm_min_epi16(values, _mm_srli_si128(values, 2));
+
+    return (uint16_t)_mm_cvtsi128_si32(values);
+}
+#endif
+
+
+// One step along an SGM path: the path's costs at a cell from its costs at the previous
+// cell on the path (`previous_path`, NULL where the path starts) and the cell's `costs`,
+// for `count` disparities
+//
+//     L(d) = C(d) + min(L'(d), L'(d-1) + P1, L'(d+1) + P1, min L' + P2) - min L'
+//
+// and adds them to `sums`. Path buffers are `sgm_disparity_stride + 3` entries, `path[-1]`
+// and `path[count]` hold `SSVL_SGM_PATH_SENTINEL` so the neighbouring disparities need no
+// bounds checks and `path[count+1]` is the smallest of the path's costs. Paths stay below
+// `SSVL_SGM_COST_MAX + sgm_p2` so everything fits signed 16-bit lanes
+SSVL_FUNC void ssvl_sgm_path_step(ssvl_t *ssvl, uint16_t *path, const uint16_t *previous_path, const uint16_t *costs, uint16_t *sums, uint16_t count){
+    uint16_t path_min = SSVL_SGM_PATH_SENTINEL;
+    uint16_t d = 0;
+
+    path[-1] = SSVL_SGM_PATH_SENTINEL;
+    path[count] = SSVL_SGM_PATH_SENTINEL;
+
+    if(previous_path == NULL){
+        for(; d<count; d++){
+            path[d] = costs[d];
+            sums[d] += costs[d];
+            path_min = (costs[d] < path_min) ? costs[d] : path_min;
+        }
+
+        path[count+1] = path_min;
+        return;
+    }
+
+    const uint16_t previous_min = previous_path[count+1];
+    const uint16_t p1 = ssvl->sgm_p1;
+    const uint16_t jump = previous_min + ssvl->sgm_p2;
+
+    #if defined(SSVL_AVX2)
+        const __m256i p1_256 = _mm256_set1_epi16((short)p1);
+        const __m256i jump_256 = _mm256_set1_epi16((short)jump);
+        const __m256i previous_min_256 = _mm256_set1_epi16((short)previous_min);
+        __m256i min_256 = _mm256_set1_epi16(SSVL_SGM_PATH_SENTINEL);
+
+        for(; d+16 <= count; d+=16){
+            const __m256i same = _mm256_loadu_si256((const __m256i*)(previous_path + d));
+            const __m256i neighbours = _mm256_min_epi16(_mm256_loadu_si256((const __m256i*)(previous_path + d - 1)), _mm256_loadu_si256((const __m256i*)(previous_path + d + 1)));
+            const __m256i smallest = _mm256_min_epi16(_mm256_min_epi16(same, _mm256_add_epi16(neighbours, p1_256)), jump_256);
+            const __m256i step = _mm256_sub_epi16(_mm256_add_epi16(_mm256_loadu_si256((const __m256i*)(costs + d)), smallest), previous_min_256);
+
+            _mm256_storeu_si256((__m256i*)(path + d), step);
+            _mm256_storeu_si256((__m256i*)(sums + d), _mm256_add_epi16(_mm256_loadu_si256((const __m256i*)(sums + d)), step));
+            min_256 = _mm256_min_epi16(min_256, step);
+        }
+
+        path_min = ssvl_sgm_min_epi16(_mm_min_epi16(_mm256_castsi256_si128(min_256), _mm256_extracti128_si256(min_256, 1)));
+    #elif defined(SSVL_SSE2)
+        const __m128i p1_128 = _mm_set1_epi16((short)p1);
+        const __m128i jump_128 = _mm_set1_epi16((short)jump);
+        const __m128i previous_min_128 = _mm_set1_epi16((short)previous_min);
+        __m128i min_128 = _mm_set1_epi16(SSVL_SGM_PATH_SENTINEL);
+
+        for(; d+8 <= count; d+=8){
+            const __m128i same = _mm_loadu_si128((const __m128i*)(previous_path + d));
+            const __m128i neighbours = _mm_min_epi16(_mm_loadu_si128((const __m128i*)(previous_path + d - 1)), _mm_loadu_si128((const __m128i*)(previous_path + d + 1)));
+            const __m128i smallest = _mm_min_epi16(_mm_min_epi16(same, _mm_add_epi16(neighbours, p1_128)), jump_128);
+            const __m128i step = _mm_sub_epi16(_mm_add_epi16(_mm_loadu_si128((const __m128i*)(costs + d)), smallest), previous_min_128);
+
+            _mm_storeu_si128((__m128i*)(path + d), step);
+            _mm_storeu_si128((__m128i*)(sums + d), _mm_add_epi16(_mm_loadu_si128((const __m128i*)(sums + d)), step));
+            min_128 = _mm_min_epi16(min_128, step);
+        }
+
+        path_min = ssvl_sgm_min_epi16(min_128);
+    #elif defined(SSVL_NEON)
+        const uint16x8_t p1_128 = vdupq_n_u16(p1);
+        const uint16x8_t jump_128 = vdupq_n_u16(jump);
+        const uint16x8_t previous_min_128 = vdupq_n_u16(previous_min);
+        uint16x8_t min_128 = vdupq_n_u16(SSVL_SGM_PATH_SENTINEL);
+
+        for(; d+8 <= count; d+=8){
+            const uint16x8_t same = vld1q_u16(previous_path + d);
+            const uint16x8_t neighbours = vminq_u16(vld1q_u16(previous_path + d - 1), vld1q_u16(previous_path + d + 1));
+            const uint16x8_t smallest = vminq_u16(vminq_u16(same, vaddq_u16(neighbours, p1_128)), jump_128);
+            const uint16x8_t step = vsubq_u16(vaddq_u16(vld1q_u16(costs + d), smallest), previous_min_128);
+
+            vst1q_u16(path + d, step);
+            vst1q_u16(sums + d, vaddq_u16(vld1q_u16(sums + d), step));
+            min_128 = vminq_u16(min_128, step);
+        }
+
+        uint16x4_t min_64 = vmin_u16(vget_low_u16(min_128), vget_high_u16(min_128));
+        min_64 = vpmin_u16(min_64, min_64);
+        min_64 = vpmin_u16(min_64, min_64);
+        path_min = vget_lane_u16(min_64, 0);
+    #endif
+
+    for(; d<count; d++){
+        const uint16_t neighbours = (previous_path[d-1] < previous_path[d+1]) ? previous_path[d-1] : previous_path[d+1];
+        uint16_t smallest = previous_path[d];
+
+        smallest = (neighbours + p1 < smallest) ? (uint16_t)(neighbours + p1) : smallest;
+        smallest = (jump < smallest) ? jump : smallest;
+
+        path[d] = costs[d] + smallest - previous_min;
+        sums[d] += path[d];
+        path_min = (path[d] < path_min) ? path[d] : path_min;
+    }
+
+    path[count+1] = path_min;
+}
+
+
+// Adds the left to right and right to left paths of a row of cells (`costs` and `sums` laid out
+// as in `ssvl_sgm_cost_row`) to `sums`. `paths` is room for two path buffers
+SSVL_FUNC void ssvl_sgm_horizontal_row(ssvl_t *ssvl, uint16_t *paths, const uint16_t *costs, uint16_t *sums){
+    const uint16_t stride = ssvl->sgm_disparity_stride;
+    const uint16_t count = ssvl->active_max_disparity - ssvl->active_min_disparity + 1;
+    uint16_t *path = paths + 1;
+    uint16_t *previous_path = path + stride + 3;
+
+    for(uint16_t cell_x=0; cell_x<ssvl->depth_width; cell_x++){
+        uint16_t *swap = path; path = previous_path; previous_path = swap;
+        ssvl_sgm_path_step(ssvl, path, (cell_x == 0) ? NULL : previous_path, costs + cell_x*stride, sums + cell_x*stride, count);
+    }
+
+    for(int32_t cell_x=ssvl->depth_width-1; cell_x>=0; cell_x--){
+        uint16_t *swap = path; path = previous_path; previous_path = swap;
+        ssvl_sgm_path_step(ssvl, path, (cell_x == ssvl->depth_width-1) ? NULL : previous_path, costs + cell_x*stride, sums + cell_x*stride, count);
+    }
+}
+
+
+// Adds the paths arriving at row `left_cell_y` from the row above (`down`) or below to its
+// `sums`: straight down/up, and with `diagonals` both diagonals. Paths of the previous row are
+// kept in `sgm_path_rows` (alternating between two rows of path buffers by row parity)
+SSVL_FUNC void ssvl_sgm_vertical_row(ssvl_t *ssvl, uint16_t left_cell_y, bool down, bool diagonals, const uint16_t *costs, uint16_t *sums){
+    const uint16_t stride = ssvl->sgm_disparity_stride;
+    const uint32_t path_stride = stride + 3;
+    const uint16_t count = ssvl->active_max_disparity - ssvl->active_min_disparity + 1;
+    const uint16_t last_cell_x = ssvl->depth_width - 1;
+    const bool first_row = down ? (left_cell_y == 0) : (left_cell_y == ssvl->depth_height-1);
+    const uint8_t path_count = diagonals ? 3 : 1;
+    const uint8_t parity = left_cell_y & 1;
+
+    for(uint8_t path_index=0; path_index<path_count; path_index++){
+        uint16_t *row_paths = ssvl->sgm_path_rows + ((path_index*2 + parity) * ssvl->depth_width) * path_stride + 1;
+        const uint16_t *previous_row_paths = ssvl->sgm_path_rows + ((path_index*2 + (parity ^ 1)) * ssvl->depth_width) * path_stride + 1;
+
+        for(uint16_t cell_x=0; cell_x<ssvl->depth_width; cell_x++){
+            // Straight, from the left neighbour's column and from the right neighbour's column
+            const uint16_t *previous_path = NULL;
+
+            if(first_row == false){
+                if(path_index == 0) previous_path = previous_row_paths + cell_x*path_stride;
+                else if(path_index == 1 && cell_x > 0) previous_path = previous_row_paths + (cell_x-1)*path_stride;
+                else if(path_index == 2 && cell_x < last_cell_x) previous_path = previous_row_paths + (cell_x+1)*path_stride;
+            }
+
+            ssvl_sgm_path_step(ssvl, row_paths + cell_x*path_stride, previous_path, costs + cell_x*stride, sums + cell_x*stride, count);
+        }
+    }
+}
+
+
+// Stores the whole pixel `disparity` of a cell, `SSVL_OUTPUT_UINT16` also stores its depth
+SSVL_FUNC void ssvl_store_disparity(ssvl_t *ssvl, uint32_t cell_index, uint16_t disparity){
+    if(ssvl->output_format == SSVL_OUTPUT_FLOAT){
+        ssvl->disparity_depth_buffer[cell_index] = (float)disparity;
+    }else if(disparity <= ssvl->max_disparity){
+        ssvl->disparity_u16_buffer[cell_index] = (uint16_t)(disparity << ssvl->disparity_fraction_bits);
+        ssvl->depth_mm_buffer[cell_index] = ssvl->depth_mm_lut[disparity];
+    }else{
+        // No candidate, the max depth like floats
+        ssvl->disparity_u16_buffer[cell_index] = SSVL_DISPARITY_INVALID;
+        ssvl->depth_mm_buffer[cell_index] = ssvl->depth_mm_lut[0];
+    }
+}
+
+
+// Stores `SSVL_CELL_REJECTED` or `SSVL_CELL_SKIPPED` for a cell
+SSVL_FUNC void ssvl_store_mark(ssvl_t *ssvl, uint32_t cell_index, float mark){
+    if(ssvl->output_format == SSVL_OUTPUT_FLOAT){
+        ssvl->disparity_depth_buffer[cell_index] = mark;
+    }else{
+        const uint16_t u16_mark = (mark == SSVL_CELL_REJECTED) ? SSVL_CELL_U16_REJECTED : SSVL_CELL_U16_SKIPPED;
+        ssvl->disparity_u16_buffer[cell_index] = u16_mark;
+        ssvl->depth_mm_buffer[cell_index] = u16_mark;
+    }
+}
+
+
+// Picks each cell's disparity with the smallest path cost sum into its row of
+// `disparity_depth_buffer`, ties go to the smallest disparity. Cells with no
+// searched disparity left of their edge are `SSVL_DISPARITY_INVALID`. With `lr_check`
+// the sums are also searched along their diagonals, see `ssvl_cost_volume_search_row`
+SSVL_FUNC void ssvl_sgm_select_row(ssvl_t *ssvl, ssvl_worker_scratch_t *scratch, uint16_t left_cell_y, const uint16_t *sums){
+    const uint16_t stride = ssvl->sgm_disparity_stride;
+    const uint16_t count = ssvl->active_max_disparity - ssvl->active_min_disparity + 1;
+    const uint32_t row_index = left_cell_y*ssvl->depth_width;
+    uint16_t *disparities = scratch->cell_disparities;
+
+    if(ssvl->lr_check){
+        memset(scratch->right_best_costs, 0xFF, ssvl->width * sizeof(uint32_t));
+    }
+
+    for(uint16_t cell_x=0; cell_x<ssvl->depth_width; cell_x++){
+        const int32_t starting_x = cell_x * ssvl->cell_stride;
+        const uint16_t *cell_sums = sums + cell_x*stride;
+
+        if(starting_x < ssvl->active_min_disparity){
+            disparities[cell_x] = SSVL_DISPARITY_INVALID;
+            continue;
+        }
+
+        const int32_t valid_count = starting_x - ssvl->active_min_disparity + 1;
+        const uint16_t candidate_count = (valid_count < count) ? (uint16_t)valid_count : count;
+        uint16_t best_index = 0;
+
+        for(uint16_t i=1; i<candidate_count; i++){
+            if(cell_sums[i] < cell_sums[best_index]){
+                best_index = i;
+            }
+        }
+
+        disparities[cell_x] = ssvl->active_min_disparity + best_index;
+
+        if(ssvl->lr_check){
+            uint32_t *right_best_costs = scratch->right_best_costs + starting_x - ssvl->active_min_disparity;
+            uint16_t *right_disparities = scratch->right_disparities + starting_x - ssvl->active_min_disparity;
+
+            // Right window `starting_x - disparity` for each candidate, visited in increasing
+            // disparity for every window as cells go right
+            for(uint16_t i=0; i<candidate_count; i++){
+                if(cell_sums[i] < right_best_costs[-(int32_t)i]){
+                    right_best_costs[-(int32_t)i] = cell_sums[i];
+                    right_disparities[-(int32_t)i] = ssvl->active_min_disparity + i;
+                }
+            }
+        }
+    }
+
+    for(uint16_t cell_x=0; cell_x<ssvl->depth_width; cell_x++){
+        if(ssvl->lr_check && ssvl_lr_consistent(ssvl, scratch, cell_x, disparities[cell_x]) == false){
+            ssvl_store_mark(ssvl, row_index + cell_x, SSVL_CELL_REJECTED);
+        }else{
+            ssvl_store_disparity(ssvl, row_index + cell_x, disparities[cell_x]);
+        }
+    }
+}
+
+
+// Single pass SGM (`SSVL_SGM_SINGLE_PASS`) of one row of cells, the rows above must already
+// be done. Only this row's costs and sums and the previous row's paths are kept
+SSVL_FUNC void ssvl_sgm_single_pass_row(ssvl_t *ssvl, uint16_t left_cell_y){
+    ssvl_worker_scratch_t *scratch = &ssvl->worker_scratch[0];
+
+    ssvl_sgm_cost_row(ssvl, scratch, left_cell_y, ssvl->sgm_costs);
+    memset(ssvl->sgm_sums, 0, ssvl->depth_width * ssvl->sgm_disparity_stride * sizeof(uint16_t));
+
+    ssvl_sgm_horizontal_row(ssvl, scratch->sgm_paths, ssvl->sgm_costs, ssvl->sgm_sums);
+    ssvl_sgm_vertical_row(ssvl, left_cell_y, true, true, ssvl->sgm_costs, ssvl->sgm_sums);
+    ssvl_sgm_select_row(ssvl, scratch, left_cell_y, ssvl->sgm_sums);
+}
+
+
+// Adds a row of disparities in `disparity_depth_buffer` (or `disparity_u16_buffer`) to
+// `disparity_histogram`, the first row of a frame starts it over
+SSVL_FUNC void ssvl_histogram_disparity_row(ssvl_t *ssvl, uint16_t y){
+    if(y == 0){
+        memset(ssvl->disparity_histogram, 0, (ssvl->max_disparity + 1) * sizeof(uint32_t));
+    }
+
+    if(ssvl->output_format == SSVL_OUTPUT_UINT16){
+        const uint16_t *row = ssvl->disparity_u16_buffer + y*ssvl->depth_width;
+
+        // Marked cells and cells without a candidate are above every disparity
+        for(int32_t x=0; x<ssvl->depth_width; x++){
+            if(row[x] < SSVL_CELL_U16_SKIPPED){
+                ssvl->disparity_histogram[row[x] >> ssvl->disparity_fraction_bits]++;
+            }
+        }
+
+        return;
+    }
+
+    const float *row = ssvl->disparity_depth_buffer + y*ssvl->depth_width;
+
+    for(int32_t x=0; x<ssvl->depth_width; x++){
+        if(row[x] >= 0.0f && row[x] <= (float)ssvl->max_disparity){
+            ssvl->disparity_histogram[(uint16_t)row[x]]++;
+        }
+    }
+}
+
+
+// Narrows `active_min_disparity` ~ `active_max_disparity` for the next frame to the
+// disparities found in this frame (every row added with `ssvl_histogram_disparity_row`).
+// Outliers are dropped, `SSVL_ADAPTIVE_RANGE_MARGIN` is added to both sides and if too
+// many cells sit on a bound of an already narrowed range, the full range is restored
+SSVL_FUNC void ssvl_update_adaptive_disparity_range(ssvl_t *ssvl){
+    const uint32_t *histogram = ssvl->disparity_histogram;
+    uint32_t valid_count = 0;
+
+    for(uint32_t disparity=0; disparity<=ssvl->max_disparity; disparity++){
+        valid_count += histogram[disparity];
+    }
+
+    if(valid_count == 0){
+        ssvl->active_min_disparity = ssvl->min_disparity;
+        ssvl->active_max_disparity = ssvl->max_disparity;
+        return;
+    }
+
+    // Things may have moved outside of a narrowed range (cells pile up on its bounds)
+    const uint32_t edge_limit = valid_count * SSVL_ADAPTIVE_RANGE_EDGE_PERCENT / 100;
+    const bool low_edge_hit = ssvl->active_min_disparity > ssvl->min_disparity && histogram[ssvl->active_min_disparity] > edge_limit;
+    const bool high_edge_hit = ssvl->active_max_disparity < ssvl->max_disparity && histogram[ssvl->active_max_disparity] > edge_limit;
+
+    if(low_edge_hit || high_edge_hit){
+        ssvl->active_min_disparity = ssvl->min_disparity;
+        ssvl->active_max_disparity = ssvl->max_disparity;
+        return;
+    }
+
+    // Drop outliers from both ends of the histogram
+    const uint32_t outlier_count = valid_count * SSVL_ADAPTIVE_RANGE_OUTLIER_PERCENT / 100;
+    uint32_t low = ssvl->min_disparity;
+    uint32_t high = ssvl->max_disparity;
+
+    for(uint32_t count=0; low<high; low++){
+        count += histogram[low];
+        if(count > outlier_count) break;
+    }
+
+    for(uint32_t count=0; high>low; high--){
+        count += histogram[high];
+        if(count > outlier_count) break;
+    }
+
+    low = (low >= (uint32_t)(ssvl->min_disparity + SSVL_ADAPTIVE_RANGE_MARGIN)) ? (low - SSVL_ADAPTIVE_RANGE_MARGIN) : ssvl->min_disparity;
+    high = (high + SSVL_ADAPTIVE_RANGE_MARGIN <= ssvl->max_disparity) ? (high + SSVL_ADAPTIVE_RANGE_MARGIN) : ssvl->max_disparity;
+
+    ssvl->active_min_disparity = (uint16_t)low;
+    ssvl->active_max_disparity = (uint16_t)high;
+}
+
+
+// Depth of a disparity, max depth if the disparity is close to zero. Rejected and skipped
+// cells (negative) stay as they are
+SSVL_FUNC float ssvl_disparity_depth(ssvl_t *ssvl, float disparity){
+    if(disparity < 0.0f){
+        return disparity;
+    }else if(disparity >= 1.0f && disparity < ssvl->width){
+        // Depth = focal_length_pixels * base_line_mm / disparity_pixels
+        return ssvl->focal_length_pixels * ssvl->baseline_mm / disparity;
+    }
+
+    return ssvl->max_depth_mm;
+}
+
+
+// Converts a row of disparities in `disparity_depth_buffer` to depths (`SSVL_OUTPUT_UINT16`
+// depths are stored with their disparities)
+SSVL_FUNC void ssvl_calculate_depth_row(ssvl_t *ssvl, uint16_t y){
+    if(ssvl->output_format == SSVL_OUTPUT_UINT16) return;
+
+    float *row = ssvl->disparity_depth_buffer + y*ssvl->depth_width;
+
+    for(int32_t x=0; x<ssvl->depth_width; x++){
+        row[x] = ssvl_disparity_depth(ssvl, row[x]);
+    }
+}
+
+
+// Converts the disparity of one cell in `disparity_depth_buffer` to its depth
+SSVL_FUNC void ssvl_calculate_depth_cell(ssvl_t *ssvl, uint32_t cell_index){
+    if(ssvl->output_format == SSVL_OUTPUT_UINT16) return;
+
+    ssvl->disparity_depth_buffer[cell_index] = ssvl_disparity_depth(ssvl, ssvl->disparity_depth_buffer[cell_index]);
+}
+
+
+SSVL_FUNC void ssvl_calculate_depth(ssvl_t *ssvl){
+    for(int32_t y=0; y<ssvl->depth_height; y++){
+        ssvl_calculate_depth_row(ssvl, y);
+    }
+}
+
+
+// `ssvl_process` stages split into tasks for `ssvl_parallel_for`, `task_ctx` is the library instance
+
+// Number of grayscale tasks for each eye, the last one may have fewer rows
+SSVL_FUNC uint32_t ssvl_grayscale_side_task_count(ssvl_t *ssvl){
+    return (ssvl->height + ssvl->grayscale_task_rows - 1) / ssvl->grayscale_task_rows;
+}
+
+
+// Mask: true if any cell of the row is in `cell_mask`
+SSVL_FUNC bool ssvl_mask_row_wanted(ssvl_t *ssvl, uint16_t left_cell_y){
+    const uint8_t *mask_row = ssvl->cell_mask + left_cell_y*ssvl->depth_width;
+
+    for(uint16_t left_cell_x=0; left_cell_x<ssvl->depth_width; left_cell_x++){
+        if(mask_row[left_cell_x] != 0) return true;
+    }
+
+    return false;
+}
+
+
+// Pixel rows `first_y` ~ `end_y`-1 the search of a row of cells reads: its band, the rows its census
+// descriptors come from and the full resolution rows of its windows at coarser pyramid levels
+SSVL_FUNC void ssvl_cell_row_span(ssvl_t *ssvl, uint16_t left_cell_y, uint16_t *first_y, uint16_t *end_y){
+    const uint16_t window_dimensions = ssvl->search_window_dimensions;
+    const int32_t census_radius = ssvl->census ? SSVL_CENSUS_RADIUS : 0;
+    int32_t first = left_cell_y*ssvl->cell_stride - census_radius;
+    int32_t end = left_cell_y*ssvl->cell_stride + window_dimensions + census_radius;
+
+    for(uint8_t level=1; level<ssvl->pyramid_levels; level++){
+        const uint16_t level_height = ssvl->height >> level;
+        uint16_t window_y = (uint16_t)((left_cell_y * ssvl->cell_stride) >> level);
+        if(window_y > level_height - window_dimensions) window_y = level_height - window_dimensions;
+
+        if((window_y << level) < first) first = window_y << level;
+        if(((window_y + window_dimensions) << level) > end) end = (window_y + window_dimensions) << level;
+    }
+
+    *first_y = (first > 0) ? (uint16_t)first : 0;
+    *end_y = (end < ssvl->height) ? (uint16_t)end : ssvl->height;
+}
+
+
+// Mask: marks the grayscale tasks and census bands of both eyes that a row of cells reads
+// and haven't been wanted yet this frame
+SSVL_FUNC void ssvl_want_cell_rows(ssvl_t *ssvl, uint16_t left_cell_y){
+    const uint32_t side_task_count = ssvl_grayscale_side_task_count(ssvl);
+    uint16_t first_y;
+    uint16_t end_y;
+    ssvl_cell_row_span(ssvl, left_cell_y, &first_y, &end_y);
+
+    for(uint32_t task=first_y/ssvl->grayscale_task_rows; task<=(uint32_t)(end_y-1)/ssvl->grayscale_task_rows; task++){
+        for(uint8_t side=0; side<2; side++){
+            uint8_t *state = &ssvl->grayscale_task_states[side*side_task_count + task];
+            if(*state == SSVL_ROWS_SKIPPED) *state = SSVL_ROWS_WANTED;
+        }
+    }
+
+    // Bands holding the row's windows, only its own band unless cells overlap
+    if(ssvl->census){
+        const uint16_t first_band = (uint16_t)(left_cell_y * ssvl->cell_stride / ssvl->search_window_dimensions);
+        const uint16_t last_band = (uint16_t)((left_cell_y * ssvl->cell_stride + ssvl->search_window_dimensions - 1) / ssvl->search_window_dimensions);
+
+        for(uint16_t band=first_band; band<=last_band; band++){
+            for(uint8_t side=0; side<2; side++){
+                uint8_t *state = &ssvl->census_band_states[side*ssvl->census_band_count + band];
+                if(*state == SSVL_ROWS_SKIPPED) *state = SSVL_ROWS_WANTED;
+            }
+        }
+    }
+}
+
+
+// Mask: starts a frame with the mask set by `ssvl_set_cell_mask`, nothing computed yet and only
+// the rows the masked cells read wanted (streaming converts every row while feeding)
+SSVL_FUNC void ssvl_mask_start_frame(ssvl_t *ssvl){
+    ssvl->frame_masked = ssvl->masked;
+    ssvl->rows_masked = ssvl->masked && ssvl->streaming == false;
+
+    if(ssvl->rows_masked == false){
+        return;
+    }
+
+    memset(ssvl->cell_computed, 0, ssvl->depth_cell_count);
+    memset(ssvl->grayscale_task_states, SSVL_ROWS_SKIPPED, 2*ssvl_grayscale_side_task_count(ssvl));
+    memset(ssvl->census_band_states, SSVL_ROWS_SKIPPED, 2*ssvl->census_band_count);
+
+    for(uint16_t left_cell_y=0; left_cell_y<ssvl->depth_height; left_cell_y++){
+        if(ssvl_mask_row_wanted(ssvl, left_cell_y)) ssvl_want_cell_rows(ssvl, left_cell_y);
+    }
+}
+
+
+// Grayscale conversion of `grayscale_task_rows` pixel rows (a band, pairs of rows for
+// Bayer) from `source_frames` (`rectify_rows` when rectifying) into `frame_buffers`, the
+// first half of the tasks are the left eye's rows and the rest are the right eye's. The
+// pyramid levels of the rows are built right after, while they are still in cache
+SSVL_FUNC void ssvl_grayscale_task(void *task_ctx, uint32_t task_index, uint32_t worker_index){
+    ssvl_t *ssvl = (ssvl_t*)task_ctx;
+    (void)worker_index;
+    const uint32_t side_task_count = ssvl_grayscale_side_task_count(ssvl);
+    const ssvl_camera_side side = (task_index < side_task_count) ? SSVL_LEFT_CAMERA : SSVL_RIGHT_CAMERA;
+    const uint16_t first_y = (uint16_t)(task_index % side_task_count) * ssvl->grayscale_task_rows;
+    const uint16_t end_y = (ssvl->height - first_y > ssvl->grayscale_task_rows) ? (uint16_t)(first_y + ssvl->grayscale_task_rows) : ssvl->height;
+
+    if(ssvl->rows_masked){
+        if(ssvl->grayscale_task_states[task_index] != SSVL_ROWS_WANTED) return;
+        ssvl->grayscale_task_states[task_index] = SSVL_ROWS_READY;
+    }
+
+    if(ssvl->rectify){
+        for(uint16_t y=first_y; y<end_y; y++){
+            ssvl_rectify_row(ssvl, side, y, ssvl_frame_buffer_pixel(ssvl, side, y*ssvl->width));
+        }
+    }else if(ssvl->input_format >= SSVL_FORMAT_BAYER_RGGB8){
+        for(uint16_t y=first_y; y<end_y; y+=2){
+            const uint8_t *source_row = ssvl->source_frames[side] + y*ssvl->source_stride;
+
+            ssvl_convert_bayer_to_grayscale(ssvl, ssvl_frame_buffer_pixel(ssvl, side, y*ssvl->width), ssvl_frame_buffer_pixel(ssvl, side, (y+1)*ssvl->width),
+                                            source_row, source_row + ssvl->source_stride, ssvl->width);
+        }
+    }else{
+        for(uint16_t y=first_y; y<end_y; y++){
+            ssvl_convert_to_grayscale(ssvl, ssvl_frame_buffer_pixel(ssvl, side, y*ssvl->width), ssvl->source_frames[side] + y*ssvl->source_stride, ssvl->width);
+        }
+    }
+
+    if(ssvl->pyramid_levels > 1){
+        ssvl_pyramid_rows(ssvl, side, first_y, end_y);
+    }
+}
 
-    for(uint32_t i=0; i<pixel_count; i++){
-        // Extract the color channel bits and shift all the way right
-        uint16_t r = (buffer[i] & r_mask) >> r_shift_amount;
-        uint16_t g = (buffer[i] & g_mask) >> g_shift_amount;
-        uint16_t b = (buffer[i] & b_mask) >> b_shift_amount;
 
-        // Normalize each channel to 0.0 ~ 1.0
-        float r_normal = (float)r / (float)r_total_magnitude;
-        float g_normal = (float)g / (float)g_total_magnitude;
-        float b_normal = (float)b / (float)b_total_magnitude;
+// Pyramid levels of the same rows as `ssvl_grayscale_task`, for frames `ssvl_feed` converted
+SSVL_FUNC void ssvl_pyramid_task(void *task_ctx, uint32_t task_index, uint32_t worker_index){
+    ssvl_t *ssvl = (ssvl_t*)task_ctx;
+    (void)worker_index;
+    const uint32_t side_task_count = ssvl_grayscale_side_task_count(ssvl);
+    const ssvl_camera_side side = (task_index < side_task_count) ? SSVL_LEFT_CAMERA : SSVL_RIGHT_CAMERA;
+    const uint16_t first_y = (uint16_t)(task_index % side_task_count) * ssvl->grayscale_task_rows;
+    const uint16_t end_y = (ssvl->height - first_y > ssvl->grayscale_task_rows) ? (uint16_t)(first_y + ssvl->grayscale_task_rows) : ssvl->height;
+
+    if(ssvl->rows_masked){
+        if(ssvl->grayscale_task_states[task_index] != SSVL_ROWS_WANTED) return;
+        ssvl->grayscale_task_states[task_index] = SSVL_ROWS_READY;
+    }
+
+    ssvl_pyramid_rows(ssvl, side, first_y, end_y);
+}
+
+
+// Census descriptors of one band, the first half of the tasks are the left eye's bands
+// and the rest are the right eye's
+SSVL_FUNC void ssvl_census_task(void *task_ctx, uint32_t task_index, uint32_t worker_index){
+    ssvl_t *ssvl = (ssvl_t*)task_ctx;
+    (void)worker_index;
+    const ssvl_camera_side side = (task_index < ssvl->census_band_count) ? SSVL_LEFT_CAMERA : SSVL_RIGHT_CAMERA;
+
+    if(ssvl->rows_masked){
+        if(ssvl->census_band_states[task_index] != SSVL_ROWS_WANTED) return;
+        ssvl->census_band_states[task_index] = SSVL_ROWS_READY;
+    }
+
+    ssvl_census_band(ssvl, side, (uint16_t)(task_index % ssvl->census_band_count));
+}
+
+
+// Disparities of one row of depth cells into `disparity_depth_buffer`, only the cells in `mask_row`
+// if not NULL (the rest are `SSVL_CELL_SKIPPED`). Computed cells are marked in `computed_row` if not NULL
+SSVL_FUNC void ssvl_search_row(ssvl_t *ssvl, ssvl_worker_scratch_t *scratch, uint16_t left_cell_y, const uint8_t *mask_row, uint8_t *computed_row){
+    const uint32_t row_index = left_cell_y*ssvl->depth_width;
+
+    // The left-right check needs the costs of the whole row, the cost volume search keeps them and
+    // shares overlapping windows' columns. Temporal and pyramid searches narrow each cell's own
+    // range so they're window searches
+    const bool shared_columns = ssvl->search_engine == SSVL_ENGINE_COST_VOLUME || ssvl->cell_stride < ssvl->search_window_dimensions;
+    const bool cost_volume = ssvl->lr_check || (shared_columns && ssvl->temporal == false && ssvl->pyramid_levels == 1);
+
+    // The cost volume search always computes the whole row of cells, only the masked ones are kept
+    // (the others may read pixels that weren't converted)
+    if(cost_volume && (ssvl->aggregate_pixel_comparer == ssvl_sad_comparer || ssvl->aggregate_pixel_comparer == ssvl_census_comparer)){
+        ssvl_cost_volume_search_row(ssvl, scratch, left_cell_y, scratch->cell_disparities);
+
+        for(int32_t left_cell_x=0; left_cell_x<ssvl->depth_width; left_cell_x++){
+            if(mask_row != NULL && mask_row[left_cell_x] == 0){
+                ssvl_store_mark(ssvl, row_index + left_cell_x, SSVL_CELL_SKIPPED);
+                continue;
+            }
+
+            if(ssvl->lr_check && ssvl_lr_consistent(ssvl, scratch, left_cell_x, scratch->cell_disparities[left_cell_x]) == false){
+                ssvl_store_mark(ssvl, row_index + left_cell_x, SSVL_CELL_REJECTED);
+            }else{
+                ssvl_store_disparity(ssvl, row_index + left_cell_x, scratch->cell_disparities[left_cell_x]);
+            }
+
+            if(computed_row != NULL) computed_row[left_cell_x] = 1;
+        }
+    }else{
+        for(int32_t left_cell_x=0; left_cell_x<ssvl->depth_width; left_cell_x++){
+            if(mask_row != NULL && mask_row[left_cell_x] == 0){
+                ssvl_store_mark(ssvl, row_index + left_cell_x, SSVL_CELL_SKIPPED);
+                continue;
+            }
+
+            ssvl_store_disparity(ssvl, row_index + left_cell_x, ssvl_cell_search(ssvl, scratch, left_cell_x, left_cell_y));
+            if(computed_row != NULL) computed_row[left_cell_x] = 1;
+        }
+    }
+}
+
+
+// Disparities of one row of depth cells, only the masked ones with a cell mask
+SSVL_FUNC void ssvl_search_task(void *task_ctx, uint32_t task_index, uint32_t worker_index){
+    ssvl_t *ssvl = (ssvl_t*)task_ctx;
+    const uint8_t *mask_row = NULL;
+    uint8_t *computed_row = NULL;
+
+    if(ssvl->frame_masked){
+        if(ssvl_mask_row_wanted(ssvl, task_index) == false){
+            for(int32_t left_cell_x=0; left_cell_x<ssvl->depth_width; left_cell_x++){
+                ssvl_store_mark(ssvl, task_index*ssvl->depth_width + left_cell_x, SSVL_CELL_SKIPPED);
+            }
+
+            return;
+        }
+
+        mask_row = ssvl->cell_mask + task_index*ssvl->depth_width;
+        computed_row = ssvl->cell_computed + task_index*ssvl->depth_width;
+    }
+
+    ssvl_search_row(ssvl, &ssvl->worker_scratch[worker_index], task_index, mask_row, computed_row);
+}
+
+
+// Number of tasks of `search_task_rows` rows of cells, the last one may have fewer rows
+SSVL_FUNC uint32_t ssvl_search_block_count(ssvl_t *ssvl){
+    return (ssvl->depth_height + ssvl->search_task_rows - 1) / ssvl->search_task_rows;
+}
+
+
+// `ssvl_search_task` for a block of `search_task_rows` consecutive rows of cells
+SSVL_FUNC void ssvl_search_block_task(void *task_ctx, uint32_t task_index, uint32_t worker_index){
+    ssvl_t *ssvl = (ssvl_t*)task_ctx;
+    const uint32_t first_row = task_index * ssvl->search_task_rows;
+    const uint32_t end_row = (first_row + ssvl->search_task_rows < ssvl->depth_height) ? (first_row + ssvl->search_task_rows) : ssvl->depth_height;
+
+    for(uint32_t row=first_row; row<end_row; row++){
+        ssvl_search_task(task_ctx, row, worker_index);
+    }
+}
+
+
+// SGM costs of one row of cells into the cost volume, starting its path cost sums
+// with the horizontal paths
+SSVL_FUNC void ssvl_sgm_cost_task(void *task_ctx, uint32_t task_index, uint32_t worker_index){
+    ssvl_t *ssvl = (ssvl_t*)task_ctx;
+    ssvl_worker_scratch_t *scratch = &ssvl->worker_scratch[worker_index];
+    const uint32_t row_entries = ssvl->depth_width * ssvl->sgm_disparity_stride;
+    uint16_t *costs = ssvl->sgm_costs + task_index*row_entries;
+    uint16_t *sums = ssvl->sgm_sums + task_index*row_entries;
+
+    ssvl_sgm_cost_row(ssvl, scratch, task_index, costs);
+    memset(sums, 0, row_entries * sizeof(uint16_t));
+
+    ssvl_sgm_horizontal_row(ssvl, scratch->sgm_paths, costs, sums);
+}
+
+
+// `ssvl_sgm_cost_task` for a block of `search_task_rows` consecutive rows of cells
+SSVL_FUNC void ssvl_sgm_cost_block_task(void *task_ctx, uint32_t task_index, uint32_t worker_index){
+    ssvl_t *ssvl = (ssvl_t*)task_ctx;
+    const uint32_t first_row = task_index * ssvl->search_task_rows;
+    const uint32_t end_row = (first_row + ssvl->search_task_rows < ssvl->depth_height) ? (first_row + ssvl->search_task_rows) : ssvl->depth_height;
+
+    for(uint32_t row=first_row; row<end_row; row++){
+        ssvl_sgm_cost_task(task_ctx, row, worker_index);
+    }
+}
+
+
+// Whole frame SGM disparities into `disparity_depth_buffer`. With the full cost volume, costs
+// and horizontal paths are found for all rows in parallel, then the paths from above are added
+// going down and the ones from below going up, each row is finished on the way up
+SSVL_FUNC void ssvl_sgm_search(ssvl_t *ssvl){
+    if(ssvl->sgm == SSVL_SGM_SINGLE_PASS){
+        for(uint16_t y=0; y<ssvl->depth_height; y++){
+            ssvl_sgm_single_pass_row(ssvl, y);
+        }
+
+        return;
+    }
+
+    const uint32_t row_entries = ssvl->depth_width * ssvl->sgm_disparity_stride;
+    const bool diagonals = (ssvl->sgm == SSVL_SGM_8_PATHS);
+
+    ssvl_parallel_for(ssvl, ssvl_search_block_count(ssvl), ssvl_sgm_cost_block_task, ssvl);
+
+    for(uint16_t y=0; y<ssvl->depth_height; y++){
+        ssvl_sgm_vertical_row(ssvl, y, true, diagonals, ssvl->sgm_costs + y*row_entries, ssvl->sgm_sums + y*row_entries);
+    }
+
+    for(int32_t y=ssvl->depth_height-1; y>=0; y--){
+        ssvl_sgm_vertical_row(ssvl, (uint16_t)y, false, diagonals, ssvl->sgm_costs + y*row_entries, ssvl->sgm_sums + y*row_entries);
+        ssvl_sgm_select_row(ssvl, &ssvl->worker_scratch[0], (uint16_t)y, ssvl->sgm_sums + y*row_entries);
+    }
+}
+
+
+// Row `y` of `disparity_depth_buffer` for `on_depth_row_cb`, NULL with `SSVL_OUTPUT_UINT16`
+SSVL_FUNC float *ssvl_depth_row(ssvl_t *ssvl, uint16_t y){
+    return (ssvl->disparity_depth_buffer != NULL) ? ssvl->disparity_depth_buffer + y*ssvl->depth_width : NULL;
+}
+
+
+// Whether frames have a depth stage: float depths to calculate or points to reproject
+SSVL_FUNC bool ssvl_has_depth_stage(ssvl_t *ssvl){
+    return ssvl->output_format == SSVL_OUTPUT_FLOAT || ssvl->point_cloud != SSVL_POINT_CLOUD_OFF;
+}
+
+
+// Depths of row `y` of depth cells, along with its points with `point_cloud`
+SSVL_FUNC void ssvl_depth_stage_row(ssvl_t *ssvl, uint16_t y){
+    if(ssvl->point_cloud != SSVL_POINT_CLOUD_OFF){
+        ssvl_reproject_row(ssvl, y);
+    }else{
+        ssvl_calculate_depth_row(ssvl, y);
+    }
+}
+
+
+// Depths of one row of depth cells
+SSVL_FUNC void ssvl_depth_task(void *task_ctx, uint32_t task_index, uint32_t worker_index){
+    (void)worker_index;
+    ssvl_depth_stage_row((ssvl_t*)task_ctx, (uint16_t)task_index);
+}
+
+
+// Hands the frame's points to `on_points_cb`
+SSVL_FUNC void ssvl_report_points(ssvl_t *ssvl){
+    if(ssvl->on_points_cb != NULL && ssvl->point_cloud != SSVL_POINT_CLOUD_OFF){
+        ssvl->on_points_cb(ssvl->points_opaque_ptr, ssvl->point_buffers[0], ssvl->point_buffers[1], ssvl->point_buffers[2], ssvl->point_count);
+    }
+}
+
+
+// Temporal: starts a frame's fallback counts (see `ssvl_get_temporal_fallbacks`)
+SSVL_FUNC void ssvl_clear_temporal_fallbacks(ssvl_t *ssvl){
+    for(uint8_t worker_index=0; worker_index<ssvl->worker_count; worker_index++){
+        ssvl->worker_scratch[worker_index].temporal_fallbacks = 0;
+    }
+}
+
+
+// Processes the frames in `frame_buffers` (`ssvl_process` without touching the feeding state,
+// also run by the asynchronous pipeline's thread)
+SSVL_FUNC bool ssvl_process_frame(ssvl_t *ssvl){
+    // We have both frames from both cameras, need to go through
+    // and calculate disparity for each pixel block and then the
+    // depth for each pixel block
+
+    // Before relating blocks between left and right eyes, 
+    // change the 3 component pixels to single component
+    // linear values of intensity, grayscale
+    // Every stage is split into rows/bands for `parallel_for` (if set), the results
+    // are identical to running them in order on this thread. `ssvl_feed` already
+    // converted the frames while copying them in
+    bool pyramid_built = ssvl->frames_pyramid;
+
+    // `ssvl_process_frames` started the frame before converting it
+    if(ssvl->frames_pyramid == false){
+        ssvl_stats_start_frame(ssvl);
+        ssvl_mask_start_frame(ssvl);
+    }
+
+    ssvl->frame_queryable = false;
+    ssvl->frame_fed = ssvl->frames_grayscale && ssvl->frames_pyramid == false;
+
+    if(ssvl->frames_grayscale == false || (ssvl->rectify && ssvl->frame_fed)){
+        if(ssvl->frames_grayscale == false){
+            // Directly filled rows are as wide as grayscale rows, too narrow for 2 byte pixels in 8-bit,
+            // and can't be rectified in place
+            if(ssvl->input_bytes_per_pixel > sizeof(ssvl_gray_t) || ssvl->rectify){
+                ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_CONFIG);
+                return false;
+            }
+
+            ssvl->source_frames[SSVL_LEFT_CAMERA] = (const uint8_t*)ssvl->frame_buffers[SSVL_LEFT_CAMERA];
+            ssvl->source_frames[SSVL_RIGHT_CAMERA] = (const uint8_t*)ssvl->frame_buffers[SSVL_RIGHT_CAMERA];
+            ssvl->source_stride = ssvl->width * sizeof(ssvl_gray_t);
+        }else{
+            // Fed frames are grayscale in `source_frames`, waiting to be rectified
+            ssvl_rectify_point_rows(ssvl, SSVL_LEFT_CAMERA, ssvl->source_frames[SSVL_LEFT_CAMERA], ssvl->width * sizeof(ssvl_gray_t), ssvl->height, true);
+            ssvl_rectify_point_rows(ssvl, SSVL_RIGHT_CAMERA, ssvl->source_frames[SSVL_RIGHT_CAMERA], ssvl->width * sizeof(ssvl_gray_t), ssvl->height, true);
+        }
+
+        ssvl_stats_stage_begin(ssvl, SSVL_STAGE_GRAYSCALE);
+        ssvl_parallel_for(ssvl, 2*ssvl_grayscale_side_task_count(ssvl), ssvl_grayscale_task, ssvl);
+        ssvl_stats_stage_end(ssvl, SSVL_STAGE_GRAYSCALE);
+        pyramid_built = true;
+    }
+
+    ssvl->frames_grayscale = false;
+    ssvl->frames_pyramid = false;
+
+    if(ssvl->pyramid_levels > 1 && pyramid_built == false){
+        ssvl_stats_stage_begin(ssvl, SSVL_STAGE_PYRAMID);
+        ssvl_parallel_for(ssvl, 2*ssvl_grayscale_side_task_count(ssvl), ssvl_pyramid_task, ssvl);
+        ssvl_stats_stage_end(ssvl, SSVL_STAGE_PYRAMID);
+    }
+
+    if(ssvl->on_grayscale_cb != NULL) ssvl->on_grayscale_cb(ssvl->grayscale_opaque_ptr, SSVL_LEFT_CAMERA, ssvl->frame_buffers[SSVL_LEFT_CAMERA], ssvl->width, ssvl->height);
+    if(ssvl->on_grayscale_cb != NULL) ssvl->on_grayscale_cb(ssvl->grayscale_opaque_ptr, SSVL_RIGHT_CAMERA, ssvl->frame_buffers[SSVL_RIGHT_CAMERA], ssvl->width, ssvl->height);
+
+    if(ssvl->census){
+        ssvl_stats_stage_begin(ssvl, SSVL_STAGE_CENSUS);
+        ssvl_parallel_for(ssvl, 2*ssvl->census_band_count, ssvl_census_task, ssvl);
+        ssvl_stats_stage_end(ssvl, SSVL_STAGE_CENSUS);
+    }
+
+    ssvl->frame_min_disparity = ssvl->active_min_disparity;
+    ssvl->frame_max_disparity = ssvl->active_max_disparity;
+
+    ssvl_stats_stage_begin(ssvl, SSVL_STAGE_SEARCH);
+    ssvl_forget_shared_rows(ssvl);
+
+    if(ssvl->sgm != SSVL_SGM_OFF){
+        ssvl_sgm_search(ssvl);
+    }else{
+        ssvl_clear_temporal_fallbacks(ssvl);
+        ssvl_parallel_for(ssvl, ssvl_search_block_count(ssvl), ssvl_search_block_task, ssvl);
+    }
+
+    ssvl_stats_stage_end(ssvl, SSVL_STAGE_SEARCH);
+
+    // `SSVL_OUTPUT_UINT16` has no float buffer, the callbacks get NULL
+    if(ssvl->on_disparity_cb != NULL) ssvl->on_disparity_cb(ssvl->disparity_opaque_ptr, ssvl->disparity_depth_buffer, ssvl->depth_width, ssvl->depth_height);
+
+    if(ssvl->adaptive_disparity_range){
+        ssvl_stats_stage_begin(ssvl, SSVL_STAGE_ADAPTIVE_RANGE);
+
+        for(uint16_t y=0; y<ssvl->depth_height; y++){
+            ssvl_histogram_disparity_row(ssvl, y);
+        }
+
+        ssvl_update_adaptive_disparity_range(ssvl);
+        ssvl_stats_stage_end(ssvl, SSVL_STAGE_ADAPTIVE_RANGE);
+    }
+
+    if(ssvl_has_depth_stage(ssvl)){
+        ssvl_stats_stage_begin(ssvl, SSVL_STAGE_DEPTH);
+        ssvl_parallel_for(ssvl, ssvl->depth_height, ssvl_depth_task, ssvl);
+        if(ssvl->point_cloud != SSVL_POINT_CLOUD_OFF) ssvl_finish_points(ssvl);
+        ssvl_stats_stage_end(ssvl, SSVL_STAGE_DEPTH);
+    }
+
+    if(ssvl->on_depth_row_cb != NULL){
+        for(uint16_t y=0; y<ssvl->depth_height; y++){
+            ssvl->on_depth_row_cb(ssvl->depth_row_opaque_ptr, ssvl_depth_row(ssvl, y), y, ssvl->depth_width, ssvl->max_depth_mm);
+        }
+    }
+
+    if(ssvl->on_depth_cb != NULL) ssvl->on_depth_cb(ssvl->depth_opaque_ptr, ssvl->disparity_depth_buffer, ssvl->depth_width, ssvl->depth_height, ssvl->max_depth_mm);
+    ssvl_report_points(ssvl);
+
+    ssvl_stats_end_frame(ssvl);
+    ssvl->frame_queryable = true;
+
+    return true;
+}
+
+
+// Left and right camera buffers are full, process them
+SSVL_FUNC bool ssvl_process(ssvl_t *ssvl){
+    // Streaming frame buffers never hold whole frames, `ssvl_feed` processes them,
+    // and the asynchronous pipeline only processes the frames it queued
+    if(ssvl->streaming || ssvl->async != NULL){
+        ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_CONFIG);
+        return false;
+    }
+
+    // Reset these for next incoming frames after processing
+    ssvl->frame_buffers_amounts[SSVL_LEFT_CAMERA] = 0;
+    ssvl->frame_buffers_amounts[SSVL_RIGHT_CAMERA] = 0;
+
+    // `ssvl_process_frames` numbered the frame when it started it
+    if(ssvl->frames_pyramid == false){
+        ssvl->frame_sequence++;
+    }
+
+    return ssvl_process_frame(ssvl);
+}
+
+
+// Streaming: first row of the frame still needed in the ring of `frame_buffers`, the first row of
+// the band waiting to be searched (or the rows above it census reads)
+SSVL_FUNC uint32_t ssvl_stream_oldest_row(ssvl_t *ssvl){
+    const uint32_t band_first_row = (uint32_t)ssvl->stream_next_band * ssvl->search_window_dimensions;
+    const uint32_t rows_above = ssvl->census ? SSVL_CENSUS_RADIUS : 0;
+
+    return (band_first_row > rows_above) ? (band_first_row - rows_above) : 0;
+}
+
+
+// Streaming: rectifies the rows whose source rows both eyes have been fed (`source_rows` of them)
+// into the ring of `frame_buffers`, as far as it has room. Returns the rows rectified so far
+SSVL_FUNC uint32_t ssvl_stream_rectify_rows(ssvl_t *ssvl, uint32_t source_rows){
+    uint32_t end_y = ssvl_stream_oldest_row(ssvl) + ssvl->frame_buffer_rows;
+    if(end_y > ssvl->height) end_y = ssvl->height;
+
+    if(ssvl->rectify_rows_done < end_y && ssvl->rectify_source_ends[ssvl->rectify_rows_done] <= source_rows){
+        ssvl_stats_stage_begin(ssvl, SSVL_STAGE_GRAYSCALE);
+
+        while(ssvl->rectify_rows_done < end_y && ssvl->rectify_source_ends[ssvl->rectify_rows_done] <= source_rows){
+            const uint16_t y = ssvl->rectify_rows_done;
+
+            ssvl_rectify_row(ssvl, SSVL_LEFT_CAMERA, y, ssvl_frame_buffer_pixel(ssvl, SSVL_LEFT_CAMERA, y*ssvl->width));
+            ssvl_rectify_row(ssvl, SSVL_RIGHT_CAMERA, y, ssvl_frame_buffer_pixel(ssvl, SSVL_RIGHT_CAMERA, y*ssvl->width));
+            ssvl->rectify_rows_done++;
+        }
+
+        ssvl_stats_stage_end(ssvl, SSVL_STAGE_GRAYSCALE);
+    }
+
+    return ssvl->rectify_rows_done;
+}
+
+
+// Streaming: searches and calculates depths for every band both eyes have been fed,
+// in order, handing each row to `on_depth_row_cb`. Finishes the frame after its last band.
+// When rectifying, rows are rectified as their source rows are fed and the ring frees up
+SSVL_FUNC void ssvl_stream_process_bands(ssvl_t *ssvl){
+    const uint32_t row_size = ssvl->width * ssvl->input_bytes_per_pixel;
+    const uint32_t left_rows = ssvl->frame_buffers_amounts[SSVL_LEFT_CAMERA] / row_size;
+    const uint32_t right_rows = ssvl->frame_buffers_amounts[SSVL_RIGHT_CAMERA] / row_size;
+    uint32_t fed_rows = (left_rows < right_rows) ? left_rows : right_rows;
+
+    // Bayer rows are converted in pairs, once the second one arrives
+    if(ssvl->input_format >= SSVL_FORMAT_BAYER_RGGB8){
+        fed_rows &= ~1u;
+    }
+
+    // Census also reads rows below the band
+    const uint32_t rows_below = ssvl->census ? SSVL_CENSUS_RADIUS : 0;
+    const uint32_t source_rows = fed_rows;
+
+    while(ssvl->stream_next_band < ssvl->depth_height){
+        const uint16_t y = ssvl->stream_next_band;
+
+        if(ssvl->rectify){
+            fed_rows = ssvl_stream_rectify_rows(ssvl, source_rows);
+        }
+
+        uint32_t needed_rows = (uint32_t)(y + 1) * ssvl->search_window_dimensions + rows_below;
+        if(needed_rows > ssvl->height) needed_rows = ssvl->height;
+
+        if(fed_rows < needed_rows){
+            break;
+        }
+
+        if(y == 0){
+            ssvl->frame_sequence++;
+            ssvl_stats_start_frame(ssvl);
+        }
+
+        if(ssvl->census){
+            ssvl_stats_stage_begin(ssvl, SSVL_STAGE_CENSUS);
+            ssvl_census_band(ssvl, SSVL_LEFT_CAMERA, y);
+            ssvl_census_band(ssvl, SSVL_RIGHT_CAMERA, y);
+            ssvl_stats_stage_end(ssvl, SSVL_STAGE_CENSUS);
+        }
+
+        ssvl_stats_stage_begin(ssvl, SSVL_STAGE_SEARCH);
+
+        // Whole row of cells on this thread, other workers have nothing to run alongside
+        if(ssvl->sgm == SSVL_SGM_SINGLE_PASS){
+            ssvl_sgm_single_pass_row(ssvl, y);
+        }else{
+            if(y == 0){
+                ssvl_clear_temporal_fallbacks(ssvl);
+                ssvl_mask_start_frame(ssvl);
+            }
+
+            ssvl_search_task(ssvl, y, 0);
+        }
+
+        ssvl_stats_stage_end(ssvl, SSVL_STAGE_SEARCH);
+
+        if(ssvl->adaptive_disparity_range){
+            ssvl_stats_stage_begin(ssvl, SSVL_STAGE_ADAPTIVE_RANGE);
+            ssvl_histogram_disparity_row(ssvl, y);
+            ssvl_stats_stage_end(ssvl, SSVL_STAGE_ADAPTIVE_RANGE);
+        }
+
+        if(ssvl_has_depth_stage(ssvl)){
+            ssvl_stats_stage_begin(ssvl, SSVL_STAGE_DEPTH);
+            ssvl_depth_stage_row(ssvl, y);
+            ssvl_stats_stage_end(ssvl, SSVL_STAGE_DEPTH);
+        }
+
+        if(ssvl->on_depth_row_cb != NULL) ssvl->on_depth_row_cb(ssvl->depth_row_opaque_ptr, ssvl_depth_row(ssvl, y), y, ssvl->depth_width, ssvl->max_depth_mm);
+
+        ssvl->stream_next_band++;
+    }
+
+    if(ssvl->stream_next_band == ssvl->depth_height){
+        ssvl->frame_buffers_amounts[SSVL_LEFT_CAMERA] = 0;
+        ssvl->frame_buffers_amounts[SSVL_RIGHT_CAMERA] = 0;
+        ssvl->stream_next_band = 0;
+        ssvl->rectify_rows_done = 0;
+
+        if(ssvl->adaptive_disparity_range){
+            ssvl_stats_stage_begin(ssvl, SSVL_STAGE_ADAPTIVE_RANGE);
+            ssvl_update_adaptive_disparity_range(ssvl);
+            ssvl_stats_stage_end(ssvl, SSVL_STAGE_ADAPTIVE_RANGE);
+        }
+
+        if(ssvl->point_cloud != SSVL_POINT_CLOUD_OFF){
+            ssvl_stats_stage_begin(ssvl, SSVL_STAGE_DEPTH);
+            ssvl_finish_points(ssvl);
+            ssvl_stats_stage_end(ssvl, SSVL_STAGE_DEPTH);
+        }
+
+        ssvl->stats.fed_bytes = ssvl->stats_fed_bytes;
+        ssvl->stats_fed_bytes = 0;
+
+        if(ssvl->on_depth_cb != NULL) ssvl->on_depth_cb(ssvl->depth_opaque_ptr, ssvl->disparity_depth_buffer, ssvl->depth_width, ssvl->depth_height, ssvl->max_depth_mm);
+        ssvl_report_points(ssvl);
+    }
+}
+
+
+#if defined(SSVL_PTHREADS)
+
+// Async: slot in `state` holding the oldest frame (any of them for free slots), `slot_count` if none
+SSVL_FUNC uint8_t ssvl_async_oldest_slot(ssvl_async_t *async, ssvl_async_slot_state state){
+    uint8_t oldest = async->slot_count;
+
+    for(uint8_t slot=0; slot<async->slot_count; slot++){
+        if(async->slot_states[slot] != state) continue;
+
+        // Ages from the newest sequence number still compare correctly once they wrap around
+        if(oldest == async->slot_count || async->fed_sequence - async->slot_sequences[slot] > async->fed_sequence - async->slot_sequences[oldest]){
+            oldest = slot;
+        }
+    }
+
+    return oldest;
+}
+
+
+// Async: a frame is waiting or being processed, its depths will be published
+SSVL_FUNC bool ssvl_async_busy(ssvl_async_t *async){
+    return ssvl_async_oldest_slot(async, SSVL_SLOT_QUEUED) != async->slot_count ||
+           ssvl_async_oldest_slot(async, SSVL_SLOT_PROCESSING) != async->slot_count;
+}
+
+
+// Async: processes the oldest queued frame with `frame_buffers` pointed at its slot and publishes
+// its depths. Called and returns with `mutex` locked, unlocks it while processing
+SSVL_FUNC void ssvl_async_process_oldest(ssvl_async_t *async){
+    ssvl_t *ssvl = async->ssvl;
+    const uint8_t slot = ssvl_async_oldest_slot(async, SSVL_SLOT_QUEUED);
+    ssvl_gray_t *frame_buffers[2] = {ssvl->frame_buffers[SSVL_LEFT_CAMERA], ssvl->frame_buffers[SSVL_RIGHT_CAMERA]};
+
+    async->slot_states[slot] = SSVL_SLOT_PROCESSING;
+    ssvl->frame_sequence = async->slot_sequences[slot];
+    ssvl->stats_queued_fed_bytes = async->slot_fed_bytes[slot];
+    pthread_mutex_unlock(&async->mutex);
+
+    // Fed frames are already grayscale, rectifying reads them from the slot into `frame_buffers`
+    ssvl_gray_t *slot_frames = async->slot_buffers + (uint32_t)slot*2*ssvl->pixel_count;
+
+    if(ssvl->rectify){
+        ssvl->source_frames[SSVL_LEFT_CAMERA] = (const uint8_t*)slot_frames;
+        ssvl->source_frames[SSVL_RIGHT_CAMERA] = (const uint8_t*)(slot_frames + ssvl->pixel_count);
+    }else{
+        ssvl->frame_buffers[SSVL_LEFT_CAMERA] = slot_frames;
+        ssvl->frame_buffers[SSVL_RIGHT_CAMERA] = slot_frames + ssvl->pixel_count;
+    }
+
+    ssvl->frames_grayscale = true;
+    ssvl->frames_pyramid = false;
+
+    ssvl_process_frame(ssvl);
+
+    ssvl->frame_queryable = false;
+    ssvl->frame_buffers[SSVL_LEFT_CAMERA] = frame_buffers[SSVL_LEFT_CAMERA];
+    ssvl->frame_buffers[SSVL_RIGHT_CAMERA] = frame_buffers[SSVL_RIGHT_CAMERA];
+
+    pthread_mutex_lock(&async->mutex);
+    memcpy(async->depth_buffer, ssvl->disparity_depth_buffer, ssvl->disparity_depth_buffer_size);
+    async->depth_sequence = async->slot_sequences[slot];
+    async->slot_states[slot] = SSVL_SLOT_FREE;
+    pthread_cond_broadcast(&async->finished_cond);
+}
+
+
+// Async: processing thread, sleeps until frames are queued and processes them oldest first
+SSVL_FUNC void *ssvl_async_thread(void *arg){
+    ssvl_async_t *async = (ssvl_async_t*)arg;
+
+    pthread_mutex_lock(&async->mutex);
+
+    while(true){
+        while(async->stop == false && ssvl_async_oldest_slot(async, SSVL_SLOT_QUEUED) == async->slot_count){
+            pthread_cond_wait(&async->queued_cond, &async->mutex);
+        }
+
+        if(async->stop){
+            break;
+        }
+
+        ssvl_async_process_oldest(async);
+    }
+
+    pthread_mutex_unlock(&async->mutex);
+    return NULL;
+}
+
 
-        // https://en.wikipedia.org/wiki/Grayscale#:~:text=Ylinear%2C-,which%20is%20given%20by,-%5B6%5D
-        // 0.0 ~ 1.0
-        float luminance = 0.2126*r_normal + 0.7152*g_normal + 0.07122*b_normal;
+// Async: picks the slot the frame `ssvl_feed` is starting goes into, a free one or, when every
+// slot is taken, the oldest queued one (`SSVL_ASYNC_DROP_OLDEST`) or whichever is freed first
+// (`SSVL_ASYNC_BLOCK`)
+SSVL_FUNC void ssvl_async_start_frame(ssvl_t *ssvl){
+    ssvl_async_t *async = (ssvl_async_t*)ssvl->async;
 
-        // Put the linear value back into the buffer for
-        // disparity pixel block comparisons as a int
-        // with 16-bits for resolution
-        buffer[i] = (uint16_t)(luminance * (float)UINT16_MAX);
+    pthread_mutex_lock(&async->mutex);
+
+    uint8_t slot = ssvl_async_oldest_slot(async, SSVL_SLOT_FREE);
+
+    if(slot == async->slot_count && async->policy == SSVL_ASYNC_DROP_OLDEST){
+        slot = ssvl_async_oldest_slot(async, SSVL_SLOT_QUEUED);
+        if(slot != async->slot_count) async->dropped_frames++;
+    }
+
+    while(slot == async->slot_count){
+        pthread_cond_wait(&async->finished_cond, &async->mutex);
+        slot = ssvl_async_oldest_slot(async, SSVL_SLOT_FREE);
     }
+
+    async->slot_states[slot] = SSVL_SLOT_FILLING;
+    async->filling_slot = slot;
+    pthread_mutex_unlock(&async->mutex);
+
+    ssvl->async_feed_buffers[SSVL_LEFT_CAMERA] = async->slot_buffers + (uint32_t)slot*2*ssvl->pixel_count;
+    ssvl->async_feed_buffers[SSVL_RIGHT_CAMERA] = ssvl->async_feed_buffers[SSVL_LEFT_CAMERA] + ssvl->pixel_count;
 }
 
 
-SSVL_FUNC uint16_t ssvl_disparity_search(ssvl_t *ssvl, uint16_t left_cell_x, uint16_t left_cell_y){
-    // Starting from the same location in the right eye as the left eye,
-    // move window from right to left by a single pixel position amount
-    // starting at position from left eye
-    const int32_t starting_x = left_cell_x * ssvl->search_window_dimensions;
-    const uint16_t starting_y = left_cell_y * ssvl->search_window_dimensions;
+// Async: queues the slot `ssvl_feed` just filled for the processing thread, starting it the
+// first time. If it can't be started the frame is processed here instead
+SSVL_FUNC void ssvl_async_queue_frame(ssvl_t *ssvl){
+    ssvl_async_t *async = (ssvl_async_t*)ssvl->async;
 
-    int32_t most_similar_x = starting_x;
-    const uint16_t most_similar_y = starting_y;
-    uint32_t smallest_difference = UINT32_MAX;
+    pthread_mutex_lock(&async->mutex);
 
-    for(int32_t right_x=starting_x; right_x>=0 && right_x<=starting_x; right_x--){
-        uint32_t current_difference = ssvl->aggregate_pixel_comparer(ssvl,
-                                                        ssvl->frame_buffers[SSVL_LEFT_CAMERA],
-                                                        ssvl->frame_buffers[SSVL_RIGHT_CAMERA],
-                                                        starting_x,
-                                                        starting_y,
-                                                        right_x,
-                                                        starting_y,
-                                                        ssvl->search_window_dimensions);
-        
-        if(current_difference < smallest_difference){
-            smallest_difference = current_difference;
-            most_similar_x = right_x;
-        }
+    async->fed_sequence++;
+    async->slot_sequences[async->filling_slot] = async->fed_sequence;
+    async->slot_fed_bytes[async->filling_slot] = ssvl->stats_fed_bytes;
+    async->slot_states[async->filling_slot] = SSVL_SLOT_QUEUED;
+
+    if(async->thread_started == false && pthread_create(&async->thread, NULL, ssvl_async_thread, async) == 0){
+        async->thread_started = true;
     }
 
-    // Now that we have the block X with the smallest difference to the one
-    // in the left eye, calculate difference in X (disparity)
-    uint16_t disparity = abs(starting_x - most_similar_x);
+    if(async->thread_started){
+        pthread_cond_signal(&async->queued_cond);
+    }else{
+        ssvl_async_process_oldest(async);
+    }
 
-    return disparity;
+    pthread_mutex_unlock(&async->mutex);
+
+    ssvl->async_feed_buffers[SSVL_LEFT_CAMERA] = NULL;
+    ssvl->async_feed_buffers[SSVL_RIGHT_CAMERA] = NULL;
+    ssvl->stats_fed_bytes = 0;
 }
 
+#endif  // SSVL_PTHREADS
 
-SSVL_FUNC void ssvl_calculate_depth(ssvl_t *ssvl){
-    for(int32_t y=0; y<ssvl->depth_height; y++){
-        for(int32_t x=0; x<ssvl->depth_width; x++){
 
-            // Get the disparity and assign max depth if disparity close to zero
-            float disparity = ssvl->disparity_depth_buffer[y*ssvl->depth_width + x];
-            if(disparity >= 1.0f && disparity < ssvl->width){
-                // Depth = focal_length_pixels * base_line_mm / disparity_pixels
-                ssvl->disparity_depth_buffer[y*ssvl->depth_width + x] = (ssvl->focal_length_pixels * ssvl->baseline_mm / disparity);
-            }else{
-                ssvl->disparity_depth_buffer[y*ssvl->depth_width + x] = ssvl->max_depth_mm;
-            }
+// Converts a chunk of `input_format` bytes fed for `side` straight into grayscale at its
+// place in the frame buffer (`byte_offset` bytes into the frame) so every pixel is read and
+// written once. A 2 byte pixel split between two chunks is finished once its second byte
+// arrives. Bayer rows are only staged, see `ssvl_feed_rows`. When streaming, chunks must
+// not cross the end of a row
+SSVL_FUNC void ssvl_feed_convert(ssvl_t *ssvl, ssvl_camera_side side, const uint8_t *buffer, uint32_t buffer_length, uint32_t byte_offset){
+    if(buffer_length == 0){
+        return;
+    }
 
-        }
+    if(ssvl->input_format >= SSVL_FORMAT_BAYER_RGGB8){
+        const uint32_t y = byte_offset / ssvl->width;
+        memcpy(ssvl->feed_staging + (side*2 + (y & 1))*ssvl->width + (byte_offset - y*ssvl->width), buffer, buffer_length);
+        return;
+    }
+
+    if(ssvl->input_bytes_per_pixel == 1){
+        ssvl_convert_to_grayscale(ssvl, ssvl_feed_buffer_pixel(ssvl, side, byte_offset), buffer, buffer_length);
+        return;
+    }
+
+    if(byte_offset % 2 != 0){
+        const uint8_t split_pixel[2] = {ssvl->feed_split_bytes[side], buffer[0]};
+        ssvl_convert_to_grayscale(ssvl, ssvl_feed_buffer_pixel(ssvl, side, byte_offset/2), split_pixel, 1);
+
+        buffer++;
+        buffer_length--;
+        byte_offset++;
+    }
+
+    if(buffer_length >= 2){
+        ssvl_convert_to_grayscale(ssvl, ssvl_feed_buffer_pixel(ssvl, side, byte_offset/2), buffer, buffer_length/2);
+    }
+
+    if(buffer_length % 2 != 0){
+        ssvl->feed_split_bytes[side] = buffer[buffer_length-1];
     }
 }
 
 
-// Left and right camera buffers are full, process them
-SSVL_FUNC bool ssvl_process(ssvl_t *ssvl){
-    // We have both frames from both cameras, need to go through
-    // and calculate disparity for each pixel block and then the
-    // depth for each pixel block
+// `ssvl_feed` for streaming and Bayer: converts the chunk a row at a time. Bayer row pairs
+// are converted once their second row is complete and, when streaming, bands are processed
+// as soon as both eyes have them so their rows in the ring can be reused
+SSVL_FUNC bool ssvl_feed_rows(ssvl_t *ssvl, ssvl_camera_side side, const uint8_t *buffer, uint32_t buffer_length){
+    const uint32_t row_size = ssvl->width * ssvl->input_bytes_per_pixel;
 
-    // Reset these for next incoming frames after processing
-    ssvl->frame_buffers_amounts[SSVL_LEFT_CAMERA] = 0;
-    ssvl->frame_buffers_amounts[SSVL_RIGHT_CAMERA] = 0;
+    while(buffer_length > 0){
+        const uint32_t byte_offset = ssvl->frame_buffers_amounts[side];
+        const uint32_t y = byte_offset / row_size;
 
-    // Before relating blocks between left and right eyes, 
-    // change the 3 component pixels to single component
-    // linear values of intensity, grayscale
-    ssvl_convert_rgb565_to_grayscale(ssvl->frame_buffers[SSVL_LEFT_CAMERA], ssvl->pixel_count);
-    ssvl_convert_rgb565_to_grayscale(ssvl->frame_buffers[SSVL_RIGHT_CAMERA], ssvl->pixel_count);
+        // This eye is so far ahead its row would overwrite a band that hasn't been searched yet
+        // (or rows above it census still reads), or when rectifying a row that hasn't been
+        // rectified from yet
+        bool overrun = false;
 
-    if(ssvl->on_grayscale_cb != NULL) ssvl->on_grayscale_cb(ssvl->grayscale_opaque_ptr, SSVL_LEFT_CAMERA, ssvl->frame_buffers[SSVL_LEFT_CAMERA], ssvl->width, ssvl->height);
-    if(ssvl->on_grayscale_cb != NULL) ssvl->on_grayscale_cb(ssvl->grayscale_opaque_ptr, SSVL_RIGHT_CAMERA, ssvl->frame_buffers[SSVL_RIGHT_CAMERA], ssvl->width, ssvl->height);
+        if(ssvl->streaming && ssvl->rectify){
+            const uint16_t next_y = (ssvl->rectify_rows_done < ssvl->height) ? ssvl->rectify_rows_done : ssvl->height - 1;
+            overrun = y >= (uint32_t)ssvl->rectify_source_starts[next_y] + ssvl->rectify_source_rows;
+        }else if(ssvl->streaming){
+            overrun = y >= ssvl_stream_oldest_row(ssvl) + ssvl->frame_buffer_rows;
+        }
 
-    for(int32_t left_cell_y=0; left_cell_y<ssvl->depth_height; left_cell_y++){
-        for(int32_t left_cell_x=0; left_cell_x<ssvl->depth_width; left_cell_x++){
+        if(overrun){
+            ssvl->frame_buffers_amounts[SSVL_LEFT_CAMERA] = 0;
+            ssvl->frame_buffers_amounts[SSVL_RIGHT_CAMERA] = 0;
+            ssvl->stream_next_band = 0;
+            ssvl->rectify_rows_done = 0;
+            ssvl->stats_fed_bytes = 0;
+            ssvl_set_status_code(ssvl, SSVL_STATUS_STREAM_OVERRUN);
+            return false;
+        }
 
-            uint16_t disparity = ssvl_disparity_search(ssvl, left_cell_x, left_cell_y);
-            ssvl->disparity_depth_buffer[left_cell_y*ssvl->depth_width + left_cell_x] = (float)disparity;
+        const uint32_t row_remaining = (y + 1) * row_size - byte_offset;
+        const uint32_t chunk_length = (buffer_length < row_remaining) ? buffer_length : row_remaining;
+
+        ssvl_feed_convert(ssvl, side, buffer, chunk_length, byte_offset);
+        ssvl->frame_buffers_amounts[side] += chunk_length;
+
+        buffer += chunk_length;
+        buffer_length -= chunk_length;
+
+        if(chunk_length != row_remaining){
+            continue;
         }
-    }
 
-    if(ssvl->on_disparity_cb != NULL) ssvl->on_disparity_cb(ssvl->disparity_opaque_ptr, ssvl->disparity_depth_buffer, ssvl->depth_width, ssvl->depth_height);
+        if(ssvl->input_format >= SSVL_FORMAT_BAYER_RGGB8 && y % 2 != 0){
+            const uint8_t *staged_rows = ssvl->feed_staging + side*2*ssvl->width;
 
-    ssvl_calculate_depth(ssvl);
+            ssvl_convert_bayer_to_grayscale(ssvl, ssvl_feed_buffer_pixel(ssvl, side, (y-1)*ssvl->width), ssvl_feed_buffer_pixel(ssvl, side, y*ssvl->width),
+                                            staged_rows, staged_rows + ssvl->width, ssvl->width);
+        }
 
-    if(ssvl->on_depth_cb != NULL) ssvl->on_depth_cb(ssvl->depth_opaque_ptr, ssvl->disparity_depth_buffer, ssvl->depth_width, ssvl->depth_height, ssvl->max_depth_mm);
+        if(ssvl->streaming){
+            ssvl_stream_process_bands(ssvl);
+        }
+    }
 
     return true;
 }
 
 
-// Copies the incoming `buffer` to internal library frame buffer.
-// Returns `true` when:
+// Converts the incoming `buffer` to grayscale into the internal library frame buffer,
+// continuing where the previous chunk for `side` left off. Processes the frames once
+// both are complete. Returns `true` when:
 //  * Fed a buffer chunk but still haven't been provided enough buffers yet to complete the frame
 //  * Fed a buffer chunk but reached the end and ended up with exactly enough buffers to complete the frame
 // Returns `false` when:
 //  * Fed a buffer chunk but the addition of this buffer resulted in too much data needed to complete the frame
 //    (User is expected to crop their buffers or incoming `buffer_len`s so as to understand the information they
 //     are putting into the library)
+//  * Streaming and one eye got too far ahead of the other (`SSVL_STATUS_STREAM_OVERRUN`, the frame is dropped)
 SSVL_FUNC bool ssvl_feed(ssvl_t *ssvl, ssvl_camera_side side, const uint8_t *buffer, uint32_t buffer_length){
-    // Add the additional buffer amount to the count/amount
-    ssvl->frame_buffers_amounts[side] += buffer_length;
+    // The previous frame's buffers are being overwritten, unless async where a new
+    // frame gets a slot of its own (everything else belongs to the processing thread)
+    #if defined(SSVL_PTHREADS)
+        if(ssvl->async != NULL && ssvl->async_feed_buffers[SSVL_LEFT_CAMERA] == NULL){
+            ssvl_async_start_frame(ssvl);
+        }
+    #endif
+
+    if(ssvl->async == NULL){
+        ssvl->frame_queryable = false;
+    }
 
     // Check, in bytes, for buffer overflow, reset and return error if true
-    if(ssvl->frame_buffers_amounts[side] > ssvl->frame_buffer_size){
+    if(ssvl->frame_buffers_amounts[side] + buffer_length > ssvl->frame_buffer_size){
         ssvl->frame_buffers_amounts[side] = 0;
+
+        // A stream can't restart one eye on its own, drop the frame
+        if(ssvl->streaming){
+            ssvl->frame_buffers_amounts[SSVL_LEFT_CAMERA] = 0;
+            ssvl->frame_buffers_amounts[SSVL_RIGHT_CAMERA] = 0;
+            ssvl->stream_next_band = 0;
+            ssvl->rectify_rows_done = 0;
+            ssvl->stats_fed_bytes = 0;
+        }
+
         ssvl_set_status_code(ssvl, SSVL_STATUS_FEED_OVERFLOW);
         return false;
     }
 
-    // Do the copy to the internal frame buffer
-    memcpy(ssvl->frame_buffers[side], buffer, buffer_length);
-    
+    #if defined(SSVL_STATS)
+        ssvl->stats_fed_bytes += buffer_length;
+    #endif
+
+    if(ssvl->streaming){
+        // Fed rows are rectified from their ring, `ssvl_process_frames` may have pointed elsewhere
+        if(ssvl->rectify && ssvl->rectify_rows_gray == false){
+            ssvl_rectify_point_rows(ssvl, SSVL_LEFT_CAMERA, (const uint8_t*)ssvl->rectify_sources[SSVL_LEFT_CAMERA], ssvl->width * sizeof(ssvl_gray_t), ssvl->rectify_source_rows, true);
+            ssvl_rectify_point_rows(ssvl, SSVL_RIGHT_CAMERA, (const uint8_t*)ssvl->rectify_sources[SSVL_RIGHT_CAMERA], ssvl->width * sizeof(ssvl_gray_t), ssvl->rectify_source_rows, true);
+        }
+
+        return ssvl_feed_rows(ssvl, side, buffer, buffer_length);
+    }
+
+    if(ssvl->input_format >= SSVL_FORMAT_BAYER_RGGB8){
+        ssvl_feed_rows(ssvl, side, buffer, buffer_length);
+    }else{
+        // Add the additional buffer amount to the count/amount
+        const uint32_t byte_offset = ssvl->frame_buffers_amounts[side];
+        ssvl->frame_buffers_amounts[side] += buffer_length;
+
+        // Copy to the internal frame buffer, converting to grayscale on the way
+        ssvl_feed_convert(ssvl, side, buffer, buffer_length, byte_offset);
+    }
+
     // Process frames if both buffers are full
     if(ssvl->frame_buffers_amounts[SSVL_LEFT_CAMERA] == ssvl->frame_buffer_size &&
        ssvl->frame_buffers_amounts[SSVL_RIGHT_CAMERA] == ssvl->frame_buffer_size){
@@ -467,6 +5946,26 @@ SSVL_FUNC bool ssvl_feed(ssvl_t *ssvl, ssvl_camera_side side, const uint8_t *buf
             SSVL_PRINTF("PROCESSING\n");
         #endif
 
+        #if defined(SSVL_PTHREADS)
+            if(ssvl->async != NULL){
+                ssvl->frame_buffers_amounts[SSVL_LEFT_CAMERA] = 0;
+                ssvl->frame_buffers_amounts[SSVL_RIGHT_CAMERA] = 0;
+
+                ssvl_async_queue_frame(ssvl);
+                return true;
+            }
+        #endif
+
+        ssvl->frames_grayscale = true;
+
+        if(ssvl->rectify){
+            ssvl->source_frames[SSVL_LEFT_CAMERA] = (const uint8_t*)ssvl->rectify_sources[SSVL_LEFT_CAMERA];
+            ssvl->source_frames[SSVL_RIGHT_CAMERA] = (const uint8_t*)ssvl->rectify_sources[SSVL_RIGHT_CAMERA];
+        }
+
+        ssvl->stats_queued_fed_bytes = ssvl->stats_fed_bytes;
+        ssvl->stats_fed_bytes = 0;
+
         return ssvl_process(ssvl);
     }
 
@@ -474,9 +5973,435 @@ SSVL_FUNC bool ssvl_feed(ssvl_t *ssvl, ssvl_camera_side side, const uint8_t *buf
 }
 
 
+// Processes a pair of `input_format` frames straight from your memory instead of copying them in
+// with `ssvl_feed`. The frames are only read (once, while converting them to grayscale into
+// `frame_buffers`) and never modified. `stride_bytes` is the distance between the starts of
+// consecutive rows (0 for tightly packed rows) so padded or aligned camera buffers can be used
+// as they are. If `roi` is not NULL, only that rectangle of the frames is used, it must be
+// `cameras_width` by `cameras_height`. When streaming, bands are processed one after another
+// as if fed. Any partially fed frames are dropped
+//
+// Returns `false` and sets `SSVL_STATUS_INVALID_ARGUMENT` if the stride or crop don't fit
+// (Bayer crops must start on an even row and column to keep the color pattern), or
+// `SSVL_STATUS_INVALID_CONFIG` when async (frames can only be fed)
+SSVL_FUNC bool ssvl_process_frames(ssvl_t *ssvl, const uint8_t *left_frame, const uint8_t *right_frame, uint32_t stride_bytes, const ssvl_rect_t *roi){
+    const uint32_t row_size = ssvl->width * ssvl->input_bytes_per_pixel;
+    const uint32_t side_task_count = ssvl_grayscale_side_task_count(ssvl);
+    uint32_t crop_x_bytes = 0;
+    uint32_t crop_offset = 0;
+
+    if(ssvl->async != NULL){
+        ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_CONFIG);
+        return false;
+    }
+
+    if(stride_bytes == 0){
+        stride_bytes = row_size;
+    }
+
+    if(roi != NULL){
+        const bool bayer_misaligned = ssvl->input_format >= SSVL_FORMAT_BAYER_RGGB8 && (roi->x % 2 != 0 || roi->y % 2 != 0);
+
+        if(roi->width != ssvl->width || roi->height != ssvl->height || bayer_misaligned){
+            ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_ARGUMENT);
+            return false;
+        }
+
+        crop_x_bytes = roi->x * ssvl->input_bytes_per_pixel;
+        crop_offset = roi->y*stride_bytes + crop_x_bytes;
+    }
+
+    if(stride_bytes < row_size + crop_x_bytes){
+        ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_ARGUMENT);
+        return false;
+    }
+
+    ssvl->frame_queryable = false;
+    ssvl->stats_fed_bytes = 0;
+    ssvl->source_frames[SSVL_LEFT_CAMERA] = left_frame + crop_offset;
+    ssvl->source_frames[SSVL_RIGHT_CAMERA] = right_frame + crop_offset;
+    ssvl->source_stride = stride_bytes;
+
+    if(ssvl->rectify){
+        ssvl_rectify_point_rows(ssvl, SSVL_LEFT_CAMERA, ssvl->source_frames[SSVL_LEFT_CAMERA], stride_bytes, ssvl->height, false);
+        ssvl_rectify_point_rows(ssvl, SSVL_RIGHT_CAMERA, ssvl->source_frames[SSVL_RIGHT_CAMERA], stride_bytes, ssvl->height, false);
+    }
+
+    if(ssvl->streaming){
+        ssvl->stream_next_band = 0;
+        ssvl->rectify_rows_done = 0;
+
+        // Every source row is there already, rows are rectified as the ring frees up
+        if(ssvl->rectify){
+            ssvl->frame_buffers_amounts[SSVL_LEFT_CAMERA] = ssvl->frame_buffer_size;
+            ssvl->frame_buffers_amounts[SSVL_RIGHT_CAMERA] = ssvl->frame_buffer_size;
+
+            ssvl_stream_process_bands(ssvl);
+            return true;
+        }
+
+        for(uint32_t task=0; task<side_task_count; task++){
+            ssvl_grayscale_task(ssvl, task, 0);
+            ssvl_grayscale_task(ssvl, side_task_count + task, 0);
+
+            ssvl->frame_buffers_amounts[SSVL_LEFT_CAMERA] = (task + 1) * ssvl->grayscale_task_rows * row_size;
+            ssvl->frame_buffers_amounts[SSVL_RIGHT_CAMERA] = ssvl->frame_buffers_amounts[SSVL_LEFT_CAMERA];
+
+            ssvl_stream_process_bands(ssvl);
+        }
+
+        return true;
+    }
+
+    ssvl->frame_sequence++;
+    ssvl_stats_start_frame(ssvl);
+    ssvl_mask_start_frame(ssvl);
+
+    ssvl_stats_stage_begin(ssvl, SSVL_STAGE_GRAYSCALE);
+    ssvl_parallel_for(ssvl, 2*side_task_count, ssvl_grayscale_task, ssvl);
+    ssvl_stats_stage_end(ssvl, SSVL_STAGE_GRAYSCALE);
+    ssvl->frames_grayscale = true;
+    ssvl->frames_pyramid = true;
+
+    return ssvl_process(ssvl);
+}
+
+
+// Restricts the next frames to the depth cells where `mask` (a byte per cell, rows of `depth_width`
+// cells one after another) isn't 0, NULL computes every cell again. The mask is copied. Cells left
+// out are `SSVL_CELL_SKIPPED` in `disparity_depth_buffer` and can still be asked for with
+// `ssvl_query_depth`. Only the pixel
+// rows the masked cells read are converted to grayscale, census descriptors and pyramid levels,
+// so `on_grayscale_cb` frames have rows that weren't. `ssvl_feed` still converts every row while
+// copying, and so do streams. Returns `false` and sets `SSVL_STATUS_INVALID_CONFIG` with `sgm`
+// (its paths go through every cell)
+SSVL_FUNC bool ssvl_set_cell_mask(ssvl_t *ssvl, const uint8_t *mask){
+    if(ssvl->sgm != SSVL_SGM_OFF){
+        ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_CONFIG);
+        return false;
+    }
+
+    if(mask == NULL){
+        ssvl->masked = false;
+        return true;
+    }
+
+    memcpy(ssvl->cell_mask, mask, ssvl->depth_cell_count);
+    ssvl->masked = true;
+
+    return true;
+}
+
+
+// Cell (column or row) that pixel column or row `p` belongs to: the last one starting at or before
+// it, so each pixel has one cell even when windows overlap (`cell_count` is `depth_width` or `depth_height`)
+SSVL_FUNC uint16_t ssvl_pixel_cell(ssvl_t *ssvl, uint16_t p, uint16_t cell_count){
+    const uint16_t cell = p / ssvl->cell_stride;
+    return (cell < cell_count) ? cell : (uint16_t)(cell_count - 1);
+}
+
+
+// First cell (column or row) whose window reaches pixel column or row `p`, the last cell for the
+// pixels past every window
+SSVL_FUNC uint16_t ssvl_first_cell_over(ssvl_t *ssvl, uint16_t p, uint16_t cell_count){
+    const uint16_t cell = (p >= ssvl->search_window_dimensions) ? (uint16_t)((p - ssvl->search_window_dimensions) / ssvl->cell_stride + 1) : 0;
+    return (cell < cell_count) ? cell : (uint16_t)(cell_count - 1);
+}
+
+
+// `ssvl_set_cell_mask` with the cells overlapping any of `roi_count` rectangles of pixels, none
+// (0) computes no cell until `ssvl_query_depth` asks for it. Returns `false` and sets
+// `SSVL_STATUS_INVALID_ARGUMENT` if a rectangle is empty or not inside the frames
+SSVL_FUNC bool ssvl_set_rois(ssvl_t *ssvl, const ssvl_rect_t *rois, uint16_t roi_count){
+    if(ssvl->sgm != SSVL_SGM_OFF){
+        ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_CONFIG);
+        return false;
+    }
+
+    for(uint16_t i=0; i<roi_count; i++){
+        if(rois[i].width == 0 || rois[i].height == 0 || rois[i].x + rois[i].width > ssvl->width || rois[i].y + rois[i].height > ssvl->height){
+            ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_ARGUMENT);
+            return false;
+        }
+    }
+
+    memset(ssvl->cell_mask, 0, ssvl->depth_cell_count);
+
+    for(uint16_t i=0; i<roi_count; i++){
+        const uint16_t first_cell_x = ssvl_first_cell_over(ssvl, rois[i].x, ssvl->depth_width);
+        const uint16_t last_cell_x = ssvl_pixel_cell(ssvl, rois[i].x + rois[i].width - 1, ssvl->depth_width);
+        const uint16_t first_cell_y = ssvl_first_cell_over(ssvl, rois[i].y, ssvl->depth_height);
+        const uint16_t last_cell_y = ssvl_pixel_cell(ssvl, rois[i].y + rois[i].height - 1, ssvl->depth_height);
+
+        for(uint16_t cell_y=first_cell_y; cell_y<=last_cell_y; cell_y++){
+            memset(ssvl->cell_mask + cell_y*ssvl->depth_width + first_cell_x, 1, last_cell_x - first_cell_x + 1);
+        }
+    }
+
+    ssvl->masked = true;
+
+    return true;
+}
+
+
+// Depth of a computed cell as a float, `SSVL_OUTPUT_UINT16` marks are mapped back to theirs
+SSVL_FUNC float ssvl_cell_depth(ssvl_t *ssvl, uint32_t cell_index){
+    if(ssvl->output_format == SSVL_OUTPUT_FLOAT){
+        return ssvl->disparity_depth_buffer[cell_index];
+    }
+
+    const uint16_t depth_mm = ssvl->depth_mm_buffer[cell_index];
+
+    if(depth_mm == SSVL_CELL_U16_REJECTED){
+        return SSVL_CELL_REJECTED;
+    }else if(depth_mm == SSVL_CELL_U16_SKIPPED){
+        return SSVL_CELL_SKIPPED;
+    }
+
+    return (float)depth_mm;
+}
+
+
+// Depth (mm) of the cell holding pixel `x`, `y` (see `ssvl_pixel_cell`) in the last frame `ssvl_process` finished. Cells the
+// mask left out are computed now (converting the rows they read first, with the frame's disparity
+// range) and kept for later queries of the same frame. Frames given to `ssvl_process_frames` must
+// still be readable, and directly filled frame buffers unchanged, until the last query. Returns
+// `SSVL_CELL_SKIPPED` and sets:
+//  * `SSVL_STATUS_INVALID_ARGUMENT` if the pixel is outside the frames
+//  * `SSVL_STATUS_INVALID_CONFIG` if there's no finished frame (streaming, feeding the next one or
+//    async outside the callbacks, the slot's frames are reused once they return)
+SSVL_FUNC float ssvl_query_depth(ssvl_t *ssvl, uint16_t x, uint16_t y){
+    if(x >= ssvl->width || y >= ssvl->height){
+        ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_ARGUMENT);
+        return SSVL_CELL_SKIPPED;
+    }
+
+    if(ssvl->frame_queryable == false){
+        ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_CONFIG);
+        return SSVL_CELL_SKIPPED;
+    }
+
+    const uint16_t left_cell_x = ssvl_pixel_cell(ssvl, x, ssvl->depth_width);
+    const uint16_t left_cell_y = ssvl_pixel_cell(ssvl, y, ssvl->depth_height);
+    const uint32_t cell_index = left_cell_y*ssvl->depth_width + left_cell_x;
+
+    if(ssvl->frame_masked == false || ssvl->cell_computed[cell_index] != 0){
+        return ssvl_cell_depth(ssvl, cell_index);
+    }
+
+    // Rows the frame skipped, fed frames are already grayscale and only lack pyramid levels
+    // (unless they still have to be rectified)
+    const uint32_t side_task_count = ssvl_grayscale_side_task_count(ssvl);
+    ssvl_want_cell_rows(ssvl, left_cell_y);
+
+    for(uint32_t task=0; task<2*side_task_count; task++){
+        if(ssvl->grayscale_task_states[task] != SSVL_ROWS_WANTED) continue;
+
+        if(ssvl->frame_fed == false || ssvl->rectify){
+            ssvl_grayscale_task(ssvl, task, 0);
+        }else if(ssvl->pyramid_levels > 1){
+            ssvl_pyramid_task(ssvl, task, 0);
+        }
+
+        ssvl->grayscale_task_states[task] = SSVL_ROWS_READY;
+    }
+
+    if(ssvl->census){
+        for(uint32_t band=0; band<2*ssvl->census_band_count; band++){
+            if(ssvl->census_band_states[band] == SSVL_ROWS_WANTED) ssvl_census_task(ssvl, band, 0);
+        }
+    }
+
+    // `ssvl_process` may already have narrowed the active range for the next frame
+    ssvl_forget_shared_rows(ssvl);
+    const uint16_t active_min_disparity = ssvl->active_min_disparity;
+    const uint16_t active_max_disparity = ssvl->active_max_disparity;
+    ssvl->active_min_disparity = ssvl->frame_min_disparity;
+    ssvl->active_max_disparity = ssvl->frame_max_disparity;
+
+    if(ssvl->lr_check){
+        // The left-right check needs the costs of the whole row
+        ssvl_search_row(ssvl, &ssvl->worker_scratch[0], left_cell_y, NULL, ssvl->cell_computed + left_cell_y*ssvl->depth_width);
+        ssvl_calculate_depth_row(ssvl, left_cell_y);
+    }else{
+        ssvl_store_disparity(ssvl, cell_index, ssvl_cell_search(ssvl, &ssvl->worker_scratch[0], left_cell_x, left_cell_y));
+        ssvl_calculate_depth_cell(ssvl, cell_index);
+        ssvl->cell_computed[cell_index] = 1;
+    }
+
+    ssvl->active_min_disparity = active_min_disparity;
+    ssvl->active_max_disparity = active_max_disparity;
+
+    return ssvl_cell_depth(ssvl, cell_index);
+}
+
+
+// Async: copies the depths of the newest frame finished since the last call into `depth_buffer`
+// (`depth_width*depth_height` floats) and its sequence number into `sequence` (if not NULL).
+// Frames finished in between are skipped. If none has finished, waits for the frames being
+// processed or queued when `wait` is set, see `ssvl_poll_depth`/`ssvl_wait_depth`
+SSVL_FUNC bool ssvl_take_depth(ssvl_t *ssvl, float *depth_buffer, uint32_t depth_buffer_length, uint32_t *sequence, bool wait){
+    if(depth_buffer_length < ssvl->depth_cell_count){
+        ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_ARGUMENT);
+        return false;
+    }
+
+    #if defined(SSVL_PTHREADS)
+        if(ssvl->async != NULL){
+            ssvl_async_t *async = (ssvl_async_t*)ssvl->async;
+
+            pthread_mutex_lock(&async->mutex);
+
+            while(wait && async->depth_sequence == async->taken_sequence && ssvl_async_busy(async)){
+                pthread_cond_wait(&async->finished_cond, &async->mutex);
+            }
+
+            const bool taken = async->depth_sequence != async->taken_sequence;
+
+            if(taken){
+                memcpy(depth_buffer, async->depth_buffer, ssvl->disparity_depth_buffer_size);
+                if(sequence != NULL) *sequence = async->depth_sequence;
+                async->taken_sequence = async->depth_sequence;
+            }
+
+            pthread_mutex_unlock(&async->mutex);
+
+            return taken;
+        }
+    #else
+        (void)depth_buffer;
+        (void)sequence;
+        (void)wait;
+    #endif
+
+    ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_CONFIG);
+    return false;
+}
+
+
+// Async: copies out the newest finished frame's depths if there's one that hasn't been taken yet,
+// returns `false` otherwise without waiting. Sets `SSVL_STATUS_INVALID_CONFIG` if not async and
+// `SSVL_STATUS_INVALID_ARGUMENT` if `depth_buffer_length` is smaller than the depth buffer
+SSVL_FUNC bool ssvl_poll_depth(ssvl_t *ssvl, float *depth_buffer, uint32_t depth_buffer_length, uint32_t *sequence){
+    return ssvl_take_depth(ssvl, depth_buffer, depth_buffer_length, sequence, false);
+}
+
+
+// Async: same as `ssvl_poll_depth` but waits for the frames fed so far to finish if none has
+// since the last call. Returns `false` only if there are none left to wait for
+SSVL_FUNC bool ssvl_wait_depth(ssvl_t *ssvl, float *depth_buffer, uint32_t depth_buffer_length, uint32_t *sequence){
+    return ssvl_take_depth(ssvl, depth_buffer, depth_buffer_length, sequence, true);
+}
+
+
+// Async: waits until every queued frame has been processed (and its callbacks returned), after which
+// the instance can be used from this thread again until the next frame is complete. Does nothing
+// when not async
+SSVL_FUNC void ssvl_flush(ssvl_t *ssvl){
+    #if defined(SSVL_PTHREADS)
+        if(ssvl->async != NULL){
+            ssvl_async_t *async = (ssvl_async_t*)ssvl->async;
+
+            pthread_mutex_lock(&async->mutex);
+
+            while(ssvl_async_busy(async)){
+                pthread_cond_wait(&async->finished_cond, &async->mutex);
+            }
+
+            pthread_mutex_unlock(&async->mutex);
+        }
+    #else
+        (void)ssvl;
+    #endif
+}
+
+
 SSVL_FUNC float ssvl_get_max_depth_mm(ssvl_t *ssvl){
     return ssvl->max_depth_mm;
 }
 
 
+// `SSVL_OUTPUT_UINT16`: fixed point disparities of the last frame (`depth_width*depth_height`,
+// `disparity_fraction_bits` of fraction), NULL with `SSVL_OUTPUT_FLOAT`
+SSVL_FUNC const uint16_t *ssvl_get_disparity_u16_buffer(ssvl_t *ssvl){
+    return ssvl->disparity_u16_buffer;
+}
+
+
+// `SSVL_OUTPUT_UINT16`: depths (mm) of the last frame (`depth_width*depth_height`), NULL with
+// `SSVL_OUTPUT_FLOAT`
+SSVL_FUNC const uint16_t *ssvl_get_depth_mm_buffer(ssvl_t *ssvl){
+    return ssvl->depth_mm_buffer;
+}
+
+
+// Points of the last frame in the buffers of `point_buffers`, see `ssvl_config_t.point_cloud`
+// (`depth_cell_count` for `SSVL_POINT_CLOUD_DENSE`, 0 without points)
+SSVL_FUNC uint32_t ssvl_get_point_count(ssvl_t *ssvl){
+    return ssvl->point_count;
+}
+
+
+// Temporal: cells of the last frame (so far, while streaming one) that had no previous
+// disparity or whose band search cost was too high and searched the whole range instead
+// (see `ssvl_config_t.temporal`)
+SSVL_FUNC uint32_t ssvl_get_temporal_fallbacks(ssvl_t *ssvl){
+    uint32_t fallbacks = 0;
+
+    for(uint8_t worker_index=0; worker_index<ssvl->worker_count; worker_index++){
+        fallbacks += ssvl->worker_scratch[worker_index].temporal_fallbacks;
+    }
+
+    return fallbacks;
+}
+
+
+// Copies the stats of the frame being processed (from the callbacks) or the last one processed
+// into `stats`. When async, only call it from the callbacks, the processing thread writes them.
+// Returns `false` and sets `SSVL_STATUS_INVALID_CONFIG` (zeroing `stats`) unless built with `SSVL_STATS`
+SSVL_FUNC bool ssvl_get_stats(ssvl_t *ssvl, ssvl_stats_t *stats){
+    #if defined(SSVL_STATS)
+        memcpy(stats, &ssvl->stats, sizeof(ssvl_stats_t));
+
+        for(uint8_t worker_index=0; worker_index<ssvl->worker_count; worker_index++){
+            stats->comparer_calls += ssvl->worker_scratch[worker_index].comparer_calls;
+            stats->candidates += ssvl->worker_scratch[worker_index].candidates;
+        }
+
+        return true;
+    #else
+        memset(stats, 0, sizeof(ssvl_stats_t));
+        ssvl_set_status_code(ssvl, SSVL_STATUS_INVALID_CONFIG);
+        return false;
+    #endif
+}
+
+
+// Sequence number of the frame being processed (from the callbacks) or the last one processed,
+// counting frames from 1. Async frames are numbered as they're fed so dropped ones leave gaps
+SSVL_FUNC uint32_t ssvl_get_frame_sequence(ssvl_t *ssvl){
+    return ssvl->frame_sequence;
+}
+
+
+// Async: frames dropped so far by `SSVL_ASYNC_DROP_OLDEST` before they were processed
+SSVL_FUNC uint32_t ssvl_get_dropped_frames(ssvl_t *ssvl){
+    uint32_t dropped_frames = 0;
+
+    #if defined(SSVL_PTHREADS)
+        if(ssvl->async != NULL){
+            ssvl_async_t *async = (ssvl_async_t*)ssvl->async;
+
+            pthread_mutex_lock(&async->mutex);
+            dropped_frames = async->dropped_frames;
+            pthread_mutex_unlock(&async->mutex);
+        }
+    #else
+        (void)ssvl;
+    #endif
+
+    return dropped_frames;
+}
+
+
 #endif  // SSVL_H
\ No newline at end of file
@@ -0,0 +1,379 @@
+#ifndef SSVL_HPP
+#define SSVL_HPP
+
+// Optional C++ layer over ssvl.h, include this instead of it from C++ (it includes ssvl.h).
+// `ssvl::StereoMatcher` owns an instance and its buffers, everything it does is an inline
+// call to the C functions so it costs nothing over using them directly
+#include "ssvl.h"
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// `std::span` where there is one (C++20), otherwise `ssvl::span` is a minimal stand-in with the same use
+#if __cplusplus >= 202002L || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+    #include <span>
+    #define SSVL_HPP_STD_SPAN
+#endif
+
+
+namespace ssvl{
+
+// ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
+//                  SPANS
+// vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
+
+#if defined(SSVL_HPP_STD_SPAN)
+    template<class T>
+    using span = std::span<T>;
+#else
+    // Pointer and element count, made from both or anything with `data()` and `size()`
+    // (`std::vector`, `std::array`, ...) or an array
+    template<class T>
+    class span{
+    public:
+        span() : elements(nullptr), count(0){}
+        span(T *data, size_t size) : elements(data), count(size){}
+
+        template<size_t N>
+        span(T (&array)[N]) : elements(array), count(N){}
+
+        template<class Container, class = typename std::enable_if<std::is_convertible<decltype(std::declval<Container&>().data()), T*>::value>::type>
+        span(Container &container) : elements(container.data()), count(container.size()){}
+
+        T *data() const{ return elements; }
+        size_t size() const{ return count; }
+        bool empty() const{ return count == 0; }
+        T &operator[](size_t index) const{ return elements[index]; }
+        T *begin() const{ return elements; }
+        T *end() const{ return elements + count; }
+
+    private:
+        T *elements;
+        size_t count;
+    };
+#endif
+
+
+// ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
+//           SPECIALIZED COMPARERS
+// vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
+
+// Template versions of `SSVL_SPECIALIZE_WINDOW`: the batched comparers with `window_dimensions`
+// fixed at `WindowDimensions` (the argument is ignored), for any size without a macro per size
+template<uint8_t WindowDimensions>
+void sad_multi_comparer(ssvl_t *ssvl, ssvl_gray_t *original_cam_buffer, ssvl_gray_t *compare_cam_buffer,
+                        uint16_t original_window_x, uint16_t original_window_y,
+                        uint16_t compare_window_x, uint16_t compare_window_y,
+                        uint8_t window_dimensions, uint16_t candidate_count, uint32_t *sads){
+    (void)window_dimensions;
+    ssvl_sad_specialized_comparer(ssvl, original_cam_buffer, compare_cam_buffer, original_window_x, original_window_y,
+                                  compare_window_x, compare_window_y, WindowDimensions, candidate_count, sads);
+}
+
+
+template<uint8_t WindowDimensions>
+void census_multi_comparer(ssvl_t *ssvl, ssvl_gray_t *original_cam_buffer, ssvl_gray_t *compare_cam_buffer,
+                           uint16_t original_window_x, uint16_t original_window_y,
+                           uint16_t compare_window_x, uint16_t compare_window_y,
+                           uint8_t window_dimensions, uint16_t candidate_count, uint32_t *distances){
+    (void)window_dimensions;
+    ssvl_census_multi_comparer(ssvl, original_cam_buffer, compare_cam_buffer, original_window_x, original_window_y,
+                               compare_window_x, compare_window_y, WindowDimensions, candidate_count, distances);
+}
+
+
+// Uses the comparers above if `ssvl` was configured with `search_window_dimensions` equal to
+// `WindowDimensions` (call it after `ssvl_init`), returns false and keeps the current ones otherwise.
+// Falls back to the generic SAD comparer in builds where the specialization doesn't gain anything
+// (see `SSVL_SPECIALIZE_SAD`), census is always specialized
+template<uint8_t WindowDimensions>
+bool use_window_comparers(ssvl_t *ssvl){
+    if(ssvl->search_window_dimensions != WindowDimensions){
+        return false;
+    }
+
+    #if defined(SSVL_SPECIALIZE_SAD)
+        ssvl_set_multi_comparers(ssvl, sad_multi_comparer<WindowDimensions>, census_multi_comparer<WindowDimensions>);
+    #else
+        ssvl_set_multi_comparers(ssvl, ssvl_sad_multi_comparer, census_multi_comparer<WindowDimensions>);
+    #endif
+
+    return true;
+}
+
+
+// ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
+//              STEREO MATCHER
+// vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
+
+// Move-only owner of an `ssvl_t` and its buffers, destroyed with it. The instance lives on the heap
+// so moving the matcher doesn't move it from under the async thread or the callbacks.
+//
+// Errors are reported the same way as the C API: `false` returns and `status()`. A matcher whose
+// configuration couldn't be used is empty (`valid()` is false, `status()` says why) and must not be
+// used further. Anything not wrapped here is available through `get()` and the C functions
+class StereoMatcher{
+public:
+    // Empty, assign one that was constructed with a configuration
+    StereoMatcher() : instance(nullptr), init_status(SSVL_STATUS_OK){}
+
+    // See `ssvl_init_with_config`, `config.allocate` is ignored: the matcher always owns its buffers
+    explicit StereoMatcher(const ssvl_config_t &config) : instance(nullptr), init_status(SSVL_STATUS_OK){
+        ssvl_config_t owned_config = config;
+        owned_config.allocate = true;
+
+        ssvl_t *ssvl = new ssvl_t();
+
+        if(ssvl_init_with_config(ssvl, &owned_config)){
+            instance = ssvl;
+        }else{
+            init_status = ssvl_get_status_code(ssvl);
+            delete ssvl;
+        }
+    }
+
+    // See `ssvl_init` (default settings)
+    StereoMatcher(uint16_t cameras_width, uint16_t cameras_height, uint8_t search_window_dimensions, float baseline_mm, float fov_degrees)
+        : StereoMatcher(default_config(cameras_width, cameras_height, search_window_dimensions, baseline_mm, fov_degrees)){}
+
+    ~StereoMatcher(){
+        reset();
+    }
+
+    StereoMatcher(StereoMatcher &&other) noexcept : instance(other.instance), init_status(other.init_status){
+        for(int callback=0; callback<CALLBACK_COUNT; callback++){
+            callbacks[callback] = std::move(other.callbacks[callback]);
+        }
+
+        other.instance = nullptr;
+    }
+
+    StereoMatcher &operator=(StereoMatcher &&other) noexcept{
+        if(this != &other){
+            reset();
+
+            instance = other.instance;
+            init_status = other.init_status;
+
+            for(int callback=0; callback<CALLBACK_COUNT; callback++){
+                callbacks[callback] = std::move(other.callbacks[callback]);
+            }
+
+            other.instance = nullptr;
+        }
+
+        return *this;
+    }
+
+    StereoMatcher(const StereoMatcher&) = delete;
+    StereoMatcher &operator=(const StereoMatcher&) = delete;
+
+    bool valid() const{ return instance != nullptr; }
+    explicit operator bool() const{ return valid(); }
+
+    // Status of the last error, why construction failed for an empty matcher
+    ssvl_status_t status() const{ return (instance != nullptr) ? instance->status_code : init_status; }
+
+    // The instance for the rest of the C API
+    ssvl_t *get(){ return instance; }
+    const ssvl_t *get() const{ return instance; }
+
+    uint16_t depth_width() const{ return instance->depth_width; }
+    uint16_t depth_height() const{ return instance->depth_height; }
+    float max_depth_mm() const{ return instance->max_depth_mm; }
+    uint32_t frame_sequence() const{ return instance->frame_sequence; }
+
+    // See `ssvl_feed`
+    bool feed(ssvl_camera_side side, span<const uint8_t> buffer){
+        return ssvl_feed(instance, side, buffer.data(), (uint32_t)buffer.size());
+    }
+
+    // See `ssvl_process_frames`, the frames are read in place. Also returns `false` and sets
+    // `SSVL_STATUS_INVALID_ARGUMENT` if either frame is too short for the rows it would read
+    bool process_frames(span<const uint8_t> left_frame, span<const uint8_t> right_frame, uint32_t stride_bytes=0, const ssvl_rect_t *roi=nullptr){
+        const size_t row_size = (size_t)instance->width * instance->input_bytes_per_pixel;
+        const size_t stride = (stride_bytes == 0) ? row_size : stride_bytes;
+        const size_t first_row = (roi != nullptr) ? roi->y : 0;
+        const size_t first_byte = (roi != nullptr) ? (size_t)roi->x * instance->input_bytes_per_pixel : 0;
+        const size_t frame_size = (first_row + instance->height - 1) * stride + first_byte + row_size;
+
+        if(left_frame.size() < frame_size || right_frame.size() < frame_size){
+            ssvl_set_status_code(instance, SSVL_STATUS_INVALID_ARGUMENT);
+            return false;
+        }
+
+        return ssvl_process_frames(instance, left_frame.data(), right_frame.data(), stride_bytes, roi);
+    }
+
+    // See `ssvl_poll_depth`, `ssvl_wait_depth` and `ssvl_flush`
+    bool poll_depth(span<float> depth_buffer, uint32_t *sequence=nullptr){
+        return ssvl_poll_depth(instance, depth_buffer.data(), (uint32_t)depth_buffer.size(), sequence);
+    }
+
+    bool wait_depth(span<float> depth_buffer, uint32_t *sequence=nullptr){
+        return ssvl_wait_depth(instance, depth_buffer.data(), (uint32_t)depth_buffer.size(), sequence);
+    }
+
+    void flush(){
+        ssvl_flush(instance);
+    }
+
+    // Depths (or disparities until `on_depth`) of the last frame, empty with `SSVL_OUTPUT_UINT16`
+    span<const float> depths() const{
+        return output_span<const float>(instance->disparity_depth_buffer, instance->depth_cell_count);
+    }
+
+    // `SSVL_OUTPUT_UINT16` buffers of the last frame, empty with `SSVL_OUTPUT_FLOAT`
+    span<const uint16_t> disparities_u16() const{
+        return output_span<const uint16_t>(instance->disparity_u16_buffer, instance->depth_cell_count);
+    }
+
+    span<const uint16_t> depths_mm() const{
+        return output_span<const uint16_t>(instance->depth_mm_buffer, instance->depth_cell_count);
+    }
+
+    // Points of the last frame (see `ssvl_config_t.point_cloud`), empty without `point_cloud`
+    span<const float> points_x() const{ return output_span<const float>(instance->point_buffers[0], instance->point_count); }
+    span<const float> points_y() const{ return output_span<const float>(instance->point_buffers[1], instance->point_count); }
+    span<const float> points_z() const{ return output_span<const float>(instance->point_buffers[2], instance->point_count); }
+
+    // Callbacks take any callable, which is kept by the matcher. The C callback is a function
+    // instantiated for its type so the call to it can be inlined. `nullptr` removes one:
+    //  * on_grayscale(ssvl_camera_side side, span<const ssvl_gray_t> frame, uint16_t width, uint16_t height)
+    //  * on_disparity(span<const float> disparities, uint16_t depth_width, uint16_t depth_height)
+    //  * on_depth(span<const float> depths, uint16_t depth_width, uint16_t depth_height, float max_depth_mm)
+    //  * on_depth_row(span<const float> depth_row, uint16_t depth_row_index, float max_depth_mm)
+    //  * on_points(span<const float> x, span<const float> y, span<const float> z)
+    // With `SSVL_OUTPUT_UINT16` the disparity and depth spans are empty (see `disparities_u16`).
+    // A replaced callable is deleted once the new one is installed. When async, only replace or
+    // remove callbacks with no frame in flight (after `flush()`), the processing thread may be
+    // calling the old one
+    template<class Callback>
+    void on_grayscale(Callback &&callback){
+        kept_callback_t kept = keep(std::forward<Callback>(callback));
+        ssvl_set_on_grayscale_cb(instance, grayscale_trampoline<typename std::decay<Callback>::type>, kept.get());
+        callbacks[CALLBACK_GRAYSCALE].swap(kept);
+    }
+
+    template<class Callback>
+    void on_disparity(Callback &&callback){
+        kept_callback_t kept = keep(std::forward<Callback>(callback));
+        ssvl_set_on_disparity_cb(instance, disparity_trampoline<typename std::decay<Callback>::type>, kept.get());
+        callbacks[CALLBACK_DISPARITY].swap(kept);
+    }
+
+    template<class Callback>
+    void on_depth(Callback &&callback){
+        kept_callback_t kept = keep(std::forward<Callback>(callback));
+        ssvl_set_on_depth_cb(instance, depth_trampoline<typename std::decay<Callback>::type>, kept.get());
+        callbacks[CALLBACK_DEPTH].swap(kept);
+    }
+
+    template<class Callback>
+    void on_depth_row(Callback &&callback){
+        kept_callback_t kept = keep(std::forward<Callback>(callback));
+        ssvl_set_on_depth_row_cb(instance, depth_row_trampoline<typename std::decay<Callback>::type>, kept.get());
+        callbacks[CALLBACK_DEPTH_ROW].swap(kept);
+    }
+
+    template<class Callback>
+    void on_points(Callback &&callback){
+        kept_callback_t kept = keep(std::forward<Callback>(callback));
+        ssvl_set_on_points_cb(instance, points_trampoline<typename std::decay<Callback>::type>, kept.get());
+        callbacks[CALLBACK_POINTS].swap(kept);
+    }
+
+    void on_grayscale(std::nullptr_t){ ssvl_set_on_grayscale_cb(instance, nullptr, nullptr); callbacks[CALLBACK_GRAYSCALE].reset(); }
+    void on_disparity(std::nullptr_t){ ssvl_set_on_disparity_cb(instance, nullptr, nullptr); callbacks[CALLBACK_DISPARITY].reset(); }
+    void on_depth(std::nullptr_t){ ssvl_set_on_depth_cb(instance, nullptr, nullptr); callbacks[CALLBACK_DEPTH].reset(); }
+    void on_depth_row(std::nullptr_t){ ssvl_set_on_depth_row_cb(instance, nullptr, nullptr); callbacks[CALLBACK_DEPTH_ROW].reset(); }
+    void on_points(std::nullptr_t){ ssvl_set_on_points_cb(instance, nullptr, nullptr); callbacks[CALLBACK_POINTS].reset(); }
+
+    // See `ssvl::use_window_comparers`
+    template<uint8_t WindowDimensions>
+    bool use_window_comparers(){
+        return ssvl::use_window_comparers<WindowDimensions>(instance);
+    }
+
+private:
+    enum{CALLBACK_GRAYSCALE=0, CALLBACK_DISPARITY=1, CALLBACK_DEPTH=2, CALLBACK_DEPTH_ROW=3, CALLBACK_POINTS=4, CALLBACK_COUNT=5};
+
+    // A kept callable and the function that deletes it
+    typedef std::unique_ptr<void, void(*)(void*)> kept_callback_t;
+
+    ssvl_t *instance;
+    ssvl_status_t init_status;
+    kept_callback_t callbacks[CALLBACK_COUNT] = {kept_callback_t(nullptr, nullptr), kept_callback_t(nullptr, nullptr),
+                                                 kept_callback_t(nullptr, nullptr), kept_callback_t(nullptr, nullptr),
+                                                 kept_callback_t(nullptr, nullptr)};
+
+    static ssvl_config_t default_config(uint16_t cameras_width, uint16_t cameras_height, uint8_t search_window_dimensions, float baseline_mm, float fov_degrees){
+        ssvl_config_t config;
+        ssvl_config_init(&config, cameras_width, cameras_height, search_window_dimensions, baseline_mm, fov_degrees);
+        return config;
+    }
+
+    template<class T, class Buffer>
+    static span<T> output_span(Buffer *buffer, uint32_t cell_count){
+        return (buffer != nullptr) ? span<T>(buffer, cell_count) : span<T>();
+    }
+
+    // Stops the instance (joining the async thread) before the callbacks it calls are deleted
+    void reset(){
+        if(instance != nullptr){
+            ssvl_destroy(instance);
+            delete instance;
+            instance = nullptr;
+        }
+
+        for(int callback=0; callback<CALLBACK_COUNT; callback++){
+            callbacks[callback].reset();
+        }
+    }
+
+    template<class Stored>
+    static void delete_callback(void *callback){
+        delete static_cast<Stored*>(callback);
+    }
+
+    // Copy of `callback` to keep, it's swapped in for the one it replaces once the C callback is
+    // pointed at it, so neither is deleted while the instance may call it
+    template<class Callback>
+    static kept_callback_t keep(Callback &&callback){
+        typedef typename std::decay<Callback>::type Stored;
+
+        return kept_callback_t(new Stored(std::forward<Callback>(callback)), delete_callback<Stored>);
+    }
+
+    template<class Stored>
+    static void grayscale_trampoline(void *grayscale_opaque_ptr, ssvl_camera_side side, ssvl_gray_t *grayscale_frame_buffer, uint16_t pixel_width, uint16_t pixel_height){
+        (*static_cast<Stored*>(grayscale_opaque_ptr))(side, span<const ssvl_gray_t>(grayscale_frame_buffer, (size_t)pixel_width * pixel_height), pixel_width, pixel_height);
+    }
+
+    template<class Stored>
+    static void disparity_trampoline(void *disparity_opaque_ptr, float *disparity_buffer, uint16_t disparity_width, uint16_t disparity_height){
+        (*static_cast<Stored*>(disparity_opaque_ptr))(output_span<const float>(disparity_buffer, (uint32_t)disparity_width * disparity_height), disparity_width, disparity_height);
+    }
+
+    template<class Stored>
+    static void depth_trampoline(void *depth_opaque_ptr, float *disparity_depth_buffer, uint16_t depth_width, uint16_t depth_height, float max_depth_mm){
+        (*static_cast<Stored*>(depth_opaque_ptr))(output_span<const float>(disparity_depth_buffer, (uint32_t)depth_width * depth_height), depth_width, depth_height, max_depth_mm);
+    }
+
+    template<class Stored>
+    static void depth_row_trampoline(void *depth_row_opaque_ptr, float *depth_row, uint16_t depth_row_index, uint16_t depth_width, float max_depth_mm){
+        (*static_cast<Stored*>(depth_row_opaque_ptr))(output_span<const float>(depth_row, depth_width), depth_row_index, max_depth_mm);
+    }
+
+    template<class Stored>
+    static void points_trampoline(void *points_opaque_ptr, float *points_x, float *points_y, float *points_z, uint32_t point_count){
+        (*static_cast<Stored*>(points_opaque_ptr))(span<const float>(points_x, point_count), span<const float>(points_y, point_count), span<const float>(points_z, point_count));
+    }
+};
+
+}   // namespace ssvl
+
+
+#endif  // SSVL_HPP